@@ -2,7 +2,7 @@
 // @id              common-controls-hook
 // @name            Common Controls Hook
 // @description     Force-enable Common Controls v6 visual styles for legacy Win32 applications
-// @version         1.0.2
+// @version         1.0.4
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -118,6 +118,87 @@ const std::wstring& GetV6VersionedClassName() {
     return name;
 }
 
+// Per-thread cache of whether v6 is already available in the thread's active
+// activation context, keyed by that context's handle. A reference is kept on
+// the cached handle, so that it can't be freed and reused for a different
+// context while it's cached. The cache lives in an FLS slot, whose callback
+// releases the reference when the thread exits or the mod is unloaded.
+struct CachedActCtx {
+    HANDLE hActCtx;
+    bool hasV6;
+};
+
+std::atomic<DWORD> g_cachedActCtxFlsIndex{FLS_OUT_OF_INDEXES};
+
+void WINAPI CachedActCtxFlsCallback(PVOID lpFlsData) {
+    auto* cached = static_cast<CachedActCtx*>(lpFlsData);
+    if (cached->hActCtx) {
+        ReleaseActCtx(cached->hActCtx);
+    }
+
+    delete cached;
+}
+
+// Returns whether the ambient context already maps "Button" to our v6 name.
+// Must only be called once the v6 name is known.
+bool IsV6Ambient() {
+    HANDLE hActCtx = nullptr;
+    if (!GetCurrentActCtx(&hActCtx)) {
+        const std::wstring& v6Name = GetV6VersionedClassName();
+        return !v6Name.empty() &&
+               GetActiveVersionedClassName(L"Button") == v6Name;
+    }
+
+    // Our own context is active, e.g. in a nested call from within a hook.
+    if (hActCtx && hActCtx == g_hActCtx) {
+        ReleaseActCtx(hActCtx);
+        return !GetV6VersionedClassName().empty();
+    }
+
+    DWORD flsIndex = g_cachedActCtxFlsIndex;
+    auto* cached = flsIndex != FLS_OUT_OF_INDEXES
+                       ? static_cast<CachedActCtx*>(FlsGetValue(flsIndex))
+                       : nullptr;
+
+    if (cached && hActCtx == cached->hActCtx) {
+        if (hActCtx) {
+            ReleaseActCtx(hActCtx);
+        }
+
+        return cached->hasV6;
+    }
+
+    const std::wstring& v6Name = GetV6VersionedClassName();
+    bool hasV6 =
+        !v6Name.empty() && GetActiveVersionedClassName(L"Button") == v6Name;
+
+    if (!cached && flsIndex != FLS_OUT_OF_INDEXES) {
+        cached = new CachedActCtx{};
+        if (!FlsSetValue(flsIndex, cached)) {
+            delete cached;
+            cached = nullptr;
+        }
+    }
+
+    if (!cached) {
+        if (hActCtx) {
+            ReleaseActCtx(hActCtx);
+        }
+
+        return hasV6;
+    }
+
+    // Keep the reference returned by GetCurrentActCtx for the new entry.
+    if (cached->hActCtx) {
+        ReleaseActCtx(cached->hActCtx);
+    }
+
+    cached->hActCtx = hActCtx;
+    cached->hasV6 = hasV6;
+
+    return hasV6;
+}
+
 class ActCtxGuard {
     ULONG_PTR cookie = 0;
     BOOL activated = FALSE;
@@ -133,23 +214,23 @@ class ActCtxGuard {
             return;
         }
 
-        // The versioned name the ambient context maps "Button" to. Its comctl32
-        // version tells us whether v6 is already available, in which case
-        // activating our own context is unnecessary. Skipping it avoids
-        // churning the activation stack (including on nested, re-entrant
-        // calls), which improves stability.
-        std::wstring ambient = GetActiveVersionedClassName(L"Button");
-
+        // If v6 is already available in the ambient context, activating our
+        // own context is unnecessary. Skipping it avoids churning the
+        // activation stack (including on nested, re-entrant calls), which
+        // improves stability.
         if (g_v6NameReady.load(std::memory_order_acquire)) {
             // Steady state: we already know our v6 name, so decide without
             // touching the activation stack when v6 is already active.
-            const std::wstring& v6Name = GetV6VersionedClassName();
-            if (v6Name.empty() || ambient != v6Name) {
+            if (!IsV6Ambient()) {
                 activated = ActivateActCtx(g_hActCtx, &cookie);
             }
             return;
         }
 
+        // The versioned name the ambient context maps "Button" to. Its comctl32
+        // version tells us whether v6 is already available.
+        std::wstring ambient = GetActiveVersionedClassName(L"Button");
+
         // First time: activate our context and learn the v6 name from it,
         // reusing this single activation instead of a throwaway
         // activate/deactivate pair just to read the name. Keep the activation
@@ -279,6 +360,12 @@ BOOL Wh_ModInit() {
         return FALSE;
     }
 
+    // Without the slot, the ambient context is checked on every call.
+    g_cachedActCtxFlsIndex = FlsAlloc(CachedActCtxFlsCallback);
+    if (g_cachedActCtxFlsIndex == FLS_OUT_OF_INDEXES) {
+        Wh_Log(L"FlsAlloc failed: %u", GetLastError());
+    }
+
 #define INSTALL_HOOK(name)                                         \
     do {                                                           \
         auto addr = (name##_t)GetProcAddress(hUser32, #name);      \
@@ -315,6 +402,12 @@ BOOL Wh_ModInit() {
 }
 
 void Wh_ModUninit() {
+    // Runs the callback for every thread with a cached context.
+    DWORD flsIndex = g_cachedActCtxFlsIndex.exchange(FLS_OUT_OF_INDEXES);
+    if (flsIndex != FLS_OUT_OF_INDEXES) {
+        FlsFree(flsIndex);
+    }
+
     if (g_hActCtx != INVALID_HANDLE_VALUE) {
         ReleaseActCtx(g_hActCtx);
     }
@@ -2,7 +2,7 @@
 // @id              custom-corner-radius
 // @name            Custom Window Corner Radius
 // @description     Customizes window corner radius in Windows 11, making corners more or less rounded
-// @version         1.3
+// @version         1.3.1
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -129,7 +129,6 @@ and make sure that `dwm.exe` is in the list.
 
 #include <cmath>
 #include <limits>
-#include <regex>
 #include <string>
 #include <string_view>
 #include <unordered_set>
@@ -165,13 +164,92 @@ void* IsGhostWindow_Func;
 // disabled and tooltip-specific behavior gracefully degrades.
 size_t g_windowDataHwndOffset = SIZE_MAX;
 
-// Scans the first `limit` instructions of `func` for a match against `regex`
-// and returns the value of the first capture group parsed as hex. Mirrors the
-// helper used by taskbar-button-scroll / taskbar-icon-size.
-size_t OffsetFromAssemblyRegex(void* func,
-                               size_t defValue,
-                               std::regex regex,
-                               int limit = 30) {
+// Matches a single instruction of `length` bytes at `p`. On success, stores the
+// recovered offset in `offset` and returns true.
+using InstructionMatcher_t = bool (*)(const BYTE* p,
+                                      size_t length,
+                                      size_t* offset);
+
+#if defined(_M_X64)
+// Skips an optional REX prefix and returns it, or 0 if there's none.
+BYTE X64SkipRex(const BYTE*& p, const BYTE* end) {
+    if (p < end && (*p & 0xF0) == 0x40) {
+        return *p++;
+    }
+
+    return 0;
+}
+
+// Decodes a `[base+disp]` ModR/M memory operand with a positive 8-bit or
+// 32-bit displacement. SIB and RIP-relative forms aren't supported.
+bool X64DecodeMemDisp(const BYTE* p,
+                      const BYTE* end,
+                      BYTE rex,
+                      int* baseReg,
+                      size_t* disp) {
+    if (p >= end) {
+        return false;
+    }
+
+    BYTE modrm = *p++;
+    BYTE mod = modrm >> 6;
+    BYTE rm = modrm & 7;
+    if (rm == 4 || (mod != 1 && mod != 2)) {
+        return false;
+    }
+
+    INT32 value;
+    if (mod == 1) {
+        if (end - p < 1) {
+            return false;
+        }
+
+        value = (INT8)*p;
+    } else {
+        if (end - p < 4) {
+            return false;
+        }
+
+        memcpy(&value, p, sizeof(value));
+    }
+
+    if (value <= 0) {
+        return false;
+    }
+
+    *baseReg = rm | ((rex & 1) << 3);
+    *disp = value;
+    return true;
+}
+
+bool IsRetInstruction(const BYTE* p, size_t length) {
+    return length == 1 && p[0] == 0xC3;
+}
+#elif defined(_M_ARM64)
+DWORD Arm64Instruction(const BYTE* p, size_t length) {
+    DWORD instruction = 0;
+    if (length == sizeof(instruction)) {
+        memcpy(&instruction, p, sizeof(instruction));
+    }
+
+    return instruction;
+}
+
+bool IsRetInstruction(const BYTE* p, size_t length) {
+    // ret (x30).
+    return Arm64Instruction(p, length) == 0xD65F03C0;
+}
+#else
+#error "Unsupported architecture"
+#endif
+
+// Scans the first `limit` instructions of `func` and returns the offset
+// recovered by the first instruction accepted by `matcher`. Instructions are
+// decoded from their raw bytes, the disassembler is only used for their length.
+size_t OffsetFromAssembly(void* func,
+                          size_t defValue,
+                          InstructionMatcher_t matcher,
+                          int limit = 30) {
     BYTE* p = (BYTE*)func;
     for (int i = 0; i < limit; i++) {
         WH_DISASM_RESULT result;
@@ -179,24 +257,73 @@ size_t OffsetFromAssemblyRegex(void* func,
             break;
         }
 
-        p += result.length;
+        size_t offset;
+        if (matcher(p, result.length, &offset)) {
+            return offset;
+        }
 
-        std::string_view s = result.text;
-        if (s == "ret") {
+        if (IsRetInstruction(p, result.length)) {
             break;
         }
 
-        std::match_results<std::string_view::const_iterator> match;
-        if (std::regex_match(s.begin(), s.end(), match, regex)) {
-            // Wh_Log(L"%S", result.text);
-            return std::stoull(match[1], nullptr, 16);
-        }
+        p += result.length;
     }
 
     Wh_Log(L"Failed for %p", func);
     return defValue;
 }
 
+// Same as OffsetFromAssembly, but the result is stored per module build, keyed
+// by the timestamp and image size of the module containing `func`, so that the
+// scan only runs once for each build.
+size_t OffsetFromAssemblyCached(PCWSTR cacheName,
+                                void* func,
+                                size_t defValue,
+                                InstructionMatcher_t matcher,
+                                int limit = 30) {
+    HMODULE module;
+    if (!GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                               GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           (PCWSTR)func, &module)) {
+        return OffsetFromAssembly(func, defValue, matcher, limit);
+    }
+
+    IMAGE_DOS_HEADER* dosHeader = (IMAGE_DOS_HEADER*)module;
+    IMAGE_NT_HEADERS* ntHeaders =
+        (IMAGE_NT_HEADERS*)((BYTE*)dosHeader + dosHeader->e_lfanew);
+
+    struct {
+        DWORD timeDateStamp;
+        DWORD sizeOfImage;
+        DWORD funcRva;
+        DWORD reserved;
+        ULONGLONG offset;
+    } entry{}, cachedEntry{};
+
+    entry.timeDateStamp = ntHeaders->FileHeader.TimeDateStamp;
+    entry.sizeOfImage = ntHeaders->OptionalHeader.SizeOfImage;
+    entry.funcRva = (DWORD)((BYTE*)func - (BYTE*)module);
+
+    WCHAR valueName[64];
+    swprintf_s(valueName, L"offsetCache_%s", cacheName);
+
+    if (Wh_GetBinaryValue(valueName, &cachedEntry, sizeof(cachedEntry)) ==
+            sizeof(cachedEntry) &&
+        cachedEntry.timeDateStamp == entry.timeDateStamp &&
+        cachedEntry.sizeOfImage == entry.sizeOfImage &&
+        cachedEntry.funcRva == entry.funcRva) {
+        return (size_t)cachedEntry.offset;
+    }
+
+    size_t offset = OffsetFromAssembly(func, defValue, matcher, limit);
+    if (offset != defValue) {
+        entry.offset = offset;
+        Wh_SetBinaryValue(valueName, &entry, sizeof(entry));
+    }
+
+    return offset;
+}
+
 HWND HwndFromTopLevelWindow(void* pThis) {
     if (g_windowDataHwndOffset == SIZE_MAX || !GetWindowData_Original) {
         return nullptr;
@@ -850,17 +977,36 @@ BOOL Wh_ModInit() {
     // HWND member - the destination register is left unconstrained because
     // compilers may stage the value through a scratch register first.
     if (IsGhostWindow_Func) {
-        g_windowDataHwndOffset = OffsetFromAssemblyRegex(
-            IsGhostWindow_Func, SIZE_MAX,
+        g_windowDataHwndOffset = OffsetFromAssemblyCached(
+            L"CWindowData_Hwnd", IsGhostWindow_Func, SIZE_MAX,
+            [](const BYTE* p, size_t length, size_t* offset) {
 #if defined(_M_X64)
-            std::regex(R"(mov \w+, \[rcx\+0x([0-9a-f]+)\])",
-                       std::regex_constants::icase),
+                // mov r64, qword ptr [rcx+disp]
+                const BYTE* end = p + length;
+                BYTE rex = X64SkipRex(p, end);
+                if (!(rex & 8) || p == end || *p != 0x8B) {
+                    return false;
+                }
+
+                int baseReg;
+                return X64DecodeMemDisp(p + 1, end, rex, &baseReg, offset) &&
+                       baseReg == 1;
 #elif defined(_M_ARM64)
-            std::regex(R"(ldr\s+\w+, \[x0, #0x([0-9a-f]+)\])",
-                       std::regex_constants::icase),
+                // ldr x/w, [x0, #imm]
+                DWORD instruction = Arm64Instruction(p, length);
+                if ((instruction & 0xFFC003E0) == 0xF9400000) {
+                    *offset = ((instruction >> 10) & 0xFFF) * 8;
+                } else if ((instruction & 0xFFC003E0) == 0xB9400000) {
+                    *offset = ((instruction >> 10) & 0xFFF) * 4;
+                } else {
+                    return false;
+                }
+
+                return *offset != 0;
 #else
 #error "Unsupported architecture"
 #endif
+            },
             10);
         Wh_Log(L"windowDataHwndOffset=0x%zx", g_windowDataHwndOffset);
     } else {
@@ -2,7 +2,7 @@
 // @id              explorer-folder-hover-menu
 // @name            Folder Hover Menu
 // @description     Hover a folder in File Explorer to get an expand button that opens a cascading menu of the folder's contents
-// @version         1.3
+// @version         1.3.5
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -92,6 +92,12 @@ Inspired by [QTTabBar](https://qttabbar.wikidot.com/).
   - systemDefault: Use the File Explorer settings
   - hide: Never show
   - show: Always show
+- prefetch: true
+  $name: Preload folder contents
+  $description: >-
+    Load the contents of the hovered folder in the background as soon as the
+    expand button is shown, so that the menu opens instantly. Mostly helps with
+    network folders and large folders.
 - maxItems: 200
   $name: Maximum items
   $description: >-
@@ -126,7 +132,9 @@ Inspired by [QTTabBar](https://qttabbar.wikidot.com/).
 
 #include <winrt/base.h>
 
+#include <algorithm>
 #include <climits>
+#include <list>
 #include <new>
 #include <string>
 #include <unordered_map>
@@ -169,6 +177,13 @@ DEFINE_GUID(CLSID_MenuDeskBar,
 // which the worker takes ownership of). Done off the UI thread because some
 // actions (notably opening a new tab) wait on Explorer.
 #define WM_APP_DO_ACTION (WM_APP + 5)
+// UI -> prefetch thread: prefetch a folder listing (wParam is a
+// PrefetchRequest*, which the prefetch thread takes ownership of).
+#define WM_APP_DO_PREFETCH (WM_APP + 6)
+// Shell change notifications for cached folder listings, posted to the sink
+// window. Each cache entry gets a distinct message from the range starting
+// here, kMaxCachedListings long (see BeginFolderListing).
+#define WM_APP_LISTING_CHANGED (WM_APP + 16)
 
 ////////////////////////////////////////////////////////////////////////////////
 // Settings.
@@ -207,6 +222,7 @@ struct {
     FolderAction middleClickAction;
     bool fileDialogs;
     ShowHidden showHidden;
+    bool prefetch;
     int maxEnumItems;
     int enumTimeoutMs;
 } g_settings;
@@ -276,6 +292,8 @@ void LoadSettings() {
     }
     Wh_FreeStringSetting(showHidden);
 
+    g_settings.prefetch = Wh_GetIntSetting(L"prefetch");
+
     int maxItems = Wh_GetIntSetting(L"maxItems");
     if (maxItems < 1) {
         maxItems = 1;
@@ -335,10 +353,18 @@ HANDLE g_workerReadyEvent;
 [[clang::no_destroy]] winrt::com_ptr<IUIAutomationElement> g_workerContainer;
 HWND g_workerContainerTab;           // Worker thread only: the tab the
                                      // cached container belongs to.
+bool g_workerContainerSubscribed;    // Worker thread only: whether change
+                                     // events of the container are handled.
 PIDLIST_ABSOLUTE g_workerFolderAbs;  // Worker thread only: the folder
 bool g_workerFolderIsDesktop;        // the shared children map holds.
 bool g_workerChildrenValid;
 
+// Background thread (its own STA) that fills the folder listing cache the menu
+// is served from (see PrefetchThreadProc).
+HANDLE g_prefetchThread;
+DWORD g_prefetchThreadId;
+HANDLE g_prefetchReadyEvent;
+
 // True while a File Explorer window or the desktop is the foreground window.
 // Raw input is ignored otherwise, so the mod does no work for other apps.
 bool g_active;
@@ -362,6 +388,13 @@ bool g_targetIsDialog;
 // rebuild. This is not a timer; it only gates work done on actual input events.
 constexpr ULONGLONG kRefreshTtlMs = 500;
 
+// The same, for a snapshot whose container reports its changes through UI
+// Automation events (see CContainerChangeHandler). Such a snapshot is rebuilt
+// once an event marks it dirty, but no sooner than kRefreshTtlMs after the
+// previous build, so this is only a safety net for changes the provider raises
+// no event for.
+constexpr ULONGLONG kEventDrivenRefreshTtlMs = 3000;
+
 // Raw input is high frequency; coalesce moves to roughly this interval (ms).
 constexpr ULONGLONG kInputCoalesceMs = 10;
 ULONGLONG g_lastInputTick;
@@ -389,12 +422,33 @@ constexpr int kDialogActivateMaxPolls = 30;
 HWND g_dialogActivatePending;
 int g_dialogActivatePollsLeft;
 
-// One visible item in the active view: its rectangle (screen coords) and name.
+// One visible item in the active view: its rectangle (screen coords) and name,
+// lowercased once at build time so it can be looked up in g_snapChildren as is.
 struct CachedItem {
     RECT rect;
-    std::wstring name;
+    std::wstring key;
+};
+
+// Uniform grid over the snapshot's item rectangles, so that a hit-test only
+// checks the items overlapping the cell under the point instead of scanning all
+// of them. Cells are sized like an average item, so in every view mode an item
+// covers only a few cells. See BuildItemGrid.
+struct ItemGrid {
+    RECT bounds;
+    LONG cellWidth;
+    LONG cellHeight;
+    int columns;  // 0 if there are no items.
+    int rows;
+    // columns * rows + 1 offsets into cellItems: the items of cell c are
+    // cellItems[cellStart[c]] up to cellItems[cellStart[c + 1]], exclusive, in
+    // ascending item order.
+    std::vector<UINT> cellStart;
+    std::vector<UINT> cellItems;
 };
 
+// Upper bound on the grid size; cells are enlarged until the grid fits.
+constexpr LONGLONG kMaxItemGridCells = 64 * 1024;
+
 // Snapshot shared between the worker (producer) and the UI thread (consumer),
 // guarded by g_snapshotLock. The UI thread hit-tests it locally; the worker
 // rebuilds it off-thread on request.
@@ -403,8 +457,13 @@ bool g_snapValid;
 HWND g_snapTab;  // The tab (see GetExplorerTabWindow) the snapshot holds.
 bool g_snapIsDesktop;
 std::vector<CachedItem> g_snapItems;
+ItemGrid g_snapGrid;  // Spatial index of g_snapItems.
 LONG g_snapNameColumnRight;  // Right edge of the name column, 0 if none.
 ULONGLONG g_snapBuiltTick;
+// Whether the container's change events are subscribed to, and whether one has
+// fired since the snapshot build started (set from UI Automation threads).
+bool g_snapEventDriven;
+bool g_snapDirty;
 // Child folder display name (lowercased) -> target absolute pidl. Rebuilt only
 // when the folder changes; owned here (freed on rebuild and shutdown).
 std::unordered_map<std::wstring, PIDLIST_ABSOLUTE> g_snapChildren;
@@ -448,6 +507,117 @@ std::wstring ToLower(const std::wstring& s) {
     return r;
 }
 
+// Builds the spatial index of `items` into `grid`. Items with an empty
+// rectangle (not realized by a virtualized view) are left out, as a point can
+// never be inside them. Worker thread only.
+void BuildItemGrid(const std::vector<CachedItem>& items, ItemGrid& grid) {
+    grid.columns = 0;
+    grid.rows = 0;
+    grid.cellStart.clear();
+    grid.cellItems.clear();
+
+    RECT bounds = {LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN};
+    LONGLONG totalWidth = 0;
+    LONGLONG totalHeight = 0;
+    LONGLONG count = 0;
+    for (const CachedItem& item : items) {
+        const RECT& r = item.rect;
+        if (r.right <= r.left || r.bottom <= r.top) {
+            continue;
+        }
+        bounds.left = std::min(bounds.left, r.left);
+        bounds.top = std::min(bounds.top, r.top);
+        bounds.right = std::max(bounds.right, r.right);
+        bounds.bottom = std::max(bounds.bottom, r.bottom);
+        totalWidth += r.right - r.left;
+        totalHeight += r.bottom - r.top;
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    LONG cellWidth = (LONG)std::max(totalWidth / count, 1LL);
+    LONG cellHeight = (LONG)std::max(totalHeight / count, 1LL);
+    LONGLONG columns;
+    LONGLONG rows;
+    while (true) {
+        columns = ((LONGLONG)bounds.right - bounds.left + cellWidth - 1) /
+                  cellWidth;
+        rows = ((LONGLONG)bounds.bottom - bounds.top + cellHeight - 1) /
+               cellHeight;
+        if (columns * rows <= kMaxItemGridCells) {
+            break;
+        }
+        cellWidth *= 2;
+        cellHeight *= 2;
+    }
+
+    grid.bounds = bounds;
+    grid.cellWidth = cellWidth;
+    grid.cellHeight = cellHeight;
+    grid.columns = (int)columns;
+    grid.rows = (int)rows;
+
+    // Calls fn(cell) for every cell the rectangle overlaps.
+    auto forEachCell = [&grid](const RECT& r, auto fn) {
+        int firstColumn = (r.left - grid.bounds.left) / grid.cellWidth;
+        int lastColumn = (r.right - 1 - grid.bounds.left) / grid.cellWidth;
+        int firstRow = (r.top - grid.bounds.top) / grid.cellHeight;
+        int lastRow = (r.bottom - 1 - grid.bounds.top) / grid.cellHeight;
+        for (int row = firstRow; row <= lastRow; row++) {
+            for (int column = firstColumn; column <= lastColumn; column++) {
+                fn(row * grid.columns + column);
+            }
+        }
+    };
+
+    // Count the items per cell, turn the counts into offsets, then fill the
+    // cells in item order.
+    grid.cellStart.assign(columns * rows + 1, 0);
+    for (const CachedItem& item : items) {
+        const RECT& r = item.rect;
+        if (r.right > r.left && r.bottom > r.top) {
+            forEachCell(r, [&grid](int cell) { grid.cellStart[cell + 1]++; });
+        }
+    }
+    for (size_t i = 1; i < grid.cellStart.size(); i++) {
+        grid.cellStart[i] += grid.cellStart[i - 1];
+    }
+
+    grid.cellItems.resize(grid.cellStart.back());
+    std::vector<UINT> next(grid.cellStart.begin(), grid.cellStart.end() - 1);
+    for (UINT i = 0; i < (UINT)items.size(); i++) {
+        const RECT& r = items[i].rect;
+        if (r.right > r.left && r.bottom > r.top) {
+            forEachCell(r, [&grid, &next, i](int cell) {
+                grid.cellItems[next[cell]++] = i;
+            });
+        }
+    }
+}
+
+// Returns the indices of the items whose rectangles may contain `pt`, in
+// ascending order, as the [*outFirst, *outLast) range.
+void ItemGridCandidates(const ItemGrid& grid,
+                        POINT pt,
+                        const UINT** outFirst,
+                        const UINT** outLast) {
+    *outFirst = nullptr;
+    *outLast = nullptr;
+    if (grid.columns == 0 || pt.x < grid.bounds.left ||
+        pt.x >= grid.bounds.right || pt.y < grid.bounds.top ||
+        pt.y >= grid.bounds.bottom) {
+        return;
+    }
+
+    int column = (pt.x - grid.bounds.left) / grid.cellWidth;
+    int row = (pt.y - grid.bounds.top) / grid.cellHeight;
+    int cell = row * grid.columns + column;
+    *outFirst = grid.cellItems.data() + grid.cellStart[cell];
+    *outLast = grid.cellItems.data() + grid.cellStart[cell + 1];
+}
+
 bool IsLightTheme() {
     DWORD value = 1;
     DWORD size = sizeof(value);
@@ -857,6 +1027,119 @@ winrt::com_ptr<IUIAutomationElement> FindContainerFromPoint(POINT pt) {
     return FindContainerFromWindow(WindowFromPoint(pt));
 }
 
+// Marks the snapshot dirty when the items container reports a change: a
+// structure change (items added, removed or reordered, a view mode change or a
+// navigation), or the container itself being scrolled, moved or resized.
+// UI Automation calls it on its own threads, so it only sets a flag under the
+// lock; the next input event then requests a rebuild, at most once per
+// kRefreshTtlMs.
+class CContainerChangeHandler final
+    : public IUIAutomationStructureChangedEventHandler,
+      public IUIAutomationPropertyChangedEventHandler {
+   public:
+    IFACEMETHODIMP QueryInterface(REFIID riid, void** ppv) override {
+        if (!ppv) {
+            return E_POINTER;
+        }
+        if (IsEqualIID(riid, IID_IUnknown) ||
+            IsEqualIID(riid,
+                       __uuidof(IUIAutomationStructureChangedEventHandler))) {
+            *ppv =
+                static_cast<IUIAutomationStructureChangedEventHandler*>(this);
+            AddRef();
+            return S_OK;
+        }
+        if (IsEqualIID(riid,
+                       __uuidof(IUIAutomationPropertyChangedEventHandler))) {
+            *ppv = static_cast<IUIAutomationPropertyChangedEventHandler*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    IFACEMETHODIMP_(ULONG) AddRef() override {
+        return InterlockedIncrement(&m_ref);
+    }
+
+    IFACEMETHODIMP_(ULONG) Release() override {
+        LONG ref = InterlockedDecrement(&m_ref);
+        if (ref == 0) {
+            delete this;
+        }
+        return ref;
+    }
+
+    IFACEMETHODIMP HandleStructureChangedEvent(IUIAutomationElement* sender,
+                                               StructureChangeType changeType,
+                                               SAFEARRAY* runtimeId) override {
+        MarkDirty();
+        return S_OK;
+    }
+
+    IFACEMETHODIMP HandlePropertyChangedEvent(IUIAutomationElement* sender,
+                                              PROPERTYID propertyId,
+                                              VARIANT newValue) override {
+        MarkDirty();
+        return S_OK;
+    }
+
+   private:
+    static void MarkDirty() {
+        EnterCriticalSection(&g_snapshotLock);
+        g_snapDirty = true;
+        LeaveCriticalSection(&g_snapshotLock);
+    }
+
+    LONG m_ref = 1;
+};
+
+// Replaces the cached items container, moving the change event subscription
+// (see CContainerChangeHandler) over to the new one. If subscribing fails the
+// snapshot falls back to being rebuilt on kRefreshTtlMs expiry. Worker thread
+// only.
+void WorkerSetContainer(winrt::com_ptr<IUIAutomationElement> container,
+                        HWND tab) {
+    if (g_workerContainerSubscribed) {
+        g_workerUia->RemoveAllEventHandlers();
+        g_workerContainerSubscribed = false;
+    }
+
+    g_workerContainer = std::move(container);
+    g_workerContainerTab = g_workerContainer ? tab : nullptr;
+    if (!g_workerContainer) {
+        return;
+    }
+
+    // Property changes are subscribed to on the container only: over its
+    // subtree, a scroll or a re-layout raises an event for every visible item.
+    // The items moving within the container shows up as a scroll position
+    // change of the container, or as a structure change when the view adds or
+    // removes items.
+    auto* handler = new CContainerChangeHandler();
+    PROPERTYID properties[] = {
+        UIA_BoundingRectanglePropertyId,
+        UIA_ScrollHorizontalScrollPercentPropertyId,
+        UIA_ScrollVerticalScrollPercentPropertyId,
+    };
+    HRESULT hr = g_workerUia->AddStructureChangedEventHandler(
+        g_workerContainer.get(), TreeScope_Subtree, nullptr, handler);
+    if (SUCCEEDED(hr)) {
+        hr = g_workerUia->AddPropertyChangedEventHandlerNativeArray(
+            g_workerContainer.get(), TreeScope_Element, nullptr, handler,
+            properties, ARRAYSIZE(properties));
+    }
+    handler->Release();
+
+    if (SUCCEEDED(hr)) {
+        g_workerContainerSubscribed = true;
+    } else {
+        Wh_Log(L"Subscribing to container events failed, hr=0x%08X", hr);
+        g_workerUia->RemoveAllEventHandlers();
+    }
+}
+
 // In a columned view (Details or List) the row's children are the cells laid
 // out side by side. From the first row's cached cells, work out the right edge
 // of the name column so the button can be placed next to the file name. Leaves
@@ -947,7 +1230,8 @@ void WorkerBuildItems(std::vector<CachedItem>& items, LONG& nameColumnRight) {
                 if (SUCCEEDED(row->get_CachedBoundingRectangle(&r)) &&
                     SUCCEEDED(row->get_CachedName(name.GetAddress())) &&
                     name.length() > 0) {
-                    items.push_back({r, std::wstring(name, name.length())});
+                    items.push_back(
+                        {r, ToLower(std::wstring(name, name.length()))});
                     if (!firstDone) {
                         ComputeNameColumn(row.get(), r, &nameColumnRight);
                         firstDone = true;
@@ -1510,6 +1794,12 @@ bool EnsureWorkerUia() {
 void WorkerBuildSnapshot(HWND tab, bool isDesktop, POINT pt) {
     ULONGLONG tick = GetTickCount64();
 
+    // Cleared before reading the items, so that a change made while they are
+    // being read marks the new snapshot dirty again.
+    EnterCriticalSection(&g_snapshotLock);
+    g_snapDirty = false;
+    LeaveCriticalSection(&g_snapshotLock);
+
     winrt::com_ptr<IShellFolder> folder;
     PIDLIST_ABSOLUTE folderAbs = nullptr;
     if (isDesktop) {
@@ -1525,7 +1815,9 @@ void WorkerBuildSnapshot(HWND tab, bool isDesktop, POINT pt) {
         // re-requesting on every move.
         EnterCriticalSection(&g_snapshotLock);
         g_snapItems.clear();
+        g_snapGrid = {};
         g_snapNameColumnRight = 0;
+        g_snapEventDriven = false;
         g_snapTab = tab;
         g_snapIsDesktop = isDesktop;
         g_snapBuiltTick = tick;
@@ -1542,8 +1834,7 @@ void WorkerBuildSnapshot(HWND tab, bool isDesktop, POINT pt) {
 
     // (Re)acquire the list element when the tab changed.
     if (tab != g_workerContainerTab || !g_workerContainer) {
-        g_workerContainer = FindContainerFromPoint(pt);
-        g_workerContainerTab = g_workerContainer ? tab : nullptr;
+        WorkerSetContainer(FindContainerFromPoint(pt), tab);
     }
 
     std::vector<CachedItem> items;
@@ -1555,12 +1846,14 @@ void WorkerBuildSnapshot(HWND tab, bool isDesktop, POINT pt) {
     if (items.empty()) {
         auto container = FindContainerFromPoint(pt);
         if (container) {
-            g_workerContainer = std::move(container);
-            g_workerContainerTab = tab;
+            WorkerSetContainer(std::move(container), tab);
             WorkerBuildItems(items, nameColumnRight);
         }
     }
 
+    ItemGrid grid;
+    BuildItemGrid(items, grid);
+
     std::unordered_map<std::wstring, PIDLIST_ABSOLUTE> children;
     bool rebuiltChildren = false;
     if (folderChanged) {
@@ -1572,7 +1865,9 @@ void WorkerBuildSnapshot(HWND tab, bool isDesktop, POINT pt) {
     // local temporaries and is destroyed/freed below, outside the lock.
     EnterCriticalSection(&g_snapshotLock);
     g_snapItems.swap(items);
+    std::swap(g_snapGrid, grid);
     g_snapNameColumnRight = nameColumnRight;
+    g_snapEventDriven = g_workerContainerSubscribed;
     g_snapTab = tab;
     g_snapIsDesktop = isDesktop;
     g_snapBuiltTick = tick;
@@ -2019,6 +2314,10 @@ DWORD WINAPI WorkerThreadProc(LPVOID param) {
         DispatchMessage(&msg);
     }
 
+    if (g_workerContainerSubscribed) {
+        g_workerUia->RemoveAllEventHandlers();
+        g_workerContainerSubscribed = false;
+    }
     g_workerContainer = nullptr;
     g_workerUia = nullptr;
     if (g_workerFolderAbs) {
@@ -2197,6 +2496,421 @@ class CTimeoutEnumIDList final : public IEnumIDList {
     UINT m_count = 0;  // Real items returned so far (for the item-count cap).
 };
 
+////////////////////////////////////////////////////////////////////////////////
+// Folder listing cache. Opening a menu makes the band enumerate the folder
+// synchronously, which for a network share or a large folder takes until the
+// budgets above run out. So once the button is shown for a folder, the
+// prefetch thread (see PrefetchThreadProc) enumerates it, and speculatively a
+// few of its sub-folders, into a small LRU cache, and the EnumObjects hook
+// serves the band's enumeration from there. An entry is dropped on a shell
+// change notification for its folder, and expires after kListingCacheTtlMs as
+// a safety net for folders that don't report changes (some network shares).
+// Only file-system folders are cached: their item ids are self-contained, so
+// ids enumerated from one folder instance are valid for the band's.
+
+constexpr size_t kMaxCachedListings = 32;
+constexpr ULONGLONG kListingCacheTtlMs = 30000;
+
+// How many sub-folders of a prefetched folder are prefetched too, for when the
+// menu is cascaded into them.
+constexpr size_t kMaxSpeculativePrefetches = 4;
+
+struct FolderListing {
+    PIDLIST_ABSOLUTE folderAbs;
+    SHCONTF flags;  // The enumeration flags the listing was made with.
+    std::vector<PITEMID_CHILD> children;
+    // Whether the enumeration stopped at one of the budgets, in which case the
+    // notice item is served after the children, just like the band would have
+    // got it from CTimeoutEnumIDList.
+    bool truncated;
+    ULONGLONG builtTick;
+    // The change notification registration, and the message it posts to the
+    // sink window - a distinct one per entry, so that the notification tells
+    // which entry went stale.
+    ULONG notifyId;
+    UINT notifyMsg;
+    // Set while the folder is being enumerated. The entry is registered for
+    // change notifications before the enumeration starts, so that a change
+    // during the enumeration drops the entry, and with it the result.
+    bool pending;
+};
+
+// Most recently used first. Guarded by g_listingCacheLock: looked up by the
+// EnumObjects hook on the band's thread, filled by the prefetch thread and
+// invalidated on the UI thread.
+CRITICAL_SECTION g_listingCacheLock;
+std::list<FolderListing> g_listingCache;
+
+void FreeFolderListing(FolderListing& listing) {
+    if (listing.notifyId) {
+        SHChangeNotifyDeregister(listing.notifyId);
+    }
+    for (PITEMID_CHILD child : listing.children) {
+        ILFree(child);
+    }
+    ILFree(listing.folderAbs);
+}
+
+// Compares the pidl bytes. Unlike ILIsEqual it doesn't call into the shell,
+// so it's safe under the cache lock; a pidl of the same folder which differs
+// in its bytes only makes for a cache miss.
+bool IsSamePidl(PCIDLIST_ABSOLUTE a, PCIDLIST_ABSOLUTE b) {
+    UINT size = ILGetSize(a);
+    return size == ILGetSize(b) && memcmp(a, b, size) == 0;
+}
+
+// Whether a listing of the folder made with `flags` is cached and fresh.
+bool HasFolderListing(PCIDLIST_ABSOLUTE folderAbs, SHCONTF flags) {
+    ULONGLONG now = GetTickCount64();
+    bool found = false;
+    EnterCriticalSection(&g_listingCacheLock);
+    for (const FolderListing& listing : g_listingCache) {
+        if (!listing.pending && listing.flags == flags &&
+            IsSamePidl(listing.folderAbs, folderAbs)) {
+            found = now - listing.builtTick <= kListingCacheTtlMs;
+            break;
+        }
+    }
+    LeaveCriticalSection(&g_listingCacheLock);
+    return found;
+}
+
+// Copies the children of the cached listing of the folder made with `flags`
+// into `out` (the caller owns the copies) and marks it as recently used.
+// Returns false if there's no fresh listing.
+bool CopyFolderListing(PCIDLIST_ABSOLUTE folderAbs,
+                       SHCONTF flags,
+                       std::vector<PITEMID_CHILD>& out,
+                       bool* outTruncated) {
+    ULONGLONG now = GetTickCount64();
+    bool found = false;
+    EnterCriticalSection(&g_listingCacheLock);
+    for (auto it = g_listingCache.begin(); it != g_listingCache.end(); ++it) {
+        if (it->pending || it->flags != flags ||
+            !IsSamePidl(it->folderAbs, folderAbs)) {
+            continue;
+        }
+        if (now - it->builtTick <= kListingCacheTtlMs) {
+            out.reserve(it->children.size());
+            for (PITEMID_CHILD child : it->children) {
+                if (PITEMID_CHILD copy = (PITEMID_CHILD)ILClone(child)) {
+                    out.push_back(copy);
+                }
+            }
+            *outTruncated = it->truncated;
+            g_listingCache.splice(g_listingCache.begin(), g_listingCache, it);
+            found = true;
+        }
+        break;
+    }
+    LeaveCriticalSection(&g_listingCacheLock);
+    return found;
+}
+
+// Adds a pending listing of the folder (taking ownership of `folderAbs`) as
+// the most recently used one, replacing an older listing of the same folder and
+// evicting the least recently used ones beyond kMaxCachedListings, and
+// registers for change notifications of its folder. Returns the entry's
+// message, which identifies it for FinishFolderListing. Prefetch thread only:
+// as the only thread which adds listings, the message picked under the lock
+// stays free after it's released, so the registration can be made outside of
+// the lock.
+UINT BeginFolderListing(PIDLIST_ABSOLUTE folderAbs, SHCONTF flags) {
+    std::list<FolderListing> dropped;
+
+    FolderListing listing{};
+    listing.folderAbs = folderAbs;
+    listing.flags = flags;
+    listing.pending = true;
+
+    EnterCriticalSection(&g_listingCacheLock);
+    for (auto it = g_listingCache.begin(); it != g_listingCache.end();) {
+        auto next = std::next(it);
+        if (it->flags == flags && IsSamePidl(it->folderAbs, folderAbs)) {
+            dropped.splice(dropped.end(), g_listingCache, it);
+        }
+        it = next;
+    }
+    while (g_listingCache.size() >= kMaxCachedListings) {
+        dropped.splice(dropped.end(), g_listingCache,
+                       std::prev(g_listingCache.end()));
+    }
+
+    // At most kMaxCachedListings - 1 entries remain, so a free message is
+    // always found.
+    listing.notifyMsg = WM_APP_LISTING_CHANGED;
+    while (std::any_of(g_listingCache.begin(), g_listingCache.end(),
+                       [&listing](const FolderListing& entry) {
+                           return entry.notifyMsg == listing.notifyMsg;
+                       })) {
+        listing.notifyMsg++;
+    }
+
+    UINT notifyMsg = listing.notifyMsg;
+    g_listingCache.push_front(std::move(listing));
+    LeaveCriticalSection(&g_listingCacheLock);
+
+    for (FolderListing& old : dropped) {
+        FreeFolderListing(old);
+    }
+
+    SHChangeNotifyEntry entry = {folderAbs, FALSE};
+    ULONG notifyId = SHChangeNotifyRegister(
+        g_sinkWnd,
+        SHCNRF_ShellLevel | SHCNRF_InterruptLevel | SHCNRF_NewDelivery,
+        SHCNE_CREATE | SHCNE_DELETE | SHCNE_MKDIR | SHCNE_RMDIR |
+            SHCNE_RENAMEITEM | SHCNE_RENAMEFOLDER | SHCNE_ATTRIBUTES |
+            SHCNE_UPDATEDIR,
+        notifyMsg, 1, &entry);
+
+    // The entry might have been dropped by a change notification meanwhile,
+    // in which case the registration is no longer needed.
+    bool stored = false;
+    EnterCriticalSection(&g_listingCacheLock);
+    for (FolderListing& cached : g_listingCache) {
+        if (cached.pending && cached.notifyMsg == notifyMsg) {
+            cached.notifyId = notifyId;
+            stored = true;
+            break;
+        }
+    }
+    LeaveCriticalSection(&g_listingCacheLock);
+
+    if (!stored && notifyId) {
+        SHChangeNotifyDeregister(notifyId);
+    }
+
+    return notifyMsg;
+}
+
+// Completes the pending listing added by BeginFolderListing, taking ownership
+// of the children. If the entry was dropped during the enumeration, e.g. since
+// the folder changed, the children are freed instead of being cached. Prefetch
+// thread only.
+void FinishFolderListing(UINT notifyMsg,
+                         std::vector<PITEMID_CHILD> children,
+                         bool truncated) {
+    bool stored = false;
+
+    EnterCriticalSection(&g_listingCacheLock);
+    for (auto it = g_listingCache.begin(); it != g_listingCache.end(); ++it) {
+        if (it->pending && it->notifyMsg == notifyMsg) {
+            it->children = std::move(children);
+            it->truncated = truncated;
+            it->builtTick = GetTickCount64();
+            it->pending = false;
+            stored = true;
+            break;
+        }
+    }
+    LeaveCriticalSection(&g_listingCacheLock);
+
+    if (!stored) {
+        Wh_Log(L"Folder changed during prefetching, discarding the listing");
+        for (PITEMID_CHILD child : children) {
+            ILFree(child);
+        }
+    }
+}
+
+// Drops the listing whose change notifications are posted as `notifyMsg`.
+// UI thread only (the sink window receives the notifications).
+void InvalidateFolderListing(UINT notifyMsg) {
+    std::list<FolderListing> dropped;
+
+    EnterCriticalSection(&g_listingCacheLock);
+    for (auto it = g_listingCache.begin(); it != g_listingCache.end(); ++it) {
+        if (it->notifyMsg == notifyMsg) {
+            dropped.splice(dropped.end(), g_listingCache, it);
+            break;
+        }
+    }
+    LeaveCriticalSection(&g_listingCacheLock);
+
+    for (FolderListing& old : dropped) {
+        FreeFolderListing(old);
+    }
+}
+
+// Drops the pending listing added by BeginFolderListing, if it's still cached.
+// Prefetch thread only.
+void AbandonFolderListing(UINT notifyMsg) {
+    std::list<FolderListing> dropped;
+
+    EnterCriticalSection(&g_listingCacheLock);
+    for (auto it = g_listingCache.begin(); it != g_listingCache.end(); ++it) {
+        if (it->pending && it->notifyMsg == notifyMsg) {
+            dropped.splice(dropped.end(), g_listingCache, it);
+            break;
+        }
+    }
+    LeaveCriticalSection(&g_listingCacheLock);
+
+    for (FolderListing& old : dropped) {
+        FreeFolderListing(old);
+    }
+}
+
+void ClearFolderListings() {
+    std::list<FolderListing> dropped;
+
+    EnterCriticalSection(&g_listingCacheLock);
+    dropped.swap(g_listingCache);
+    LeaveCriticalSection(&g_listingCacheLock);
+
+    for (FolderListing& old : dropped) {
+        FreeFolderListing(old);
+    }
+}
+
+// Serves a cached listing to the band: copies of the children, then the notice
+// item if the listing was truncated.
+class CCachedEnumIDList final : public IEnumIDList {
+   public:
+    CCachedEnumIDList(std::vector<PITEMID_CHILD> children, bool truncated)
+        : m_children(std::move(children)), m_truncated(truncated) {}
+
+    // IUnknown.
+    IFACEMETHODIMP QueryInterface(REFIID riid, void** ppv) override {
+        if (!ppv) {
+            return E_POINTER;
+        }
+        if (IsEqualIID(riid, IID_IUnknown) ||
+            IsEqualIID(riid, IID_IEnumIDList)) {
+            *ppv = static_cast<IEnumIDList*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    IFACEMETHODIMP_(ULONG) AddRef() override {
+        return InterlockedIncrement(&m_ref);
+    }
+
+    IFACEMETHODIMP_(ULONG) Release() override {
+        LONG ref = InterlockedDecrement(&m_ref);
+        if (ref == 0) {
+            delete this;
+        }
+        return ref;
+    }
+
+    // IEnumIDList.
+    IFACEMETHODIMP Next(ULONG celt,
+                        LPITEMIDLIST* rgelt,
+                        ULONG* pceltFetched) override {
+        if (pceltFetched) {
+            *pceltFetched = 0;
+        }
+        if (celt == 0) {
+            return S_OK;
+        }
+        if (!rgelt) {
+            return E_INVALIDARG;
+        }
+
+        ULONG fetched = 0;
+        while (fetched < celt) {
+            LPITEMIDLIST pidl;
+            if (m_pos < m_children.size()) {
+                pidl = ILClone(m_children[m_pos]);
+            } else if (m_pos == m_children.size() && m_truncated) {
+                pidl = CreateTimeoutPidl();
+            } else {
+                break;
+            }
+            if (!pidl) {
+                break;
+            }
+            rgelt[fetched++] = pidl;
+            m_pos++;
+        }
+
+        if (pceltFetched) {
+            *pceltFetched = fetched;
+        }
+        return fetched == celt ? S_OK : S_FALSE;
+    }
+
+    IFACEMETHODIMP Skip(ULONG celt) override {
+        size_t end = m_children.size() + (m_truncated ? 1 : 0);
+        size_t left = end - m_pos;
+        m_pos += std::min<size_t>(celt, left);
+        return celt <= left ? S_OK : S_FALSE;
+    }
+
+    IFACEMETHODIMP Reset() override {
+        m_pos = 0;
+        return S_OK;
+    }
+
+    IFACEMETHODIMP Clone(IEnumIDList** ppenum) override {
+        if (!ppenum) {
+            return E_POINTER;
+        }
+        *ppenum = nullptr;
+        std::vector<PITEMID_CHILD> children;
+        children.reserve(m_children.size());
+        for (PITEMID_CHILD child : m_children) {
+            if (PITEMID_CHILD copy = (PITEMID_CHILD)ILClone(child)) {
+                children.push_back(copy);
+            }
+        }
+        auto* clone = new (std::nothrow)
+            CCachedEnumIDList(std::move(children), m_truncated);
+        if (!clone) {
+            return E_OUTOFMEMORY;
+        }
+        clone->m_pos = m_pos;
+        *ppenum = clone;
+        return S_OK;
+    }
+
+   private:
+    ~CCachedEnumIDList() {
+        for (PITEMID_CHILD child : m_children) {
+            ILFree(child);
+        }
+    }
+
+    LONG m_ref = 1;
+    std::vector<PITEMID_CHILD> m_children;
+    bool m_truncated;
+    size_t m_pos = 0;
+};
+
+// Returns an enumerator over the cached listing of `folder` made with `flags`,
+// or nullptr on a cache miss.
+IEnumIDList* CreateCachedEnumerator(IShellFolder* folder, SHCONTF flags) {
+    PIDLIST_ABSOLUTE folderAbs = nullptr;
+    if (FAILED(SHGetIDListFromObject(folder, &folderAbs)) || !folderAbs) {
+        return nullptr;
+    }
+
+    std::vector<PITEMID_CHILD> children;
+    bool truncated = false;
+    bool found = CopyFolderListing(folderAbs, flags, children, &truncated);
+    ILFree(folderAbs);
+    if (!found) {
+        return nullptr;
+    }
+
+    size_t count = children.size();
+    auto* enumerator =
+        new (std::nothrow) CCachedEnumIDList(std::move(children), truncated);
+    if (!enumerator) {
+        for (PITEMID_CHILD child : children) {
+            ILFree(child);
+        }
+        return nullptr;
+    }
+
+    Wh_Log(L"Serving %zu items from the listing cache", count);
+    return enumerator;
+}
+
 // The menu band does not enumerate through the IShellFolder we hand it (it uses
 // the real folder it binds from the pidl), so wrapping that folder has no
 // effect. Instead we inline-hook the IShellFolder methods directly. Every
@@ -2297,6 +3011,48 @@ const FolderOrigs* OrigsForFolder(IShellFolder* pThis) {
 // to bound sub-folders through it.
 void EnsureFolderHooked(IShellFolder* folder, PCWSTR source);
 
+// The band's own enumeration doesn't follow Explorer's "Hidden files and
+// folders" setting, so hidden item visibility is decided here.
+// SHCONTF_INCLUDEHIDDEN adds the items carrying the hidden attribute;
+// hidden+system ("protected operating system") items come along with them only
+// when Explorer's separate "Hide protected operating system files" setting is
+// off. SHCONTF_INCLUDESUPERHIDDEN forces those in even when it is on, and does
+// nothing without SHCONTF_INCLUDEHIDDEN; leaving it out keeps them tracking
+// that setting, like the file list does. The worker always enumerates hidden
+// items when building its resolution map.
+SHCONTF AdjustBandEnumFlags(SHCONTF grfFlags) {
+    bool includeHidden;
+    switch (g_settings.showHidden) {
+        case ShowHidden::hide:
+            includeHidden = false;
+            break;
+
+        case ShowHidden::show:
+            includeHidden = true;
+            break;
+
+        case ShowHidden::systemDefault:
+        default: {
+            SHELLFLAGSTATE shellFlagState{};
+            SHGetSettings(&shellFlagState, SSF_SHOWALLOBJECTS);
+            includeHidden = shellFlagState.fShowAllObjects;
+            break;
+        }
+    }
+
+    if (includeHidden) {
+        grfFlags |= SHCONTF_INCLUDEHIDDEN;
+    } else {
+        grfFlags &= ~SHCONTF_INCLUDEHIDDEN;
+    }
+    return grfFlags;
+}
+
+// The flags of the band's last enumeration (after AdjustBandEnumFlags), so the
+// prefetch thread enumerates exactly like the band will. 0 until the first
+// menu is opened.
+volatile LONG g_bandEnumFlags;
+
 HRESULT STDMETHODCALLTYPE EnumObjects_Hook(IShellFolder* pThis,
                                            HWND hwnd,
                                            SHCONTF grfFlags,
@@ -2307,45 +3063,23 @@ HRESULT STDMETHODCALLTYPE EnumObjects_Hook(IShellFolder* pThis,
         return E_FAIL;
     }
 
-    // The background worker also enumerates folders (to build its hover map)
-    // and must see the complete, unbounded list, so only the menu band's
-    // enumeration is adjusted below.
-    bool bandEnumeration = GetCurrentThreadId() != g_workerThreadId;
-
-    // The band's own enumeration doesn't follow Explorer's "Hidden files and
-    // folders" setting, so hidden item visibility is decided here.
-    // SHCONTF_INCLUDEHIDDEN adds the items carrying the hidden attribute;
-    // hidden+system ("protected operating system") items come along with them
-    // only when Explorer's separate "Hide protected operating system files"
-    // setting is off. SHCONTF_INCLUDESUPERHIDDEN forces those in even when it
-    // is on, and does nothing without SHCONTF_INCLUDEHIDDEN; leaving it out
-    // keeps them tracking that setting, like the file list does. The worker
-    // always enumerates hidden items when building its resolution map.
-    if (bandEnumeration) {
-        bool includeHidden;
-        switch (g_settings.showHidden) {
-            case ShowHidden::hide:
-                includeHidden = false;
-                break;
+    // The background worker and prefetch threads also enumerate folders (to
+    // build the hover map and the listing cache) and must see the complete,
+    // unbounded list, so only the menu band's enumeration is adjusted below.
+    DWORD threadId = GetCurrentThreadId();
+    bool bandEnumeration =
+        threadId != g_workerThreadId && threadId != g_prefetchThreadId;
 
-            case ShowHidden::show:
-                includeHidden = true;
-                break;
+    if (bandEnumeration) {
+        grfFlags = AdjustBandEnumFlags(grfFlags);
+        InterlockedExchange(&g_bandEnumFlags, (LONG)grfFlags);
 
-            case ShowHidden::systemDefault:
-            default: {
-                SHELLFLAGSTATE shellFlagState{};
-                SHGetSettings(&shellFlagState, SSF_SHOWALLOBJECTS);
-                includeHidden = shellFlagState.fShowAllObjects;
-                break;
+        if (ppenumIDList) {
+            if (IEnumIDList* cached = CreateCachedEnumerator(pThis, grfFlags)) {
+                *ppenumIDList = cached;
+                return S_OK;
             }
         }
-
-        if (includeHidden) {
-            grfFlags |= SHCONTF_INCLUDEHIDDEN;
-        } else {
-            grfFlags &= ~SHCONTF_INCLUDEHIDDEN;
-        }
     }
 
     HRESULT hr = origs->enumObjects(pThis, hwnd, grfFlags, ppenumIDList);
@@ -2626,6 +3360,174 @@ void InitEnumTimeoutHooks() {
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Prefetch thread: fills the listing cache in the background. A thread of its
+// own, so that a slow enumeration never holds up the worker's snapshot
+// refreshes.
+
+// A folder to prefetch, handed from the UI thread (or, for speculative
+// sub-folder prefetches, from the prefetch thread itself) via
+// WM_APP_DO_PREFETCH. The prefetch thread owns it and frees pidl + the struct.
+struct PrefetchRequest {
+    PIDLIST_ABSOLUTE folderAbs;
+    LONG generation;
+    bool speculative;  // Don't queue this folder's sub-folders in turn.
+};
+
+// Bumped by the UI thread whenever the button is shown for another folder, so
+// that queued requests for folders no longer hovered are skipped, and an
+// enumeration in progress for one is cut short.
+volatile LONG g_prefetchGeneration;
+
+bool IsPrefetchCurrent(LONG generation) {
+    return InterlockedCompareExchange(&g_prefetchGeneration, 0, 0) ==
+           generation;
+}
+
+// Enumerates the requested folder into the listing cache, within the same
+// item-count and time budgets the band is bounded by, unless a fresh listing is
+// already cached. Unless the request is speculative, queues the first few
+// sub-folders for prefetching too. Prefetch thread only.
+void PrefetchFolderListing(const PrefetchRequest& req) {
+    if (!IsPrefetchCurrent(req.generation)) {
+        return;
+    }
+
+    SHCONTF flags = (SHCONTF)InterlockedCompareExchange(&g_bandEnumFlags, 0, 0);
+    if (!flags) {
+        flags = AdjustBandEnumFlags(SHCONTF_FOLDERS | SHCONTF_NONFOLDERS);
+    }
+
+    if (HasFolderListing(req.folderAbs, flags)) {
+        return;
+    }
+
+    // File-system folders only (see the listing cache above).
+    WCHAR path[MAX_PATH];
+    if (!SHGetPathFromIDListW(req.folderAbs, path)) {
+        return;
+    }
+
+    winrt::com_ptr<IShellFolder> folder;
+    if (FAILED(SHBindToObject(nullptr, req.folderAbs, nullptr,
+                              IID_PPV_ARGS(folder.put()))) ||
+        !folder) {
+        return;
+    }
+
+    PIDLIST_ABSOLUTE folderAbs = ILClone(req.folderAbs);
+    if (!folderAbs) {
+        return;
+    }
+
+    // Registered for change notifications before enumerating, so that no
+    // change made during the enumeration is missed.
+    UINT notifyMsg = BeginFolderListing(folderAbs, flags);
+
+    winrt::com_ptr<IEnumIDList> enumerator;
+    if (folder->EnumObjects(nullptr, flags, enumerator.put()) != S_OK ||
+        !enumerator) {
+        AbandonFolderListing(notifyMsg);
+        return;
+    }
+
+    std::vector<PITEMID_CHILD> children;
+    bool truncated = false;
+    std::vector<PIDLIST_ABSOLUTE> subfolders;
+
+    ULONGLONG deadline = GetTickCount64() + g_settings.enumTimeoutMs;
+    while (true) {
+        if (!IsPrefetchCurrent(req.generation)) {
+            AbandonFolderListing(notifyMsg);
+            for (PITEMID_CHILD child : children) {
+                ILFree(child);
+            }
+            for (PIDLIST_ABSOLUTE subfolder : subfolders) {
+                ILFree(subfolder);
+            }
+            return;
+        }
+
+        if (children.size() >= (size_t)g_settings.maxEnumItems ||
+            GetTickCount64() >= deadline) {
+            truncated = true;
+            break;
+        }
+
+        LPITEMIDLIST child = nullptr;
+        ULONG fetched = 0;
+        if (enumerator->Next(1, &child, &fetched) != S_OK || fetched != 1) {
+            break;
+        }
+        children.push_back((PITEMID_CHILD)child);
+
+        if (!req.speculative &&
+            subfolders.size() < kMaxSpeculativePrefetches) {
+            // Not SFGAO_STREAM: a compressed folder is a file that can be
+            // browsed, and enumerating it means decompressing it.
+            LPCITEMIDLIST childConst = child;
+            SFGAOF attrs = SFGAO_FOLDER | SFGAO_FILESYSTEM | SFGAO_STREAM;
+            if (SUCCEEDED(folder->GetAttributesOf(1, &childConst, &attrs)) &&
+                (attrs & SFGAO_FOLDER) && (attrs & SFGAO_FILESYSTEM) &&
+                !(attrs & SFGAO_STREAM)) {
+                if (PIDLIST_ABSOLUTE subfolder =
+                        ILCombine(req.folderAbs, child)) {
+                    subfolders.push_back(subfolder);
+                }
+            }
+        }
+    }
+
+    Wh_Log(L"Prefetched %zu items (truncated=%d, speculative=%d)",
+           children.size(), (int)truncated, (int)req.speculative);
+    FinishFolderListing(notifyMsg, std::move(children), truncated);
+
+    // Posted to this same thread, so they're handled after any request that is
+    // already queued, and skipped if the hovered folder changes meanwhile.
+    for (PIDLIST_ABSOLUTE subfolder : subfolders) {
+        auto* subReq = new (std::nothrow)
+            PrefetchRequest{subfolder, req.generation, /*speculative=*/true};
+        if (!subReq ||
+            !PostThreadMessageW(GetCurrentThreadId(), WM_APP_DO_PREFETCH,
+                                (WPARAM)subReq, 0)) {
+            ILFree(subfolder);
+            delete subReq;
+        }
+    }
+}
+
+DWORD WINAPI PrefetchThreadProc(LPVOID param) {
+    OleInitialize(nullptr);
+
+    // Force the thread message queue to exist before signaling ready, so the UI
+    // thread's PostThreadMessage requests are never lost.
+    MSG msg;
+    PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+
+    SetEvent(g_prefetchReadyEvent);
+
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+        if (msg.hwnd == nullptr && msg.message == WM_APP_QUIT) {
+            PostQuitMessage(0);
+            continue;
+        }
+        if (msg.hwnd == nullptr && msg.message == WM_APP_DO_PREFETCH) {
+            auto* req = reinterpret_cast<PrefetchRequest*>(msg.wParam);
+            if (req) {
+                PrefetchFolderListing(*req);
+                ILFree(req->folderAbs);
+                delete req;
+            }
+            continue;
+        }
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+
+    OleUninitialize();
+    return 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // The cascading folder menu (adapted from folder_menu.c / "Quick Folder Menu").
 
@@ -2859,6 +3761,31 @@ HWND GetMenuFolderItemUnderCursor(POINT pt, int* outIdCmd) {
     return toolbar;
 }
 
+// Asks the prefetch thread to load the listing of `folderAbs` (borrowed), the
+// folder the button was just shown for, into the cache the menu is served
+// from. Supersedes the requests for the previously hovered folder.
+void PostPrefetchRequest(PCIDLIST_ABSOLUTE folderAbs) {
+    LONG generation = InterlockedIncrement(&g_prefetchGeneration);
+    if (!g_settings.prefetch || !g_prefetchThreadId) {
+        return;
+    }
+
+    auto* req = new (std::nothrow) PrefetchRequest{};
+    if (!req) {
+        return;
+    }
+    req->folderAbs = ILClone(folderAbs);
+    req->generation = generation;
+    if (!req->folderAbs ||
+        !PostThreadMessageW(g_prefetchThreadId, WM_APP_DO_PREFETCH,
+                            (WPARAM)req, 0)) {
+        if (req->folderAbs) {
+            ILFree(req->folderAbs);
+        }
+        delete req;
+    }
+}
+
 // Hands `pidl` (a folder, borrowed) off to the worker thread to open. A null or
 // non-folder pidl is ignored. Does not dismiss the menu - the band does that
 // itself once the execute completes.
@@ -3326,12 +4253,21 @@ void ShowChevronForItem(PIDLIST_ABSOLUTE childAbs, RECT itemRect) {
         return;
     }
 
+    // Prefetch when the button appears for a folder, not when it only moves
+    // with the item (e.g. on scroll).
+    bool prefetch = !g_chevronVisible || !g_targetPidl ||
+                    !ILIsEqual(g_targetPidl, childAbs);
+
     if (g_targetPidl) {
         ILFree(g_targetPidl);
     }
     g_targetPidl = childAbs;
     g_hoverItemRect = itemRect;
 
+    if (prefetch) {
+        PostPrefetchRequest(childAbs);
+    }
+
     UINT dpi = GetDpiForRect(itemRect);
     int size = MulDiv(g_settings.iconSize, dpi, 96);
     int margin = MulDiv(2, dpi, 96);
@@ -3517,14 +4453,18 @@ void Evaluate(bool forceRefresh) {
     bool snapMatches =
         g_snapValid && g_snapTab == tab && g_snapIsDesktop == isDesktop;
     if (snapMatches) {
-        for (const CachedItem& item : g_snapItems) {
+        const UINT* first;
+        const UINT* last;
+        ItemGridCandidates(g_snapGrid, pt, &first, &last);
+        for (const UINT* i = first; i != last; i++) {
+            const CachedItem& item = g_snapItems[*i];
             RECT r = item.rect;
             if (g_snapNameColumnRight && g_snapNameColumnRight > r.left &&
                 g_snapNameColumnRight < r.right) {
                 r.right = g_snapNameColumnRight;
             }
             if (PtInRect(&r, pt)) {
-                auto it = g_snapChildren.find(ToLower(item.name));
+                auto it = g_snapChildren.find(item.key);
                 if (it != g_snapChildren.end()) {
                     childAbs = ILClone(it->second);
                     hitRect = r;
@@ -3532,8 +4472,13 @@ void Evaluate(bool forceRefresh) {
                 break;
             }
         }
-        if (forceRefresh ||
-            (GetTickCount64() - g_snapBuiltTick) > kRefreshTtlMs) {
+        // A burst of change events, e.g. while scrolling through a large
+        // folder, causes at most one rebuild per kRefreshTtlMs.
+        ULONGLONG age = GetTickCount64() - g_snapBuiltTick;
+        ULONGLONG ttl = g_snapEventDriven && !g_snapDirty
+                            ? kEventDrivenRefreshTtlMs
+                            : kRefreshTtlMs;
+        if (forceRefresh || age > ttl) {
             requestRefresh = true;
         }
     } else {
@@ -3724,6 +4669,22 @@ LRESULT CALLBACK SinkWndProc(HWND hwnd,
         return 0;
     }
 
+    if (msg >= WM_APP_LISTING_CHANGED &&
+        msg < WM_APP_LISTING_CHANGED + kMaxCachedListings) {
+        // A cached folder listing changed (see BeginFolderListing). The
+        // notification must be locked and unlocked to be released, but only
+        // the message itself matters: it identifies the stale entry.
+        PIDLIST_ABSOLUTE* pidls;
+        LONG event;
+        HANDLE lock = SHChangeNotification_Lock((HANDLE)wParam, (DWORD)lParam,
+                                                &pidls, &event);
+        InvalidateFolderListing(msg);
+        if (lock) {
+            SHChangeNotification_Unlock(lock);
+        }
+        return 0;
+    }
+
     if (msg == WM_TIMER && wParam == kWatchdogTimerId) {
         // Periodic re-check while the button is shown, to catch navigation that
         // moved no mouse (double-click / keyboard Enter).
@@ -3934,6 +4895,18 @@ DWORD WINAPI UiThreadProc(LPVOID param) {
         g_workerReadyEvent = nullptr;
     }
 
+    // And the thread that prefetches folder listings for the menu.
+    g_prefetchReadyEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    g_prefetchThread = CreateThread(nullptr, 0, PrefetchThreadProc, nullptr, 0,
+                                    &g_prefetchThreadId);
+    if (g_prefetchThread && g_prefetchReadyEvent) {
+        WaitForSingleObject(g_prefetchReadyEvent, 5000);
+    }
+    if (g_prefetchReadyEvent) {
+        CloseHandle(g_prefetchReadyEvent);
+        g_prefetchReadyEvent = nullptr;
+    }
+
     // Start active if Explorer or the desktop is already in the foreground,
     // instead of waiting for the next foreground change.
     SyncActiveState();
@@ -3999,6 +4972,22 @@ DWORD WINAPI UiThreadProc(LPVOID param) {
     }
     g_snapChildren.clear();
 
+    // Stop the prefetch thread too. Bumping the generation makes it skip the
+    // queued requests and cut an enumeration in progress short.
+    InterlockedIncrement(&g_prefetchGeneration);
+    if (g_prefetchThreadId) {
+        PostThreadMessageW(g_prefetchThreadId, WM_APP_QUIT, 0, 0);
+    }
+    if (g_prefetchThread) {
+        WaitForSingleObject(g_prefetchThread, 5000);
+        CloseHandle(g_prefetchThread);
+        g_prefetchThread = nullptr;
+        g_prefetchThreadId = 0;
+    }
+
+    // Before the sink window the change notifications are posted to is gone.
+    ClearFolderListings();
+
     if (g_sinkWnd) {
         DeregisterShellHookWindow(g_sinkWnd);
         DestroyWindow(g_sinkWnd);
@@ -4030,11 +5019,13 @@ BOOL WhTool_ModInit() {
     InitEnumTimeoutHooks();
 
     InitializeCriticalSection(&g_snapshotLock);
+    InitializeCriticalSection(&g_listingCacheLock);
 
     g_readyEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
     if (!g_readyEvent) {
         Wh_Log(L"CreateEvent failed");
         DeleteCriticalSection(&g_snapshotLock);
+        DeleteCriticalSection(&g_listingCacheLock);
         return FALSE;
     }
 
@@ -4045,6 +5036,7 @@ BOOL WhTool_ModInit() {
         CloseHandle(g_readyEvent);
         g_readyEvent = nullptr;
         DeleteCriticalSection(&g_snapshotLock);
+        DeleteCriticalSection(&g_listingCacheLock);
         return FALSE;
     }
 
@@ -4077,6 +5069,7 @@ void WhTool_ModUninit() {
     }
 
     DeleteCriticalSection(&g_snapshotLock);
+    DeleteCriticalSection(&g_listingCacheLock);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -2,7 +2,7 @@
 // @id              file-explorer-remove-suffixes
 // @name            Remove Taskbar Window Suffixes
 // @description     Remove suffixes from taskbar window titles for File Explorer and other programs, or configure custom text replacement rules
-// @version         1.1.1
+// @version         1.1.7
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -26,7 +26,8 @@ Choose how suffixes are removed:
 - **File Explorer only** (default): Removes the " - File Explorer" suffix from
   File Explorer windows.
 - **Universal**: Automatically removes the last part after " - ", " — " (em dash
-  with spaces), or "—" (em dash alone) from any window title. Examples:
+  with spaces), or "—" (em dash alone) from any window title. The separators
+  can be changed in the settings. Examples:
     - "Document - Notepad" becomes "Document"
     - "Downloads - File Explorer" becomes "Downloads"
     - "Windhawk — Firefox" becomes "Windhawk"
@@ -97,6 +98,11 @@ sequentially in the order they're defined.
     Controls how suffixes are removed from taskbar titles. "File Explorer only"
     only removes File Explorer suffixes. "Universal" removes the suffix from any
     title (e.g., "Document - Editor" becomes "Document").
+- universalSeparators: [" - ", " — ", "—"]
+  $name: Universal mode separators
+  $description: >-
+    In universal mode, the title is cut at the last occurrence of any of these
+    separators.
 - suffixRules:
   - - processIdentifier: ""
       $name: Process (name, path, or App ID)
@@ -125,8 +131,15 @@ sequentially in the order they're defined.
 
 #include <psapi.h>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <winrt/base.h>
@@ -137,16 +150,188 @@ enum class SuffixRemovalMode {
     Universal,
 };
 
+// Most rules remove or rewrite a literal suffix, e.g. " - Notepad$" or
+// "^(.*) - Google Chrome$". Such patterns are matched with a plain comparison,
+// which takes linear time and doesn't allocate or throw, unlike std::wregex
+// which backtracks. Other patterns are matched with std::wregex.
+enum class SuffixMatcher {
+    Regex,
+    // "literal$"
+    LiteralSuffix,
+    // "^(.*)literal$"
+    CapturedLiteralSuffix,
+};
+
+// Parses the subset of the ECMAScript syntax described above. Returns false
+// if the pattern has other constructs.
+bool ParseLiteralSuffixPattern(std::wstring_view pattern,
+                               SuffixMatcher* matcher,
+                               std::wstring* literal) {
+    constexpr std::wstring_view kCapturePrefix = L"^(.*)";
+    constexpr std::wstring_view kSyntaxCharacters = L"^$\\.*+?()[]{}|";
+
+    SuffixMatcher result = SuffixMatcher::LiteralSuffix;
+    if (pattern.substr(0, kCapturePrefix.size()) == kCapturePrefix) {
+        pattern.remove_prefix(kCapturePrefix.size());
+        result = SuffixMatcher::CapturedLiteralSuffix;
+    }
+
+    if (pattern.empty() || pattern.back() != L'$') {
+        return false;
+    }
+
+    pattern.remove_suffix(1);
+
+    std::wstring value;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        WCHAR c = pattern[i];
+        if (c == L'\\') {
+            if (++i == pattern.size()) {
+                return false;
+            }
+
+            c = pattern[i];
+            if (c != L'/' && c != L'-' &&
+                kSyntaxCharacters.find(c) == kSyntaxCharacters.npos) {
+                return false;
+            }
+        } else if (kSyntaxCharacters.find(c) != kSyntaxCharacters.npos) {
+            return false;
+        }
+
+        value += c;
+    }
+
+    if (value.empty()) {
+        return false;
+    }
+
+    *matcher = result;
+    *literal = std::move(value);
+    return true;
+}
+
+// Expands a std::regex_replace format string ($&, $`, $', $$, $n, $nn).
+void AppendReplacement(std::wstring* output,
+                       std::wstring_view format,
+                       std::wstring_view match,
+                       std::wstring_view prefix,
+                       std::wstring_view suffix,
+                       std::wstring_view group1) {
+    for (size_t i = 0; i < format.size(); i++) {
+        WCHAR c = format[i];
+        if (c != L'$' || i + 1 == format.size()) {
+            *output += c;
+            continue;
+        }
+
+        c = format[++i];
+        if (c == L'$') {
+            *output += L'$';
+        } else if (c == L'&') {
+            *output += match;
+        } else if (c == L'`') {
+            *output += prefix;
+        } else if (c == L'\'') {
+            *output += suffix;
+        } else if (c >= L'0' && c <= L'9') {
+            int group = c - L'0';
+            if (i + 1 < format.size() && format[i + 1] >= L'0' &&
+                format[i + 1] <= L'9') {
+                group = group * 10 + (format[++i] - L'0');
+            }
+
+            if (group == 0) {
+                *output += match;
+            } else if (group == 1) {
+                *output += group1;
+            }
+        } else {
+            *output += L'$';
+            *output += c;
+        }
+    }
+}
+
+// Returns false if the rule doesn't match.
+bool ApplyLiteralSuffixRule(SuffixMatcher matcher,
+                            std::wstring_view literal,
+                            std::wstring_view replace,
+                            std::wstring_view text,
+                            std::wstring* result) {
+    if (text.size() < literal.size() ||
+        text.substr(text.size() - literal.size()) != literal) {
+        return false;
+    }
+
+    std::wstring_view rest = text.substr(0, text.size() - literal.size());
+
+    if (matcher == SuffixMatcher::LiteralSuffix) {
+        result->assign(rest);
+        AppendReplacement(result, replace, literal, rest, {}, {});
+        return true;
+    }
+
+    // "." doesn't match line terminators.
+    if (rest.find_first_of(L"\n\r\u2028\u2029") != rest.npos) {
+        return false;
+    }
+
+    result->clear();
+    AppendReplacement(result, replace, text, {}, {}, rest);
+    return true;
+}
+
 struct SuffixRule {
     std::wstring processIdentifier;  // Stored in uppercase, empty = match all
-    std::wregex search;
+    SuffixMatcher matcher;
+    std::wstring literal;  // For the literal suffix matchers
+    std::wregex search;    // For SuffixMatcher::Regex
     std::wstring replace;
 };
 
-struct {
+struct Settings {
     SuffixRemovalMode suffixRemovalMode;
+    std::vector<std::wstring> universalSeparators;
     std::vector<SuffixRule> suffixRules;
-} g_settings;
+};
+
+// Replaced as a whole when the settings are reloaded, and never modified once
+// published. Readers take a reference under g_windowTitleCacheMutex, and use
+// it for the whole call, so a reload can't free the rules while they're in
+// use.
+std::shared_ptr<const Settings> g_settings;
+
+// A copy of g_settings->suffixRemovalMode for the FindResourceExW hook, which
+// is called too often to take the lock.
+std::atomic<SuffixRemovalMode> g_suffixRemovalMode;
+
+// The taskbar queries the titles of its windows often, e.g. whenever a browser
+// updates its title. The matching rules, which are expensive to resolve, and
+// the last rewritten title are cached per window. An entry is only used if the
+// window still belongs to the same process, since window handles can be
+// reused. The cache is cleared when the settings are replaced.
+struct WindowTitleCacheEntry {
+    DWORD processId;
+    std::vector<size_t> ruleIndices;
+    // Set if the App ID was needed to resolve the rules. The entry is then
+    // only used while the window's App ID is unchanged.
+    bool appIdDependent;
+    std::wstring appId;
+    std::wstring lastTitle;
+    std::wstring lastResult;
+    bool lastModified;
+};
+
+// Entries of destroyed windows are pruned when the cache grows beyond the
+// threshold, which is then raised so that a cache full of live windows isn't
+// swept on every insertion.
+constexpr size_t kWindowTitleCachePruneSize = 256;
+
+// Guards g_settings and the cache.
+std::mutex g_windowTitleCacheMutex;
+std::unordered_map<HWND, WindowTitleCacheEntry> g_windowTitleCache;
+size_t g_windowTitleCachePruneThreshold = kWindowTitleCachePruneSize;
 
 HWND FindCurrentProcessTaskbarWnd() {
     HWND hTaskbarWnd = nullptr;
@@ -232,10 +417,26 @@ std::wstring GetWindowAppId(HWND hWnd) {
     return result;
 }
 
-std::vector<const SuffixRule*> GetRulesForWindow(HWND hWnd) {
-    std::vector<const SuffixRule*> matchedRules;
+std::wstring GetWindowAppIdUpper(HWND hWnd) {
+    std::wstring appId = GetWindowAppId(hWnd);
+    if (!appId.empty()) {
+        LCMapStringEx(LOCALE_NAME_USER_DEFAULT, LCMAP_UPPERCASE, appId.data(),
+                      static_cast<int>(appId.length()), appId.data(),
+                      static_cast<int>(appId.length()), nullptr, nullptr, 0);
+    }
+
+    return appId;
+}
 
-    if (g_settings.suffixRules.empty()) {
+// If `*appIdFetched` is set, `*appId` is used instead of querying the App ID.
+// On return, `*appIdFetched` is set if the App ID was needed.
+std::vector<size_t> GetRulesForWindow(const Settings& settings,
+                                      HWND hWnd,
+                                      std::wstring* appId,
+                                      bool* appIdFetched) {
+    std::vector<size_t> matchedRules;
+
+    if (settings.suffixRules.empty()) {
         return matchedRules;
     }
 
@@ -275,12 +476,9 @@ std::vector<const SuffixRule*> GetRulesForWindow(HWND hWnd) {
         programFileNameUpper++;
     }
 
-    // Get App ID once (expensive operation)
-    std::wstring appId;
-    bool appIdFetched = false;
-
     // Check each rule and collect all matches
-    for (const auto& rule : g_settings.suffixRules) {
+    for (size_t i = 0; i < settings.suffixRules.size(); i++) {
+        const auto& rule = settings.suffixRules[i];
         bool matches = false;
 
         // Empty process identifier matches all processes
@@ -300,37 +498,133 @@ std::vector<const SuffixRule*> GetRulesForWindow(HWND hWnd) {
         }
         // Check App ID match
         else {
-            if (!appIdFetched) {
-                appId = GetWindowAppId(hWnd);
-                if (!appId.empty()) {
-                    LCMapStringEx(
-                        LOCALE_NAME_USER_DEFAULT, LCMAP_UPPERCASE, appId.data(),
-                        static_cast<int>(appId.length()), appId.data(),
-                        static_cast<int>(appId.length()), nullptr, nullptr, 0);
-                }
-                appIdFetched = true;
+            // Get App ID once (expensive operation)
+            if (!*appIdFetched) {
+                *appId = GetWindowAppIdUpper(hWnd);
+                *appIdFetched = true;
             }
-            if (!appId.empty() &&
-                wcscmp(appId.c_str(), rule.processIdentifier.c_str()) == 0) {
+            if (!appId->empty() && *appId == rule.processIdentifier) {
                 matches = true;
             }
         }
 
         if (matches) {
-            matchedRules.push_back(&rule);
+            matchedRules.push_back(i);
         }
     }
 
     return matchedRules;
 }
 
+// Returns the position of the rightmost separator in the text, or npos. A
+// separator which is a part of a longer one, such as "—" in " — ", is
+// attributed to the longer one.
+size_t FindLastSeparator(std::wstring_view text,
+                         const std::vector<std::wstring>& separators) {
+    for (size_t i = text.size(); i-- > 0;) {
+        size_t matchEnd = 0;
+        for (const auto& separator : separators) {
+            if (!separator.empty() &&
+                text.substr(i, separator.size()) == separator) {
+                matchEnd = std::max(matchEnd, i + separator.size());
+            }
+        }
+
+        if (!matchEnd) {
+            continue;
+        }
+
+        size_t result = i;
+        for (const auto& separator : separators) {
+            if (separator.size() <= matchEnd - i) {
+                continue;
+            }
+
+            for (size_t j = matchEnd - std::min(matchEnd, separator.size());
+                 j < result; j++) {
+                if (text.substr(j, separator.size()) == separator) {
+                    result = j;
+                    break;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    return std::wstring_view::npos;
+}
+
+// Applies the universal suffix removal and the given rules to the title.
+// Returns false if the title is unchanged.
+bool RewriteTitle(const Settings& settings,
+                  std::wstring_view title,
+                  const std::vector<size_t>& ruleIndices,
+                  std::wstring* result) {
+    bool modified = false;
+
+    // Apply universal mode: remove the part after the last separator
+    if (settings.suffixRemovalMode == SuffixRemovalMode::Universal) {
+        size_t lastSepPos =
+            FindLastSeparator(title, settings.universalSeparators);
+        if (lastSepPos != std::wstring_view::npos) {
+            title = title.substr(0, lastSepPos);
+            modified = true;
+            Wh_Log(L"Universal mode: removed suffix after last separator");
+        }
+    }
+
+    if (!modified && ruleIndices.empty()) {
+        return false;
+    }
+
+    std::wstring text(title);
+
+    // Apply all matching rules in order
+    for (size_t ruleIndex : ruleIndices) {
+        if (ruleIndex >= settings.suffixRules.size()) {
+            continue;
+        }
+
+        const auto& rule = settings.suffixRules[ruleIndex];
+        if (rule.matcher != SuffixMatcher::Regex) {
+            std::wstring newText;
+            if (ApplyLiteralSuffixRule(rule.matcher, rule.literal, rule.replace,
+                                       text, &newText) &&
+                newText != text) {
+                text = std::move(newText);
+                modified = true;
+            }
+            continue;
+        }
+
+        try {
+            std::wstring newText =
+                std::regex_replace(text, rule.search, rule.replace);
+            if (newText != text) {
+                text = std::move(newText);
+                modified = true;
+            }
+        } catch (const std::regex_error& ex) {
+            Wh_Log(L"Regex replace error %08X: %S",
+                   static_cast<DWORD>(ex.code()), ex.what());
+        }
+    }
+
+    if (modified) {
+        *result = std::move(text);
+    }
+
+    return modified;
+}
+
 using FindResourceExW_t = decltype(&FindResourceExW);
 FindResourceExW_t FindResourceExW_Original;
 HRSRC WINAPI FindResourceExW_Hook(HMODULE hModule,
                                   LPCWSTR lpType,
                                   LPCWSTR lpName,
                                   WORD wLanguage) {
-    if (g_settings.suffixRemovalMode == SuffixRemovalMode::FileExplorerOnly &&
+    if (g_suffixRemovalMode == SuffixRemovalMode::FileExplorerOnly &&
         hModule && lpType == RT_STRING && lpName == MAKEINTRESOURCE(2195) &&
         hModule == GetModuleHandle(L"explorerframe.dll")) {
         Wh_Log(L">");
@@ -353,11 +647,6 @@ int WINAPI InternalGetWindowText_Hook(HWND hWnd,
         return result;
     }
 
-    if (g_settings.suffixRemovalMode != SuffixRemovalMode::Universal &&
-        g_settings.suffixRules.empty()) {
-        return result;
-    }
-
     void* retAddress = __builtin_return_address(0);
 
     HMODULE taskbarModule = GetModuleHandle(L"taskbar.dll");
@@ -373,78 +662,141 @@ int WINAPI InternalGetWindowText_Hook(HWND hWnd,
         return result;
     }
 
-    Wh_Log(L"Original text: %s", pString);
+    DWORD dwProcessId = 0;
+    GetWindowThreadProcessId(hWnd, &dwProcessId);
 
-    std::wstring text = pString;
-    bool modified = false;
+    std::wstring_view title(pString, result);
 
-    // Apply universal mode: remove last " - <text>" or "—<text>" part
-    if (g_settings.suffixRemovalMode == SuffixRemovalMode::Universal &&
-        result > 0 && pString) {
-        // Find the last occurrence of " - ", " — ", or "—"
-        size_t lastSepPos = std::wstring::npos;
+    std::vector<size_t> ruleIndices;
+    bool ruleIndicesCached = false;
+    std::wstring appId;
+    bool appIdFetched = false;
+    std::shared_ptr<const Settings> settings;
+
+    // Returns true if the title was answered from the cache. Must be called
+    // with g_windowTitleCacheMutex held.
+    auto lookupCache = [&](bool* needAppId) {
+        auto it = g_windowTitleCache.find(hWnd);
+        if (it == g_windowTitleCache.end() ||
+            it->second.processId != dwProcessId) {
+            return false;
+        }
 
-        size_t hyphenPos = text.rfind(L" - ");
-        size_t emDashSpacePos = text.rfind(L" — ");
-        size_t emDashPos = text.rfind(L"—");
+        const auto& entry = it->second;
+        if (entry.appIdDependent) {
+            if (!appIdFetched) {
+                *needAppId = true;
+                return false;
+            }
 
-        // Find the rightmost separator
-        // Note: Check longer patterns first to avoid matching "—" that's part
-        // of " — "
-        if (hyphenPos != std::wstring::npos) {
-            lastSepPos = hyphenPos;
+            if (entry.appId != appId) {
+                return false;
+            }
         }
-        if (emDashSpacePos != std::wstring::npos &&
-            (lastSepPos == std::wstring::npos || emDashSpacePos > lastSepPos)) {
-            lastSepPos = emDashSpacePos;
+
+        if (entry.lastTitle == title) {
+            if (entry.lastModified &&
+                entry.lastResult.length() < static_cast<size_t>(cchMaxCount)) {
+                wcscpy_s(pString, cchMaxCount, entry.lastResult.c_str());
+                result = static_cast<int>(entry.lastResult.length());
+            }
+            return true;
         }
-        // Only use emDashPos if it's not part of " — " pattern
-        if (emDashPos != std::wstring::npos &&
-            (lastSepPos == std::wstring::npos || emDashPos > lastSepPos) &&
-            !(emDashSpacePos != std::wstring::npos &&
-              emDashPos == emDashSpacePos + 1)) {
-            lastSepPos = emDashPos;
+
+        ruleIndices = entry.ruleIndices;
+        ruleIndicesCached = true;
+        return false;
+    };
+
+    bool needAppId = false;
+
+    {
+        std::lock_guard<std::mutex> guard(g_windowTitleCacheMutex);
+        settings = g_settings;
+        if (!settings ||
+            (settings->suffixRemovalMode != SuffixRemovalMode::Universal &&
+             settings->suffixRules.empty())) {
+            return result;
         }
 
-        if (lastSepPos != std::wstring::npos) {
-            text = text.substr(0, lastSepPos);
-            modified = true;
-            Wh_Log(L"Universal mode: removed suffix after last separator");
+        if (lookupCache(&needAppId)) {
+            return result;
         }
     }
 
-    // Get all matching rules for this window's process
-    std::vector<const SuffixRule*> rules = GetRulesForWindow(hWnd);
+    if (needAppId) {
+        // Queried outside of the lock, it's a cross-process COM call.
+        appId = GetWindowAppIdUpper(hWnd);
+        appIdFetched = true;
 
-    if (!rules.empty() && result > 0 && pString) {
-        // Apply all matching rules in order
-        for (const auto* rule : rules) {
-            try {
-                std::wstring newText =
-                    std::regex_replace(text, rule->search, rule->replace);
-                if (newText != text) {
-                    text = newText;
-                    modified = true;
-                }
-            } catch (const std::regex_error& ex) {
-                Wh_Log(L"Regex replace error %08X: %S",
-                       static_cast<DWORD>(ex.code()), ex.what());
-            }
+        std::lock_guard<std::mutex> guard(g_windowTitleCacheMutex);
+        if (settings != g_settings) {
+            return result;
+        }
+
+        if (lookupCache(&needAppId)) {
+            return result;
         }
     }
 
-    // Update the window text if it changed
-    if (modified) {
+    Wh_Log(L"Original text: %s", pString);
+
+    bool appIdDependent = false;
+    if (!ruleIndicesCached) {
+        ruleIndices =
+            GetRulesForWindow(*settings, hWnd, &appId, &appIdFetched);
+        appIdDependent = appIdFetched;
+    } else {
+        appIdDependent = needAppId;
+    }
+
+    WindowTitleCacheEntry entry{dwProcessId};
+    entry.ruleIndices = std::move(ruleIndices);
+    entry.appIdDependent = appIdDependent;
+    if (appIdDependent) {
+        entry.appId = std::move(appId);
+    }
+    entry.lastTitle = title;
+
+    std::wstring text;
+    if (RewriteTitle(*settings, title, entry.ruleIndices, &text)) {
+        // Update the window text.
         if (text.length() < static_cast<size_t>(cchMaxCount)) {
             wcscpy_s(pString, cchMaxCount, text.c_str());
             result = static_cast<int>(text.length());
             Wh_Log(L"Modified text: %s", pString);
+
+            entry.lastResult = std::move(text);
+            entry.lastModified = true;
         } else {
             Wh_Log(L"Result too long (%zu chars), keeping original",
                    text.length());
         }
     }
 
+    std::lock_guard<std::mutex> guard(g_windowTitleCacheMutex);
+
+    // The entry was resolved with settings that were since replaced.
+    if (settings != g_settings) {
+        return result;
+    }
+
+    if (g_windowTitleCache.size() >= g_windowTitleCachePruneThreshold) {
+        for (auto it = g_windowTitleCache.begin();
+             it != g_windowTitleCache.end();) {
+            if (!IsWindow(it->first)) {
+                it = g_windowTitleCache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        g_windowTitleCachePruneThreshold = std::max(
+            kWindowTitleCachePruneSize, g_windowTitleCache.size() * 2);
+    }
+
+    g_windowTitleCache.insert_or_assign(hWnd, std::move(entry));
+
     return result;
 }
 
@@ -470,19 +822,34 @@ void ApplySettings() {
 void LoadSettings() {
     Wh_Log(L"LoadSettings");
 
+    auto settings = std::make_shared<Settings>();
+
     // Load File Explorer suffix mode
     PCWSTR mode = Wh_GetStringSetting(L"suffixRemovalMode");
-    g_settings.suffixRemovalMode = SuffixRemovalMode::FileExplorerOnly;
+    settings->suffixRemovalMode = SuffixRemovalMode::FileExplorerOnly;
     if (wcscmp(mode, L"off") == 0) {
-        g_settings.suffixRemovalMode = SuffixRemovalMode::Off;
+        settings->suffixRemovalMode = SuffixRemovalMode::Off;
     } else if (wcscmp(mode, L"universal") == 0) {
-        g_settings.suffixRemovalMode = SuffixRemovalMode::Universal;
+        settings->suffixRemovalMode = SuffixRemovalMode::Universal;
     }
     Wh_FreeStringSetting(mode);
 
-    // Load custom suffix rules
-    g_settings.suffixRules.clear();
+    for (int i = 0;; i++) {
+        PCWSTR separator = Wh_GetStringSetting(L"universalSeparators[%d]", i);
+
+        bool hasSeparator = *separator;
+        if (hasSeparator) {
+            settings->universalSeparators.push_back(separator);
+        }
+
+        Wh_FreeStringSetting(separator);
 
+        if (!hasSeparator) {
+            break;
+        }
+    }
+
+    // Load custom suffix rules
     for (int i = 0;; i++) {
         PCWSTR processId =
             Wh_GetStringSetting(L"suffixRules[%d].processIdentifier", i);
@@ -512,16 +879,21 @@ void LoadSettings() {
                               nullptr, nullptr, 0);
             }
 
-            rule.search = std::wregex(search);
+            if (!ParseLiteralSuffixPattern(search, &rule.matcher,
+                                           &rule.literal)) {
+                rule.matcher = SuffixMatcher::Regex;
+                rule.search = std::wregex(search);
+            }
             rule.replace = replace;
 
-            Wh_Log(L"Loaded rule for '%s': '%s' -> '%s'",
+            Wh_Log(L"Loaded rule for '%s': '%s' -> '%s'%s",
                    rule.processIdentifier.empty()
                        ? L"<all processes>"
                        : rule.processIdentifier.c_str(),
-                   search, replace);
+                   search, replace,
+                   rule.matcher == SuffixMatcher::Regex ? L"" : L" (literal)");
 
-            g_settings.suffixRules.push_back(std::move(rule));
+            settings->suffixRules.push_back(std::move(rule));
         } catch (const std::regex_error& ex) {
             Wh_Log(L"Invalid regex pattern '%s': %S (code %08X)", search,
                    ex.what(), static_cast<DWORD>(ex.code()));
@@ -531,6 +903,19 @@ void LoadSettings() {
         Wh_FreeStringSetting(search);
         Wh_FreeStringSetting(replace);
     }
+
+    g_suffixRemovalMode = settings->suffixRemovalMode;
+
+    // The cache is cleared together with publishing the new settings. Calls
+    // still using the old settings don't add their entries (see
+    // InternalGetWindowText_Hook), and release the old settings when done.
+    // Destroyed after the lock is released, unless still in use.
+    std::shared_ptr<const Settings> previousSettings;
+
+    std::lock_guard<std::mutex> guard(g_windowTitleCacheMutex);
+    previousSettings = std::exchange(g_settings, std::move(settings));
+    g_windowTitleCache.clear();
+    g_windowTitleCachePruneThreshold = kWindowTitleCachePruneSize;
 }
 
 BOOL Wh_ModInit() {
@@ -2,7 +2,7 @@
 // @id              keyboard-shortcut-actions
 // @name            Keyboard Shortcut Actions
 // @description     Trigger custom actions with global keyboard shortcuts (hotkeys): show desktop, mute volume, open Task Manager, media controls, and more
-// @version         1.0.1
+// @version         1.0.4
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -166,7 +166,6 @@ space](https://windhawk.net/mods/taskbar-empty-space-clicks) mod by
 #include <algorithm>
 #include <cwctype>
 #include <filesystem>
-#include <functional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -224,12 +223,25 @@ enum class HotkeyActionType {
     MediaPrev,
 };
 
+// Everything an action needs when its hotkey is pressed, prepared once when
+// the settings are loaded
+struct HotkeyActionPlan {
+    // Key downs followed by key ups, for the actions which send keypresses
+    std::vector<INPUT> keypressInput;
+    // For StartProcess
+    std::wstring processVerb;
+    std::wstring processExecutable;
+    std::wstring processParameters;
+    // For CombineTaskbarButtons
+    TaskBarButtonsState combineStates[4];
+};
+
 // Structure for hotkey action configuration
 struct HotkeyAction {
     std::wstring hotkeyString;
     HotkeyActionType actionType;
     std::wstring additionalArgs;
-    std::function<void()> actionExecutor;
+    HotkeyActionPlan plan;
     UINT modifiers;
     UINT vk;
     int hotkeyId;
@@ -366,13 +378,16 @@ enum {
 static const UINT g_uninitCOMMsg =
     RegisterWindowMessage(L"Windhawk_UnInit_COM_" WH_MOD_ID);
 
-// Timer constants for keypress retry when modifier keys are pressed
-static const int kMaxKeypressRetryCount = 50;  // ~500ms max wait
-static const UINT kKeypressRetryIntervalMs = 10;
+// Maximum time to wait for the modifier keys to be released before sending a
+// deferred keypress anyway
+static const UINT kDeferredKeypressTimeoutMs = 500;
 
-// Pending keypress storage for deferred send
-static std::vector<int> g_pendingKeypressKeys;
-static int g_pendingKeypressRetryCount = 0;
+// Pending keypress storage for deferred send. The keyboard hook watches for
+// the modifier keys being released, the timer bounds the wait. Both are owned
+// by the taskbar thread.
+static std::vector<INPUT> g_pendingKeypressInput;
+static UINT g_pendingKeypressHeldModifiers = 0;
+static HHOOK g_keypressKeyboardHook = nullptr;
 static UINT_PTR g_keypressTimerId = 0;
 
 // Forward declarations
@@ -384,8 +399,9 @@ void RegisterHotkeys(HWND hWnd);
 void UnregisterHotkeys(HWND hWnd);
 HotkeyActionType ParseActionType(const std::wstring& actionName);
 const wchar_t* ActionTypeToString(HotkeyActionType actionType);
-std::function<void()> ParseActionSetting(HotkeyActionType actionType,
-                                         const std::wstring& args);
+HotkeyActionPlan BuildActionPlan(HotkeyActionType actionType,
+                                 const std::wstring& args);
+void ExecuteAction(const HotkeyAction& action);
 
 #pragma endregion  // declarations
 
@@ -821,117 +837,191 @@ void ShowDesktop() {
     }
 }
 
-// Checks if any modifier keys are currently pressed
-bool AreModifierKeysPressed() {
-    return (GetAsyncKeyState(VK_CONTROL) & 0x8000) ||
-           (GetAsyncKeyState(VK_MENU) & 0x8000) ||  // Alt
-           (GetAsyncKeyState(VK_SHIFT) & 0x8000) ||
-           (GetAsyncKeyState(VK_LWIN) & 0x8000) ||
-           (GetAsyncKeyState(VK_RWIN) & 0x8000);
+// Modifier keys which delay a keypress until they're released, one bit per
+// physical key
+enum ModifierKeyBits : UINT {
+    kModifierLWin = 1 << 0,
+    kModifierRWin = 1 << 1,
+    kModifierLControl = 1 << 2,
+    kModifierRControl = 1 << 3,
+    kModifierLMenu = 1 << 4,
+    kModifierRMenu = 1 << 5,
+    kModifierLShift = 1 << 6,
+    kModifierRShift = 1 << 7,
+};
+
+UINT ModifierBitFromVk(DWORD vk) {
+    switch (vk) {
+        case VK_LWIN:
+            return kModifierLWin;
+        case VK_RWIN:
+            return kModifierRWin;
+        case VK_LCONTROL:
+            return kModifierLControl;
+        case VK_RCONTROL:
+            return kModifierRControl;
+        case VK_LMENU:
+            return kModifierLMenu;
+        case VK_RMENU:
+            return kModifierRMenu;
+        case VK_LSHIFT:
+            return kModifierLShift;
+        case VK_RSHIFT:
+            return kModifierRShift;
+    }
+
+    return 0;
 }
 
-// Internal function to send virtual key sequence
-void SendKeypressInternal(const std::vector<int>& keys) {
-    if (keys.empty()) {
-        return;
+// Returns the modifier keys which are currently pressed
+UINT GetPressedModifierKeys() {
+    static const DWORD modifierVks[] = {
+        VK_LWIN,  VK_RWIN,  VK_LCONTROL, VK_RCONTROL,
+        VK_LMENU, VK_RMENU, VK_LSHIFT,   VK_RSHIFT,
+    };
+
+    UINT pressed = 0;
+    for (DWORD vk : modifierVks) {
+        if (GetAsyncKeyState(vk) & 0x8000) {
+            pressed |= ModifierBitFromVk(vk);
+        }
     }
 
-    const int NUM_KEYS = static_cast<int>(keys.size());
-    std::unique_ptr<INPUT[]> input(new INPUT[NUM_KEYS * 2]);
+    return pressed;
+}
+
+// Updates the held modifier keys with a keyboard event. Returns true if the
+// event released the last held modifier key, which is when a deferred
+// keypress should be sent. Doesn't depend on any global state.
+bool UpdateHeldModifierKeys(UINT* heldModifiers, DWORD vk, bool keyUp) {
+    UINT bit = ModifierBitFromVk(vk);
+    if (!bit) {
+        return false;
+    }
 
-    for (int i = 0; i < NUM_KEYS; i++) {
+    if (!keyUp) {
+        *heldModifiers |= bit;
+        return false;
+    }
+
+    if (!(*heldModifiers & bit)) {
+        return false;
+    }
+
+    *heldModifiers &= ~bit;
+    return *heldModifiers == 0;
+}
+
+// Builds the input for a virtual key sequence: all keys are pressed in order,
+// then released in order
+std::vector<INPUT> BuildKeypressInput(const std::vector<int>& keys) {
+    std::vector<INPUT> input(keys.size() * 2);
+
+    for (size_t i = 0; i < keys.size(); i++) {
         input[i].type = INPUT_KEYBOARD;
-        input[i].ki.wScan = 0;
-        input[i].ki.time = 0;
-        input[i].ki.dwExtraInfo = 0;
         input[i].ki.wVk = static_cast<WORD>(keys[i]);
         input[i].ki.dwFlags = 0;  // KEYDOWN
-    }
 
-    for (int i = 0; i < NUM_KEYS; i++) {
-        input[NUM_KEYS + i].type = INPUT_KEYBOARD;
-        input[NUM_KEYS + i].ki.wScan = 0;
-        input[NUM_KEYS + i].ki.time = 0;
-        input[NUM_KEYS + i].ki.dwExtraInfo = 0;
-        input[NUM_KEYS + i].ki.wVk = static_cast<WORD>(keys[i]);
-        input[NUM_KEYS + i].ki.dwFlags = KEYEVENTF_KEYUP;
+        input[keys.size() + i].type = INPUT_KEYBOARD;
+        input[keys.size() + i].ki.wVk = static_cast<WORD>(keys[i]);
+        input[keys.size() + i].ki.dwFlags = KEYEVENTF_KEYUP;
     }
 
-    SendInput(NUM_KEYS * 2, input.get(), sizeof(input[0]));
+    return input;
 }
 
-// Timer callback to retry sending keypress when modifier keys are released
-void CALLBACK KeypressRetryTimerProc(HWND, UINT, UINT_PTR timerId, DWORD) {
-    if (!AreModifierKeysPressed()) {
-        // Keys released, send the keypress
-        KillTimer(nullptr, timerId);
-        g_keypressTimerId = 0;
-        Wh_Log(L"Modifier keys released, sending deferred keypress");
-        SendKeypressInternal(g_pendingKeypressKeys);
-        g_pendingKeypressKeys.clear();
-    } else if (++g_pendingKeypressRetryCount >= kMaxKeypressRetryCount) {
-        // Timeout - send anyway
-        KillTimer(nullptr, timerId);
-        g_keypressTimerId = 0;
-        Wh_Log(L"Timeout waiting for modifier keys, sending anyway");
-        SendKeypressInternal(g_pendingKeypressKeys);
-        g_pendingKeypressKeys.clear();
+// Internal function to send a prebuilt virtual key sequence
+void SendKeypressInternal(const std::vector<INPUT>& input) {
+    if (input.empty()) {
+        return;
     }
+
+    SendInput(static_cast<UINT>(input.size()),
+              const_cast<INPUT*>(input.data()), sizeof(INPUT));
 }
 
-// Sends virtual key sequence, deferring if modifier keys are pressed
-void SendKeypress(const std::vector<int>& keys) {
-    if (keys.empty()) {
-        return;
+// Stops waiting for the modifier keys and discards the pending keypress
+void CancelDeferredKeypress() {
+    if (g_keypressKeyboardHook) {
+        UnhookWindowsHookEx(g_keypressKeyboardHook);
+        g_keypressKeyboardHook = nullptr;
     }
 
-    // Cancel any pending keypress
     if (g_keypressTimerId) {
         KillTimer(nullptr, g_keypressTimerId);
         g_keypressTimerId = 0;
     }
 
-    if (AreModifierKeysPressed()) {
-        // Defer keypress - store and start thread timer
-        g_pendingKeypressKeys = keys;
-        g_pendingKeypressRetryCount = 0;
-        g_keypressTimerId = SetTimer(nullptr, 0, kKeypressRetryIntervalMs,
-                                     KeypressRetryTimerProc);
-        Wh_Log(L"Modifier keys pressed, deferring keypress");
-        return;
-    }
-
-    SendKeypressInternal(keys);
+    g_pendingKeypressInput.clear();
+    g_pendingKeypressHeldModifiers = 0;
 }
 
-void SendCtrlAltTabKeypress() {
-    Wh_Log(L"Sending Ctrl+Alt+Tab");
-    SendKeypress({VK_LCONTROL, VK_LMENU, VK_TAB});
+void SendDeferredKeypress() {
+    std::vector<INPUT> input = std::move(g_pendingKeypressInput);
+    CancelDeferredKeypress();
+    SendKeypressInternal(input);
 }
 
-void SendWinTabKeypress() {
-    Wh_Log(L"Sending Win+Tab");
-    SendKeypress({VK_LWIN, VK_TAB});
-}
+// Watches for the modifier keys being released while a keypress is deferred
+LRESULT CALLBACK DeferredKeypressKeyboardProc(int nCode,
+                                              WPARAM wParam,
+                                              LPARAM lParam) {
+    if (nCode == HC_ACTION) {
+        const KBDLLHOOKSTRUCT* kbdHook =
+            reinterpret_cast<const KBDLLHOOKSTRUCT*>(lParam);
+        bool keyUp = wParam == WM_KEYUP || wParam == WM_SYSKEYUP;
+        if (!(kbdHook->flags & LLKHF_INJECTED) &&
+            UpdateHeldModifierKeys(&g_pendingKeypressHeldModifiers,
+                                   kbdHook->vkCode, keyUp)) {
+            Wh_Log(L"Modifier keys released, sending deferred keypress");
+            LRESULT result = CallNextHookEx(nullptr, nCode, wParam, lParam);
+            SendDeferredKeypress();
+            return result;
+        }
+    }
 
-void MediaPlayPause() {
-    Wh_Log(L"Sending Media Play/Pause");
-    SendKeypress({VK_MEDIA_PLAY_PAUSE});
+    return CallNextHookEx(nullptr, nCode, wParam, lParam);
 }
 
-void MediaNext() {
-    Wh_Log(L"Sending Media Next Track");
-    SendKeypress({VK_MEDIA_NEXT_TRACK});
+void CALLBACK DeferredKeypressTimeoutProc(HWND, UINT, UINT_PTR, DWORD) {
+    Wh_Log(L"Timeout waiting for modifier keys, sending anyway");
+    SendDeferredKeypress();
 }
 
-void MediaPrev() {
-    Wh_Log(L"Sending Media Previous Track");
-    SendKeypress({VK_MEDIA_PREV_TRACK});
-}
+// Sends virtual key sequence, deferring if modifier keys are pressed
+void SendKeypress(const std::vector<INPUT>& input) {
+    if (input.empty()) {
+        return;
+    }
 
-void OpenStartMenu() {
-    Wh_Log(L"Sending Win keypress for Start menu");
-    SendKeypress({VK_LWIN});
+    // Cancel any pending keypress
+    CancelDeferredKeypress();
+
+    UINT pressedModifiers = GetPressedModifierKeys();
+    if (pressedModifiers) {
+        // Defer keypress until the modifier keys are released
+        g_pendingKeypressInput = input;
+        g_pendingKeypressHeldModifiers = pressedModifiers;
+        g_keypressKeyboardHook = SetWindowsHookEx(
+            WH_KEYBOARD_LL, DeferredKeypressKeyboardProc, nullptr, 0);
+        if (!g_keypressKeyboardHook) {
+            Wh_Log(L"SetWindowsHookEx failed, error: %u", GetLastError());
+        }
+
+        // Keys released before the hook was installed are never reported.
+        g_pendingKeypressHeldModifiers &= GetPressedModifierKeys();
+        if (!g_pendingKeypressHeldModifiers) {
+            SendDeferredKeypress();
+            return;
+        }
+
+        g_keypressTimerId = SetTimer(nullptr, 0, kDeferredKeypressTimeoutMs,
+                                     DeferredKeypressTimeoutProc);
+        Wh_Log(L"Modifier keys pressed, deferring keypress");
+        return;
+    }
+
+    SendKeypressInternal(input);
 }
 
 void OpenTaskManager() {
@@ -1256,20 +1346,38 @@ std::tuple<std::wstring, std::wstring> ParseExecutableAndParameters(
                            stringtools::trim(parameters));
 }
 
-void StartProcess(std::wstring command) {
+// Parses the StartProcess argument, optionally prefixed with "uac;"
+void ParseStartProcessCommand(std::wstring command,
+                              std::wstring* verb,
+                              std::wstring* executable,
+                              std::wstring* parameters) {
+    *verb = L"open";
+    executable->clear();
+    parameters->clear();
+
     if (command.empty()) {
         return;
     }
 
     std::vector<std::wstring> uac_args = SplitArgs(command, L';');
-    std::wstring verb = L"open";
-    if (stringtools::toLower(uac_args[0]) == L"uac") {
-        verb = L"runas";
-        command = stringtools::ltrim(command.substr(uac_args[0].length() + 1));
+    if (!uac_args.empty() && stringtools::toLower(uac_args[0]) == L"uac") {
+        *verb = L"runas";
+        size_t prefixLen = command.find(L';');
+        command = prefixLen == std::wstring::npos
+                      ? std::wstring()
+                      : stringtools::ltrim(command.substr(prefixLen + 1));
     }
 
-    const auto [executable, parameters] = ParseExecutableAndParameters(command);
-    Wh_Log(L"Starting: %s %s", executable.c_str(), parameters.c_str());
+    std::tie(*executable, *parameters) = ParseExecutableAndParameters(command);
+}
+
+void StartProcess(const HotkeyActionPlan& plan) {
+    if (plan.processExecutable.empty()) {
+        return;
+    }
+
+    Wh_Log(L"Starting: %s %s", plan.processExecutable.c_str(),
+           plan.processParameters.c_str());
 
     POINT cursorPos;
     GetCursorPos(&cursorPos);
@@ -1277,9 +1385,11 @@ void StartProcess(std::wstring command) {
 
     SHELLEXECUTEINFO sei = {sizeof(sei)};
     sei.fMask = SEE_MASK_HMONITOR | SEE_MASK_NOASYNC | SEE_MASK_FLAG_NO_UI;
-    sei.lpVerb = verb.c_str();
-    sei.lpFile = executable.c_str();
-    sei.lpParameters = parameters.empty() ? NULL : parameters.c_str();
+    sei.lpVerb = plan.processVerb.c_str();
+    sei.lpFile = plan.processExecutable.c_str();
+    sei.lpParameters = plan.processParameters.empty()
+                           ? NULL
+                           : plan.processParameters.c_str();
     sei.nShow = SW_SHOWNORMAL;
     sei.hMonitor = hMonitor;
 
@@ -1394,54 +1504,114 @@ const wchar_t* ActionTypeToString(HotkeyActionType actionType) {
     return L"Unknown";
 }
 
-// Creates action executor from action type and arguments
-std::function<void()> ParseActionSetting(HotkeyActionType actionType,
-                                         const std::wstring& args) {
+// Prepares what the action needs from its arguments
+HotkeyActionPlan BuildActionPlan(HotkeyActionType actionType,
+                                 const std::wstring& args) {
+    HotkeyActionPlan plan{};
+
     switch (actionType) {
+        case HotkeyActionType::AltTab:
+            plan.keypressInput =
+                BuildKeypressInput({VK_LCONTROL, VK_LMENU, VK_TAB});
+            break;
+        case HotkeyActionType::WinTab:
+            plan.keypressInput = BuildKeypressInput({VK_LWIN, VK_TAB});
+            break;
+        case HotkeyActionType::OpenStartMenu:
+            plan.keypressInput = BuildKeypressInput({VK_LWIN});
+            break;
+        case HotkeyActionType::MediaPlayPause:
+            plan.keypressInput = BuildKeypressInput({VK_MEDIA_PLAY_PAUSE});
+            break;
+        case HotkeyActionType::MediaNext:
+            plan.keypressInput = BuildKeypressInput({VK_MEDIA_NEXT_TRACK});
+            break;
+        case HotkeyActionType::MediaPrev:
+            plan.keypressInput = BuildKeypressInput({VK_MEDIA_PREV_TRACK});
+            break;
+        case HotkeyActionType::SendKeypress:
+            plan.keypressInput =
+                BuildKeypressInput(ParseVirtualKeypressSetting(args));
+            break;
+        case HotkeyActionType::StartProcess:
+            ParseStartProcessCommand(stringtools::trim(args), &plan.processVerb,
+                                     &plan.processExecutable,
+                                     &plan.processParameters);
+            break;
+        case HotkeyActionType::CombineTaskbarButtons:
+            std::tie(plan.combineStates[0], plan.combineStates[1],
+                     plan.combineStates[2], plan.combineStates[3]) =
+                ParseTaskBarButtonsState(args);
+            break;
+        default:
+            break;
+    }
+
+    return plan;
+}
+
+// Runs the action using its prepared plan
+void ExecuteAction(const HotkeyAction& action) {
+    const HotkeyActionPlan& plan = action.plan;
+
+    switch (action.actionType) {
         case HotkeyActionType::Nothing:
-            return []() {};
+            break;
         case HotkeyActionType::ShowDesktop:
-            return []() { ShowDesktop(); };
+            ShowDesktop();
+            break;
         case HotkeyActionType::AltTab:
-            return []() { SendCtrlAltTabKeypress(); };
+            Wh_Log(L"Sending Ctrl+Alt+Tab");
+            SendKeypress(plan.keypressInput);
+            break;
         case HotkeyActionType::TaskManager:
-            return []() { OpenTaskManager(); };
+            OpenTaskManager();
+            break;
         case HotkeyActionType::Mute:
-            return []() { ToggleVolMuted(); };
+            ToggleVolMuted();
+            break;
         case HotkeyActionType::TaskbarAutohide:
-            return []() { ToggleTaskbarAutohide(); };
+            ToggleTaskbarAutohide();
+            break;
         case HotkeyActionType::WinTab:
-            return []() { SendWinTabKeypress(); };
+            Wh_Log(L"Sending Win+Tab");
+            SendKeypress(plan.keypressInput);
+            break;
         case HotkeyActionType::HideIcons:
-            return []() { HideIcons(); };
-        case HotkeyActionType::CombineTaskbarButtons: {
-            const auto [s1, s2, s3, s4] = ParseTaskBarButtonsState(args);
-            return
-                [s1, s2, s3, s4]() { CombineTaskbarButtons(s1, s2, s3, s4); };
-        }
+            HideIcons();
+            break;
+        case HotkeyActionType::CombineTaskbarButtons:
+            CombineTaskbarButtons(plan.combineStates[0], plan.combineStates[1],
+                                  plan.combineStates[2],
+                                  plan.combineStates[3]);
+            break;
         case HotkeyActionType::ToggleTaskbarAlignment:
-            return []() { ToggleTaskbarAlignment(); };
+            ToggleTaskbarAlignment();
+            break;
         case HotkeyActionType::OpenStartMenu:
-            return []() { OpenStartMenu(); };
-        case HotkeyActionType::SendKeypress: {
-            const auto keyCodes = ParseVirtualKeypressSetting(args);
-            return [keyCodes]() {
-                Wh_Log(L"Sending %zu keypresses", keyCodes.size());
-                SendKeypress(keyCodes);
-            };
-        }
-        case HotkeyActionType::StartProcess: {
-            std::wstring cmd = stringtools::trim(args);
-            return [cmd]() { StartProcess(cmd); };
-        }
+            Wh_Log(L"Sending Win keypress for Start menu");
+            SendKeypress(plan.keypressInput);
+            break;
+        case HotkeyActionType::SendKeypress:
+            Wh_Log(L"Sending %zu keypresses", plan.keypressInput.size() / 2);
+            SendKeypress(plan.keypressInput);
+            break;
+        case HotkeyActionType::StartProcess:
+            StartProcess(plan);
+            break;
         case HotkeyActionType::MediaPlayPause:
-            return []() { MediaPlayPause(); };
+            Wh_Log(L"Sending Media Play/Pause");
+            SendKeypress(plan.keypressInput);
+            break;
         case HotkeyActionType::MediaNext:
-            return []() { MediaNext(); };
+            Wh_Log(L"Sending Media Next Track");
+            SendKeypress(plan.keypressInput);
+            break;
         case HotkeyActionType::MediaPrev:
-            return []() { MediaPrev(); };
+            Wh_Log(L"Sending Media Previous Track");
+            SendKeypress(plan.keypressInput);
+            break;
     }
-    return []() {};
 }
 
 #pragma endregion  // actions
@@ -1457,15 +1627,16 @@ LRESULT CALLBACK TaskbarWindowSubclassProc(_In_ HWND hWnd,
                                            _In_ DWORD_PTR dwRefData) {
     switch (uMsg) {
         case WM_HOTKEY: {
-            int hotkeyId = static_cast<int>(wParam);
-            for (const auto& action : g_settings.hotkeyActions) {
-                if (action.registered && action.hotkeyId == hotkeyId) {
+            // Hotkey ids are kHotkeyIdBase + the action index.
+            size_t index = static_cast<size_t>(static_cast<int>(wParam) -
+                                               kHotkeyIdBase);
+            if (index < g_settings.hotkeyActions.size()) {
+                const auto& action = g_settings.hotkeyActions[index];
+                if (action.registered) {
                     Wh_Log(L"Hotkey %s triggered, executing %s",
                            action.hotkeyString.c_str(),
                            ActionTypeToString(action.actionType));
-                    if (action.actionExecutor) {
-                        action.actionExecutor();
-                    }
+                    ExecuteAction(action);
                     return 0;
                 }
             }
@@ -1486,6 +1657,7 @@ LRESULT CALLBACK TaskbarWindowSubclassProc(_In_ HWND hWnd,
             }
 
             if (uMsg == g_uninitCOMMsg) {
+                CancelDeferredKeypress();
                 g_audioCOM.Uninit();
                 return 0;
             }
@@ -1606,7 +1778,7 @@ void LoadSettings() {
         action.hotkeyString = hotkeyStr;
         action.actionType = actionType;
         action.additionalArgs = argsStr;
-        action.actionExecutor = ParseActionSetting(actionType, argsStr);
+        action.plan = BuildActionPlan(actionType, argsStr);
         action.modifiers = 0;
         action.vk = 0;
         action.hotkeyId = 0;
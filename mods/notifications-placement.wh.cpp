@@ -2,7 +2,7 @@
 // @id              notifications-placement
 // @name            Customize Windows notifications placement
 // @description     Move notifications to another monitor or another corner of the screen
-// @version         1.2.4
+// @version         1.2.6
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -125,9 +125,12 @@ number when both are configured.
 #include <winrt/Windows.UI.Xaml.h>
 #include <winrt/base.h>
 
+#include <algorithm>
 #include <atomic>
 #include <functional>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -176,6 +179,24 @@ bool g_inCToastCenterExperienceManager_PositionView;
 
 bool g_customAnimationDirectionApplied;
 
+// Whether a window is a ShellExperienceHost CoreWindow. This doesn't change
+// during the window's lifetime, and an entry is only reused if the window's
+// thread and process still match. SetWindowPos is called from any thread.
+struct CoreWindowCacheEntry {
+    DWORD threadId;
+    DWORD processId;
+    bool isShellExperienceHostCoreWindow;
+};
+
+// Entries of destroyed windows are pruned when the cache grows beyond the
+// threshold, which is then raised so that a cache full of live windows isn't
+// swept on every insertion.
+constexpr size_t kCoreWindowCachePruneSize = 256;
+
+std::mutex g_coreWindowCacheMutex;
+std::unordered_map<HWND, CoreWindowCacheEntry> g_coreWindowCache;
+size_t g_coreWindowCachePruneThreshold = kCoreWindowCachePruneSize;
+
 WINUSERAPI UINT WINAPI GetDpiForWindow(HWND hwnd);
 typedef enum MONITOR_DPI_TYPE {
     MDT_EFFECTIVE_DPI = 0,
@@ -320,20 +341,65 @@ FrameworkElement FindChildByClassName(FrameworkElement element,
     });
 }
 
-bool IsTargetCoreWindow(HWND hWnd) {
-    DWORD processId = 0;
-    if (!hWnd || !GetWindowThreadProcessId(hWnd, &processId)) {
+bool IsShellExperienceHostCoreWindow(HWND hWnd,
+                                     DWORD threadId,
+                                     DWORD processId) {
+    {
+        std::lock_guard<std::mutex> guard(g_coreWindowCacheMutex);
+
+        auto it = g_coreWindowCache.find(hWnd);
+        if (it != g_coreWindowCache.end() &&
+            it->second.threadId == threadId &&
+            it->second.processId == processId) {
+            return it->second.isShellExperienceHostCoreWindow;
+        }
+    }
+
+    WCHAR szClassName[32];
+    if (GetClassName(hWnd, szClassName, ARRAYSIZE(szClassName)) == 0) {
         return false;
     }
 
-    if (_wcsicmp(GetProcessFileName(processId).c_str(),
-                 L"ShellExperienceHost.exe") != 0) {
+    bool result = false;
+
+    if (_wcsicmp(szClassName, L"Windows.UI.Core.CoreWindow") == 0) {
+        if (g_target == Target::ShellExperienceHost &&
+            processId == GetCurrentProcessId()) {
+            result = true;
+        } else {
+            std::wstring processFileName = GetProcessFileName(processId);
+            if (processFileName.empty()) {
+                // The process couldn't be queried, don't cache the result.
+                return false;
+            }
+
+            result = _wcsicmp(processFileName.c_str(),
+                              L"ShellExperienceHost.exe") == 0;
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(g_coreWindowCacheMutex);
+
+    if (g_coreWindowCache.size() >= g_coreWindowCachePruneThreshold) {
+        std::erase_if(g_coreWindowCache,
+                      [](const auto& item) { return !IsWindow(item.first); });
+        g_coreWindowCachePruneThreshold =
+            std::max(kCoreWindowCachePruneSize, g_coreWindowCache.size() * 2);
+    }
+
+    g_coreWindowCache[hWnd] = {threadId, processId, result};
+
+    return result;
+}
+
+bool IsTargetCoreWindow(HWND hWnd) {
+    DWORD processId = 0;
+    DWORD threadId = hWnd ? GetWindowThreadProcessId(hWnd, &processId) : 0;
+    if (!threadId) {
         return false;
     }
 
-    WCHAR szClassName[32];
-    if (GetClassName(hWnd, szClassName, ARRAYSIZE(szClassName)) == 0 ||
-        _wcsicmp(szClassName, L"Windows.UI.Core.CoreWindow") != 0) {
+    if (!IsShellExperienceHostCoreWindow(hWnd, threadId, processId)) {
         return false;
     }
 
@@ -2,7 +2,7 @@
 // @id              shell-flyout-positions
 // @name            Shell Flyout Positions
 // @description     Customize the position of the Notification Center, Action Center, and Start menu on Windows 11
-// @version         1.3
+// @version         1.3.2
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -147,11 +147,17 @@ shift options allow fine-tuning in both directions.
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 using namespace winrt::Windows::UI::Xaml;
@@ -471,30 +477,184 @@ void RestoreSearchMenuToDefault() {
     }
 }
 
-// Must run on a worker thread to avoid COM deadlock when called from the
-// taskbar thread.
-std::optional<RECT> GetShowDesktopButtonBoundsWorker(HWND hTaskbarWnd) {
-    // Initialize COM for this thread.
-    HRESULT hrInit = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
-    if (FAILED(hrInit) && hrInit != RPC_E_CHANGED_MODE) {
+// UI Automation queries run on a single long-lived worker thread, to avoid a
+// COM deadlock when called from the taskbar thread. The worker keeps the
+// automation object, and the elements it found for each taskbar window so
+// that the tree isn't searched again on each query. The automation calls time
+// out before the callers stop waiting, so that a hung provider can't block the
+// worker, and tasks whose callers already gave up are skipped.
+constexpr DWORD kAutomationCallerTimeoutMs = 1000;
+constexpr DWORD kAutomationConnectionTimeoutMs = 300;
+constexpr DWORD kAutomationTransactionTimeoutMs = 500;
+
+struct TaskbarAutomationElements {
+    RECT taskbarRect;
+    UINT taskbarDpi;
+    winrt::com_ptr<IUIAutomationElement> startButton;
+    winrt::com_ptr<IUIAutomationElement> showDesktopButton;
+};
+
+std::mutex g_automationWorkerMutex;
+std::condition_variable g_automationWorkerCondition;
+std::deque<std::packaged_task<std::optional<RECT>()>> g_automationWorkerTasks;
+bool g_automationWorkerStop;
+std::thread g_automationWorkerThread;
+
+// Only accessed from the worker thread.
+winrt::com_ptr<IUIAutomation> g_automation;
+std::unordered_map<HWND, TaskbarAutomationElements>
+    g_taskbarAutomationElements;
+
+void AutomationWorkerThread() {
+    HRESULT hrInit = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    if (FAILED(hrInit)) {
         Wh_Log(L"Failed to initialize COM: 0x%08X", hrInit);
-        return std::nullopt;
+    } else {
+        g_automation =
+            winrt::try_create_instance<IUIAutomation>(CLSID_CUIAutomation);
+        if (!g_automation) {
+            Wh_Log(L"Failed to create IUIAutomation instance");
+        } else if (auto automation2 = g_automation.try_as<IUIAutomation2>()) {
+            automation2->put_ConnectionTimeout(kAutomationConnectionTimeoutMs);
+            automation2->put_TransactionTimeout(
+                kAutomationTransactionTimeoutMs);
+        }
+    }
+
+    while (true) {
+        std::packaged_task<std::optional<RECT>()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(g_automationWorkerMutex);
+            g_automationWorkerCondition.wait(lock, []() {
+                return g_automationWorkerStop ||
+                       !g_automationWorkerTasks.empty();
+            });
+
+            // Pending tasks are still run so that their callers get a result.
+            if (g_automationWorkerTasks.empty()) {
+                break;
+            }
+
+            task = std::move(g_automationWorkerTasks.front());
+            g_automationWorkerTasks.pop_front();
+        }
+
+        task();
+    }
+
+    g_taskbarAutomationElements.clear();
+    g_automation = nullptr;
+
+    if (SUCCEEDED(hrInit)) {
+        CoUninitialize();
     }
+}
 
-    // Ensure COM is uninitialized when we exit.
-    struct ComUninit {
-        HRESULT hr;
-        ~ComUninit() {
-            if (SUCCEEDED(hr)) {
-                CoUninitialize();
+std::optional<RECT> RunOnAutomationWorker(PCWSTR name,
+                                          std::optional<RECT> (*proc)(HWND),
+                                          HWND hTaskbarWnd) {
+    auto abandoned = std::make_shared<std::atomic<bool>>(false);
+    std::packaged_task<std::optional<RECT>()> task(
+        [proc, hTaskbarWnd, abandoned]() -> std::optional<RECT> {
+            if (*abandoned) {
+                return std::nullopt;
             }
+
+            return proc(hTaskbarWnd);
+        });
+    auto future = task.get_future();
+
+    {
+        std::lock_guard<std::mutex> guard(g_automationWorkerMutex);
+        if (g_automationWorkerStop) {
+            return std::nullopt;
+        }
+
+        if (!g_automationWorkerThread.joinable()) {
+            g_automationWorkerThread = std::thread(AutomationWorkerThread);
         }
-    } comUninit{hrInit};
 
-    winrt::com_ptr<IUIAutomation> automation =
-        winrt::try_create_instance<IUIAutomation>(CLSID_CUIAutomation);
+        g_automationWorkerTasks.push_back(std::move(task));
+    }
+
+    g_automationWorkerCondition.notify_one();
+
+    // Wait with timeout. If the task didn't start yet, it's skipped.
+    if (future.wait_for(std::chrono::milliseconds(
+            kAutomationCallerTimeoutMs)) == std::future_status::timeout) {
+        Wh_Log(L"%s timed out", name);
+        *abandoned = true;
+        return std::nullopt;
+    }
+
+    return future.get();
+}
+
+void StopAutomationWorker() {
+    {
+        std::lock_guard<std::mutex> guard(g_automationWorkerMutex);
+        g_automationWorkerStop = true;
+    }
+
+    g_automationWorkerCondition.notify_one();
+
+    if (g_automationWorkerThread.joinable()) {
+        g_automationWorkerThread.join();
+    }
+}
+
+// Returns the cached elements of a taskbar. They're dropped if the taskbar was
+// resized or its DPI changed since they were found, since the taskbar content
+// might have been rebuilt. A recreated taskbar (e.g. after TaskbarCreated) has
+// a new window, and entries of destroyed windows are dropped here too.
+TaskbarAutomationElements& GetTaskbarAutomationElements(HWND hTaskbarWnd) {
+    std::erase_if(g_taskbarAutomationElements,
+                  [](const auto& item) { return !IsWindow(item.first); });
+
+    RECT taskbarRect{};
+    GetWindowRect(hTaskbarWnd, &taskbarRect);
+
+    UINT taskbarDpiX = 96;
+    UINT taskbarDpiY = 96;
+    GetDpiForMonitor(MonitorFromWindow(hTaskbarWnd, MONITOR_DEFAULTTONEAREST),
+                     MDT_DEFAULT, &taskbarDpiX, &taskbarDpiY);
+
+    TaskbarAutomationElements& elements =
+        g_taskbarAutomationElements[hTaskbarWnd];
+    if (!EqualRect(&elements.taskbarRect, &taskbarRect) ||
+        elements.taskbarDpi != taskbarDpiX) {
+        elements.taskbarRect = taskbarRect;
+        elements.taskbarDpi = taskbarDpiX;
+        elements.startButton = nullptr;
+        elements.showDesktopButton = nullptr;
+    }
+
+    return elements;
+}
+
+// The element's position can change without the taskbar being resized (e.g.
+// centered taskbar buttons), so the bounds are always queried. The element is
+// dropped if it's no longer valid.
+bool GetCachedElementBounds(winrt::com_ptr<IUIAutomationElement>& element,
+                            RECT* boundingRect) {
+    if (!element) {
+        return false;
+    }
+
+    if (FAILED(element->get_CurrentBoundingRectangle(boundingRect)) ||
+        IsRectEmpty(boundingRect)) {
+        element = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+// Runs on the automation worker thread.
+std::optional<RECT> GetShowDesktopButtonBoundsWorker(HWND hTaskbarWnd) {
+    winrt::com_ptr<IUIAutomation> automation = g_automation;
     if (!automation) {
-        Wh_Log(L"Failed to create IUIAutomation instance");
         return std::nullopt;
     }
 
@@ -565,6 +725,15 @@ std::optional<RECT> GetShowDesktopButtonBoundsWorker(HWND hTaskbarWnd) {
         return child;
     };
 
+    TaskbarAutomationElements& cachedElements =
+        GetTaskbarAutomationElements(hTaskbarWnd);
+
+    RECT boundingRect;
+    if (GetCachedElementBounds(cachedElements.showDesktopButton,
+                               &boundingRect)) {
+        return boundingRect;
+    }
+
     // The DesktopWindowContentBridge is a child HWND, not a UI Automation
     // child.
     HWND hBridgeWnd = FindWindowEx(
@@ -598,7 +767,6 @@ std::optional<RECT> GetShowDesktopButtonBoundsWorker(HWND hTaskbarWnd) {
     }
 
     // Get bounds from the element.
-    RECT boundingRect;
     hr = targetElement->get_CurrentBoundingRectangle(&boundingRect);
     if (FAILED(hr)) {
         Wh_Log(L"Failed to get bounding rectangle");
@@ -608,48 +776,29 @@ std::optional<RECT> GetShowDesktopButtonBoundsWorker(HWND hTaskbarWnd) {
     Wh_Log(L"ShowDesktopButton bounds: %d,%d,%d,%d", boundingRect.left,
            boundingRect.top, boundingRect.right, boundingRect.bottom);
 
+    cachedElements.showDesktopButton = targetElement;
+
     return boundingRect;
 }
 
 std::optional<RECT> GetShowDesktopButtonBounds(HWND hTaskbarWnd) {
-    // Run on a separate thread to avoid COM deadlock when called from the
-    // taskbar thread.
-    auto future = std::async(std::launch::async,
-                             GetShowDesktopButtonBoundsWorker, hTaskbarWnd);
-
-    // Wait with timeout.
-    if (future.wait_for(std::chrono::milliseconds(1000)) ==
-        std::future_status::timeout) {
-        Wh_Log(L"GetShowDesktopButtonBounds timed out");
-        return std::nullopt;
-    }
-
-    return future.get();
+    return RunOnAutomationWorker(L"GetShowDesktopButtonBounds",
+                                 GetShowDesktopButtonBoundsWorker, hTaskbarWnd);
 }
 
-// Must run on a worker thread to avoid COM deadlock when called from the
-// taskbar thread.
+// Runs on the automation worker thread.
 std::optional<RECT> GetStartButtonBoundsWorker(HWND hTaskbarWnd) {
-    HRESULT hrInit = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
-    if (FAILED(hrInit) && hrInit != RPC_E_CHANGED_MODE) {
-        Wh_Log(L"Failed to initialize COM: 0x%08X", hrInit);
+    winrt::com_ptr<IUIAutomation> automation = g_automation;
+    if (!automation) {
         return std::nullopt;
     }
 
-    struct ComUninit {
-        HRESULT hr;
-        ~ComUninit() {
-            if (SUCCEEDED(hr)) {
-                CoUninitialize();
-            }
-        }
-    } comUninit{hrInit};
+    TaskbarAutomationElements& cachedElements =
+        GetTaskbarAutomationElements(hTaskbarWnd);
 
-    winrt::com_ptr<IUIAutomation> automation =
-        winrt::try_create_instance<IUIAutomation>(CLSID_CUIAutomation);
-    if (!automation) {
-        Wh_Log(L"Failed to create IUIAutomation instance");
-        return std::nullopt;
+    RECT boundingRect;
+    if (GetCachedElementBounds(cachedElements.startButton, &boundingRect)) {
+        return boundingRect;
     }
 
     _bstr_t automationIdBstr(L"StartButton");
@@ -680,7 +829,6 @@ std::optional<RECT> GetStartButtonBoundsWorker(HWND hTaskbarWnd) {
         return std::nullopt;
     }
 
-    RECT boundingRect;
     hr = startButton->get_CurrentBoundingRectangle(&boundingRect);
     if (FAILED(hr)) {
         Wh_Log(L"Failed to get bounding rectangle");
@@ -690,23 +838,14 @@ std::optional<RECT> GetStartButtonBoundsWorker(HWND hTaskbarWnd) {
     Wh_Log(L"StartButton bounds: %d,%d,%d,%d", boundingRect.left,
            boundingRect.top, boundingRect.right, boundingRect.bottom);
 
+    cachedElements.startButton = startButton;
+
     return boundingRect;
 }
 
 std::optional<RECT> GetStartButtonBounds(HWND hTaskbarWnd) {
-    // Run on a separate thread to avoid COM deadlock when called from the
-    // taskbar thread.
-    auto future =
-        std::async(std::launch::async, GetStartButtonBoundsWorker, hTaskbarWnd);
-
-    // Wait with timeout.
-    if (future.wait_for(std::chrono::milliseconds(1000)) ==
-        std::future_status::timeout) {
-        Wh_Log(L"GetStartButtonBounds timed out");
-        return std::nullopt;
-    }
-
-    return future.get();
+    return RunOnAutomationWorker(L"GetStartButtonBounds",
+                                 GetStartButtonBoundsWorker, hTaskbarWnd);
 }
 
 std::optional<RECT> GetStartButtonBoundsForMonitor(HMONITOR monitor) {
@@ -2205,6 +2344,8 @@ void Wh_ModBeforeUninit() {
 
 void Wh_ModUninit() {
     Wh_Log(L">");
+
+    StopAutomationWorker();
 }
 
 BOOL Wh_ModSettingsChanged(BOOL* bReload) {
@@ -2,7 +2,7 @@
 // @id              taskbar-button-scroll
 // @name            Taskbar minimize/restore on scroll
 // @description     Minimize/restore by scrolling the mouse wheel over taskbar buttons and thumbnail previews
-// @version         1.1.4
+// @version         1.1.5
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -70,7 +70,6 @@ check out [7+ Taskbar Tweaker](https://tweaker.ramensoftware.com/).
 #include <winrt/Windows.UI.Xaml.Media.h>
 
 #include <atomic>
-#include <regex>
 #include <string>
 #include <string_view>
 
@@ -124,10 +123,92 @@ void* CTaskListWnd_SetTaskFilter;
 using CTaskListWnd_GetTaskFilterPtr_t = void** (*)(void*);
 CTaskListWnd_GetTaskFilterPtr_t CTaskListWnd_GetTaskFilterPtr;
 
-size_t OffsetFromAssemblyRegex(void* func,
-                               size_t defValue,
-                               std::regex regex,
-                               int limit = 30) {
+// Matches a single instruction of `length` bytes at `p`. On success, stores the
+// recovered offset in `offset` and returns true.
+using InstructionMatcher_t = bool (*)(const BYTE* p,
+                                      size_t length,
+                                      size_t* offset);
+
+#if defined(_M_X64)
+// Skips an optional REX prefix and returns it, or 0 if there's none.
+BYTE X64SkipRex(const BYTE*& p, const BYTE* end) {
+    if (p < end && (*p & 0xF0) == 0x40) {
+        return *p++;
+    }
+
+    return 0;
+}
+
+// Decodes a `[base+disp]` ModR/M memory operand with a positive 8-bit or
+// 32-bit displacement. SIB and RIP-relative forms aren't supported.
+bool X64DecodeMemDisp(const BYTE* p,
+                      const BYTE* end,
+                      BYTE rex,
+                      int* baseReg,
+                      size_t* disp) {
+    if (p >= end) {
+        return false;
+    }
+
+    BYTE modrm = *p++;
+    BYTE mod = modrm >> 6;
+    BYTE rm = modrm & 7;
+    if (rm == 4 || (mod != 1 && mod != 2)) {
+        return false;
+    }
+
+    INT32 value;
+    if (mod == 1) {
+        if (end - p < 1) {
+            return false;
+        }
+
+        value = (INT8)*p;
+    } else {
+        if (end - p < 4) {
+            return false;
+        }
+
+        memcpy(&value, p, sizeof(value));
+    }
+
+    if (value <= 0) {
+        return false;
+    }
+
+    *baseReg = rm | ((rex & 1) << 3);
+    *disp = value;
+    return true;
+}
+
+bool IsRetInstruction(const BYTE* p, size_t length) {
+    return length == 1 && p[0] == 0xC3;
+}
+#elif defined(_M_ARM64)
+DWORD Arm64Instruction(const BYTE* p, size_t length) {
+    DWORD instruction = 0;
+    if (length == sizeof(instruction)) {
+        memcpy(&instruction, p, sizeof(instruction));
+    }
+
+    return instruction;
+}
+
+bool IsRetInstruction(const BYTE* p, size_t length) {
+    // ret (x30).
+    return Arm64Instruction(p, length) == 0xD65F03C0;
+}
+#else
+#error "Unsupported architecture"
+#endif
+
+// Scans the first `limit` instructions of `func` and returns the offset
+// recovered by the first instruction accepted by `matcher`. Instructions are
+// decoded from their raw bytes, the disassembler is only used for their length.
+size_t OffsetFromAssembly(void* func,
+                          size_t defValue,
+                          InstructionMatcher_t matcher,
+                          int limit = 30) {
     BYTE* p = (BYTE*)func;
     for (int i = 0; i < limit; i++) {
         WH_DISASM_RESULT result;
@@ -135,40 +216,105 @@ size_t OffsetFromAssemblyRegex(void* func,
             break;
         }
 
-        p += result.length;
+        size_t offset;
+        if (matcher(p, result.length, &offset)) {
+            return offset;
+        }
 
-        std::string_view s = result.text;
-        if (s == "ret") {
+        if (IsRetInstruction(p, result.length)) {
             break;
         }
 
-        std::match_results<std::string_view::const_iterator> match;
-        if (std::regex_match(s.begin(), s.end(), match, regex)) {
-            // Wh_Log(L"%S", result.text);
-            return std::stoull(match[1], nullptr, 16);
-        }
+        p += result.length;
     }
 
     Wh_Log(L"Failed for %p", func);
     return defValue;
 }
 
+// Same as OffsetFromAssembly, but the result is stored per module build, keyed
+// by the timestamp and image size of the module containing `func`, so that the
+// scan only runs once for each build.
+size_t OffsetFromAssemblyCached(PCWSTR cacheName,
+                                void* func,
+                                size_t defValue,
+                                InstructionMatcher_t matcher,
+                                int limit = 30) {
+    HMODULE module;
+    if (!GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                               GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           (PCWSTR)func, &module)) {
+        return OffsetFromAssembly(func, defValue, matcher, limit);
+    }
+
+    IMAGE_DOS_HEADER* dosHeader = (IMAGE_DOS_HEADER*)module;
+    IMAGE_NT_HEADERS* ntHeaders =
+        (IMAGE_NT_HEADERS*)((BYTE*)dosHeader + dosHeader->e_lfanew);
+
+    struct {
+        DWORD timeDateStamp;
+        DWORD sizeOfImage;
+        DWORD funcRva;
+        DWORD reserved;
+        ULONGLONG offset;
+    } entry{}, cachedEntry{};
+
+    entry.timeDateStamp = ntHeaders->FileHeader.TimeDateStamp;
+    entry.sizeOfImage = ntHeaders->OptionalHeader.SizeOfImage;
+    entry.funcRva = (DWORD)((BYTE*)func - (BYTE*)module);
+
+    WCHAR valueName[64];
+    swprintf_s(valueName, L"offsetCache_%s", cacheName);
+
+    if (Wh_GetBinaryValue(valueName, &cachedEntry, sizeof(cachedEntry)) ==
+            sizeof(cachedEntry) &&
+        cachedEntry.timeDateStamp == entry.timeDateStamp &&
+        cachedEntry.sizeOfImage == entry.sizeOfImage &&
+        cachedEntry.funcRva == entry.funcRva) {
+        return (size_t)cachedEntry.offset;
+    }
+
+    size_t offset = OffsetFromAssembly(func, defValue, matcher, limit);
+    if (offset != defValue) {
+        entry.offset = offset;
+        Wh_SetBinaryValue(valueName, &entry, sizeof(entry));
+    }
+
+    return offset;
+}
+
 void* Get_TaskItemFilter_For_CTaskListWnd_ITaskListUI(void* pThis_ITaskListUI) {
-    static size_t offset =
+    static size_t offset = OffsetFromAssemblyCached(
+        L"CTaskListWnd_TaskFilter", CTaskListWnd_SetTaskFilter, 0x1F8,
+        [](const BYTE* p, size_t length, size_t* offset) {
 #if defined(_M_X64)
-        OffsetFromAssemblyRegex(CTaskListWnd_SetTaskFilter, 0x1F8,
-                                std::regex(R"(add rcx, 0x([0-9a-f]+))",
-                                           std::regex_constants::icase),
-                                10);
+            // add rcx, imm
+            if (length == 4 && p[0] == 0x48 && p[1] == 0x83 && p[2] == 0xC1) {
+                *offset = (INT8)p[3];
+            } else if (length == 7 && p[0] == 0x48 && p[1] == 0x81 &&
+                       p[2] == 0xC1) {
+                INT32 value;
+                memcpy(&value, p + 3, sizeof(value));
+                *offset = value;
+            } else {
+                return false;
+            }
+
+            return (INT_PTR)*offset > 0;
 #elif defined(_M_ARM64)
-        OffsetFromAssemblyRegex(
-            CTaskListWnd_SetTaskFilter, 0x1F8,
-            std::regex(R"(add\s+x\d+, x\d+, #0x([0-9a-f]+))",
-                       std::regex_constants::icase),
-            10);
+            // add x, x, #imm
+            DWORD instruction = Arm64Instruction(p, length);
+            if ((instruction & 0xFFC00000) != 0x91000000) {
+                return false;
+            }
+
+            *offset = (instruction >> 10) & 0xFFF;
+            return *offset != 0;
 #else
 #error "Unsupported architecture"
 #endif
+        },
+        10);
 
     return *(void**)((DWORD_PTR)pThis_ITaskListUI + offset);
 }
@@ -2,7 +2,7 @@
 // @id              taskbar-grouping
 // @name            Disable grouping on the taskbar
 // @description     Causes a separate button to be created on the taskbar for each new window
-// @version         1.3.10
+// @version         1.3.14
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -217,7 +217,9 @@ bool AddAppIdSuffix(WCHAR appId[MAX_PATH], WCHAR type, DWORD id) {
     return true;
 }
 
-PCWSTR FindAppIdSuffix(PCWSTR appId) {
+// The suffix has a fixed layout, "~Wh~" + type + 8 upper case hex digits, so
+// only the tail of the string has to be checked.
+PCWSTR FindAppIdSuffix(PCWSTR appId, size_t len) {
     auto isUpperHex = [](PCWSTR start, PCWSTR end) {
         for (PCWSTR p = start; p != end; p++) {
             if ((*p < '0' || *p > '9') && (*p < 'A' || *p > 'F')) {
@@ -227,7 +229,6 @@ PCWSTR FindAppIdSuffix(PCWSTR appId) {
         return true;
     };
 
-    size_t len = wcslen(appId);
     if (len <= 13 || appId[len - 13] != L'~' || appId[len - 12] != L'W' ||
         appId[len - 11] != L'h' || appId[len - 10] != L'~' ||
         !isUpperHex(&appId[len - 8], &appId[len])) {
@@ -237,6 +238,10 @@ PCWSTR FindAppIdSuffix(PCWSTR appId) {
     return appId + len - 13;
 }
 
+PCWSTR FindAppIdSuffix(PCWSTR appId) {
+    return FindAppIdSuffix(appId, wcslen(appId));
+}
+
 PWSTR FindAppIdSuffix(PWSTR appId) {
     return const_cast<PWSTR>(FindAppIdSuffix(static_cast<PCWSTR>(appId)));
 }
@@ -884,6 +889,63 @@ PVOID FindTaskBtnGroup(PVOID taskList,
 using CTaskListWnd_IsOnPrimaryTaskband_t = BOOL(WINAPI*)(PVOID pThis);
 CTaskListWnd_IsOnPrimaryTaskband_t CTaskListWnd_IsOnPrimaryTaskband_Original;
 
+// A group can only match a new item in CTaskGroup::DoesWindowMatch if it has
+// the same AppId, ignoring the suffix and the case, or if both have a shortcut
+// ID list. The AppIds are compared first, since that's much cheaper than the
+// full match. ID lists are compared with ILIsEqual semantics, which can match
+// ID lists that differ bytewise, so groups which have one are left for the
+// full match.
+bool IsTaskGroupPlacementCandidate(PVOID taskGroup,
+                                   const ITEMIDLIST* idList,
+                                   PCWSTR appId,
+                                   size_t appIdLen) {
+    if (appId) {
+        if (PCWSTR groupAppId = CTaskGroup_GetAppID_Original(taskGroup)) {
+            size_t groupAppIdLen = wcslen(groupAppId);
+            if (PCWSTR suffix = FindAppIdSuffix(groupAppId, groupAppIdLen)) {
+                groupAppIdLen = suffix - groupAppId;
+            }
+
+            if (CompareStringOrdinal(groupAppId, (int)groupAppIdLen, appId,
+                                     (int)appIdLen, TRUE) == CSTR_EQUAL) {
+                return true;
+            }
+        }
+    }
+
+    if (idList && CTaskGroup_GetShortcutIDList_Original(taskGroup)) {
+        return true;
+    }
+
+    return false;
+}
+
+bool DoesTaskGroupMatchForPlacement(PVOID taskGroup,
+                                    const ITEMIDLIST* idList,
+                                    PCWSTR appId) {
+    if (g_settings.placeUngroupedItemsTogether ==
+        PlaceUngroupedItemsTogetherMode::nonPinnedOnly) {
+        bool pinned = CTaskGroup_GetFlags_Original(taskGroup) & 1;
+        if (pinned) {
+            return false;
+        }
+    }
+
+    g_compareStringOrdinalHookThreadId = GetCurrentThreadId();
+    g_compareStringOrdinalIgnoreSuffix = true;
+
+    int windowMatchConfidence;
+    winrt::com_ptr<IUnknown> taskItemMatched;
+    HRESULT hr = CTaskGroup_DoesWindowMatch_Original(
+        taskGroup, nullptr, idList, appId, &windowMatchConfidence,
+        taskItemMatched.put_void());
+
+    g_compareStringOrdinalHookThreadId = 0;
+    g_compareStringOrdinalIgnoreSuffix = false;
+
+    return SUCCEEDED(hr);
+}
+
 using DPA_InsertPtr_t = decltype(&DPA_InsertPtr);
 DPA_InsertPtr_t DPA_InsertPtr_Original;
 int WINAPI DPA_InsertPtr_Hook(HDPA hdpa, int i, void* p) {
@@ -922,10 +984,19 @@ int WINAPI DPA_InsertPtr_Hook(HDPA hdpa, int i, void* p) {
     const ITEMIDLIST* idList = CTaskGroup_GetShortcutIDList_Original(taskGroup);
     PCWSTR appId = CTaskGroup_GetAppID_Original(taskGroup);
 
+    size_t appIdLen = 0;
+    if (appId) {
+        appIdLen = wcslen(appId);
+        if (PCWSTR suffix = FindAppIdSuffix(appId, appIdLen)) {
+            appIdLen = suffix - appId;
+        }
+    }
+
+    // Look for the last matching group. Without an AppId and an ID list,
+    // there's nothing to filter by, and every group is matched.
     int lastMatchIndex = DA_LAST;
 
-    int count = DPA_GetPtrCount(hdpa);
-    for (int i = 0; i < count; i++) {
+    for (int i = DPA_GetPtrCount(hdpa) - 1; i >= 0; i--) {
         PVOID taskBtnGroupIter = DPA_GetPtr(hdpa, i);
         if (!taskBtnGroupIter) {
             continue;
@@ -936,28 +1007,16 @@ int WINAPI DPA_InsertPtr_Hook(HDPA hdpa, int i, void* p) {
             continue;
         }
 
-        if (g_settings.placeUngroupedItemsTogether ==
-            PlaceUngroupedItemsTogetherMode::nonPinnedOnly) {
-            bool pinned = CTaskGroup_GetFlags_Original(taskGroupIter) & 1;
-            if (pinned) {
-                continue;
-            }
+        if ((appId || idList) &&
+            !IsTaskGroupPlacementCandidate(taskGroupIter, idList, appId,
+                                           appIdLen)) {
+            continue;
         }
 
-        g_compareStringOrdinalHookThreadId = GetCurrentThreadId();
-        g_compareStringOrdinalIgnoreSuffix = true;
-
-        int windowMatchConfidence;
-        winrt::com_ptr<IUnknown> taskItemMatched;
-        HRESULT hr = CTaskGroup_DoesWindowMatch_Original(
-            taskGroupIter, nullptr, idList, appId, &windowMatchConfidence,
-            taskItemMatched.put_void());
-        if (SUCCEEDED(hr)) {
+        if (DoesTaskGroupMatchForPlacement(taskGroupIter, idList, appId)) {
             lastMatchIndex = i;
+            break;
         }
-
-        g_compareStringOrdinalHookThreadId = 0;
-        g_compareStringOrdinalIgnoreSuffix = false;
     }
 
     if (lastMatchIndex != DA_LAST) {
@@ -1321,8 +1380,15 @@ int WINAPI CompareStringOrdinal_Hook(LPCWCH lpString1,
                                      BOOL bIgnoreCase) {
     if (g_compareStringOrdinalHookThreadId == GetCurrentThreadId() &&
         cchCount1 == -1 && cchCount2 == -1) {
-        PCWSTR suffix1 = FindAppIdSuffix(lpString1);
-        PCWSTR suffix2 = FindAppIdSuffix(lpString2);
+        // Pass the lengths to the original function, so that it doesn't have
+        // to find them again.
+        size_t len1 = wcslen(lpString1);
+        size_t len2 = wcslen(lpString2);
+        cchCount1 = static_cast<int>(len1);
+        cchCount2 = static_cast<int>(len2);
+
+        PCWSTR suffix1 = FindAppIdSuffix(lpString1, len1);
+        PCWSTR suffix2 = FindAppIdSuffix(lpString2, len2);
 
         if (g_compareStringOrdinalAnySuffixEqual) {
             if (suffix1 && suffix2) {
@@ -2,7 +2,7 @@
 // @id              taskbar-scroll-actions
 // @name            Taskbar Scroll Actions
 // @description     Assign actions for scrolling over the taskbar, including virtual desktop switching, brightness control, and microphone volume control
-// @version         1.2
+// @version         1.2.2
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -117,6 +117,9 @@ issue](https://tweaker.userecho.com/topics/826-scroll-on-trackpadtouchpad-doesnt
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <optional>
 #include <string_view>
 #include <thread>
@@ -610,361 +613,522 @@ bool IsPointInsideEntryScrollArea(HWND hMMTaskbarWnd,
 
 #pragma region brightness
 
-// Reference:
-// https://github.com/stefankueng/tools/blob/e7cd50c6ac3a50f6dac84c6aace519349164155e/Misc/AAClr/src/Utils.cpp
+// Brightness changes are done by a single background thread, since DDC/CI
+// calls take tens of ms each (they go over the monitor's I2C bus) and WMI calls
+// are slow too. Clicks which arrive while a change is in progress are summed up
+// and applied as a single change, and the physical monitor handles, the last
+// known brightness values and the WMI connection are kept between changes.
+
+// The minimal interval between two brightness changes. DDC/CI monitors need a
+// pause between commands; clicks which arrive meanwhile are folded into the
+// next change.
+constexpr DWORD kBrightnessChangeIntervalMs = 50;
+
+// How long a brightness value which was read or written is trusted. After
+// that it's read again, in case it was changed by other means, e.g. with the
+// monitor's buttons.
+constexpr DWORD kBrightnessValueCacheMs = 2000;
+
+// How long to wait before retrying DDC/CI for a monitor which doesn't support
+// it, e.g. a laptop's built-in display, which is controlled via WMI instead.
+constexpr DWORD kDdcCiRetryMs = 10000;
+
+std::mutex g_brightnessMutex;
+std::condition_variable g_brightnessCondition;
+std::vector<std::pair<HMONITOR, int>> g_brightnessPendingChanges;
+// Set on a display change, the physical monitor handles are enumerated again.
+bool g_brightnessResetMonitors;
+bool g_brightnessStop;
+std::thread g_brightnessThread;
 
-int GetBrightnessWmi() {
-    int ret = -1;
+// DDC/CI brightness control (for external monitors).
+// VCP code 0x10 = Luminance (Brightness) per MCCS standard.
 
-    IWbemLocator* pLocator = NULL;
-    IWbemServices* pNamespace = 0;
-    IEnumWbemClassObject* pEnum = NULL;
-    HRESULT hr = S_OK;
+struct DdcCiMonitor {
+    HMONITOR hMonitor;
+    std::vector<PHYSICAL_MONITOR> physical;
+    // The brightness range and value of each physical monitor.
+    struct Brightness {
+        DWORD min;
+        DWORD current;
+        DWORD max;
+        bool known;
+    };
+    std::vector<Brightness> brightness;
+    DWORD lastAccessTime;
+    // The physical monitors couldn't be enumerated, or their brightness
+    // couldn't be read or written. Retried after kDdcCiRetryMs, unless DDC/CI
+    // worked for this monitor before.
+    bool noDdcCi;
+    // A brightness value was read or written successfully at least once. A
+    // later failure is then treated as a transient error, and WMI is never
+    // used for this monitor.
+    bool ddcCiWorked;
+};
+
+// Brightness thread only.
+std::vector<DdcCiMonitor> g_ddcCiMonitors;
+
+// Returns the cached physical monitors of a monitor, enumerating them if
+// they're not cached yet, or if `forceEnumerate` is set.
+DdcCiMonitor* GetDdcCiMonitor(HMONITOR hMonitor, bool forceEnumerate = false) {
+    bool ddcCiWorked = false;
+
+    auto it = std::find_if(
+        g_ddcCiMonitors.begin(), g_ddcCiMonitors.end(),
+        [hMonitor](const DdcCiMonitor& m) { return m.hMonitor == hMonitor; });
+    if (it != g_ddcCiMonitors.end()) {
+        if (!forceEnumerate &&
+            (!it->noDdcCi ||
+             (!it->ddcCiWorked &&
+              GetTickCount() - it->lastAccessTime < kDdcCiRetryMs))) {
+            return &*it;
+        }
 
-    BSTR path = SysAllocString(L"root\\wmi");
-    BSTR ClassPath = SysAllocString(L"WmiMonitorBrightness");
-    BSTR bstrQuery = SysAllocString(L"Select * from WmiMonitorBrightness");
+        ddcCiWorked = it->ddcCiWorked;
 
-    if (!path || !ClassPath) {
-        goto cleanup;
+        if (!it->physical.empty()) {
+            DestroyPhysicalMonitors((DWORD)it->physical.size(),
+                                    it->physical.data());
+        }
+        g_ddcCiMonitors.erase(it);
     }
 
-    // Initialize COM as MTA so WMI calls are direct (no cross-apartment
-    // proxy). This function is meant to be called from a worker thread.
+    DdcCiMonitor monitor{hMonitor};
+    monitor.lastAccessTime = GetTickCount();
+    monitor.ddcCiWorked = ddcCiWorked;
 
-    hr = CoInitializeEx(0, COINIT_MULTITHREADED);
-    if (FAILED(hr)) {
-        goto cleanup;
+    DWORD numPhysical = 0;
+    if (!GetNumberOfPhysicalMonitorsFromHMONITOR(hMonitor, &numPhysical) ||
+        numPhysical == 0) {
+        monitor.noDdcCi = true;
+        return &g_ddcCiMonitors.emplace_back(std::move(monitor));
     }
 
-    hr = CoCreateInstance(CLSID_WbemLocator, 0, CLSCTX_INPROC_SERVER,
-                          IID_IWbemLocator, (LPVOID*)&pLocator);
-    if (FAILED(hr)) {
-        goto cleanup;
-    }
-    hr = pLocator->ConnectServer(path, NULL, NULL, NULL, 0, NULL, NULL,
-                                 &pNamespace);
-    if (hr != WBEM_S_NO_ERROR) {
-        goto cleanup;
+    monitor.physical.resize(numPhysical);
+    if (!GetPhysicalMonitorsFromHMONITOR(hMonitor, numPhysical,
+                                         monitor.physical.data())) {
+        monitor.physical.clear();
+        monitor.noDdcCi = true;
+        return &g_ddcCiMonitors.emplace_back(std::move(monitor));
     }
 
-    hr = CoSetProxyBlanket(pNamespace, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE,
-                           NULL, RPC_C_AUTHN_LEVEL_PKT,
-                           RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE);
+    monitor.brightness.resize(numPhysical);
+    return &g_ddcCiMonitors.emplace_back(std::move(monitor));
+}
 
-    if (hr != WBEM_S_NO_ERROR) {
-        goto cleanup;
+void DestroyDdcCiMonitors() {
+    for (auto& monitor : g_ddcCiMonitors) {
+        if (!monitor.physical.empty()) {
+            DestroyPhysicalMonitors((DWORD)monitor.physical.size(),
+                                    monitor.physical.data());
+        }
     }
 
-    hr = pNamespace->ExecQuery(
-        _bstr_t(L"WQL"),               // Query Language
-        bstrQuery,                     // Query to Execute
-        WBEM_FLAG_RETURN_IMMEDIATELY,  // Make a semi-synchronous call
-        NULL,                          // Context
-        &pEnum                         // Enumeration Interface
-    );
-
-    if (hr != WBEM_S_NO_ERROR) {
-        goto cleanup;
-    }
+    g_ddcCiMonitors.clear();
+}
 
-    hr = WBEM_S_NO_ERROR;
+// Returns whether the brightness of any of the physical monitors was changed.
+bool ApplyBrightnessDdcCi(DdcCiMonitor* monitor, int delta) {
+    bool reread = GetTickCount() - monitor->lastAccessTime >
+                  kBrightnessValueCacheMs;
 
-    while (WBEM_S_NO_ERROR == hr) {
-        ULONG ulReturned;
-        IWbemClassObject* pObj;
+    bool anySuccess = false;
 
-        // Get the Next Object from the collection
-        hr = pEnum->Next(WBEM_INFINITE,  // Timeout
-                         1,              // No of objects requested
-                         &pObj,          // Returned Object
-                         &ulReturned     // No of object returned
-        );
+    for (size_t i = 0; i < monitor->physical.size(); i++) {
+        auto& physical = monitor->physical[i];
+        auto& brightness = monitor->brightness[i];
+        if (reread || !brightness.known) {
+            brightness.known = GetMonitorBrightness(
+                physical.hPhysicalMonitor, &brightness.min,
+                &brightness.current, &brightness.max);
+            if (!brightness.known) {
+                continue;
+            }
 
-        if (hr != WBEM_S_NO_ERROR) {
-            goto cleanup;
+            monitor->ddcCiWorked = true;
         }
 
-        VARIANT var1;
-        hr = pObj->Get(_bstr_t(L"CurrentBrightness"), 0, &var1, NULL, NULL);
+        DWORD dwMin = brightness.min;
+        DWORD dwCurrent = brightness.current;
+        DWORD dwMax = brightness.max;
 
-        ret = V_UI1(&var1);
+        DWORD newVal = dwCurrent;
+        if (delta > 0) {
+            newVal = std::min(dwCurrent + (DWORD)delta, dwMax);
+        } else if (delta < 0) {
+            DWORD sub = (DWORD)(-delta);
+            newVal = sub <= dwCurrent - dwMin ? dwCurrent - sub : dwMin;
+        }
 
-        VariantClear(&var1);
-        if (hr != WBEM_S_NO_ERROR) {
-            goto cleanup;
+        Wh_Log(L"DDC/CI: %s brightness %lu -> %lu (min %lu, max %lu)",
+               physical.szPhysicalMonitorDescription, dwCurrent, newVal, dwMin,
+               dwMax);
+
+        if (SetMonitorBrightness(physical.hPhysicalMonitor, newVal)) {
+            brightness.current = newVal;
+            anySuccess = true;
+        } else {
+            brightness.known = false;
         }
     }
 
-    // Free up resources
-cleanup:
-
-    SysFreeString(path);
-    SysFreeString(ClassPath);
-    SysFreeString(bstrQuery);
+    monitor->lastAccessTime = GetTickCount();
+    return anySuccess;
+}
 
-    if (pLocator) {
-        pLocator->Release();
+// Returns false if the monitor doesn't support DDC/CI, in which case WMI
+// should be used instead.
+bool AdjustBrightnessDdcCi(HMONITOR hMonitor, int delta) {
+    DdcCiMonitor* monitor = GetDdcCiMonitor(hMonitor);
+    if (!monitor->noDdcCi && ApplyBrightnessDdcCi(monitor, delta)) {
+        return true;
     }
-    if (pNamespace) {
-        pNamespace->Release();
+
+    if (!monitor->ddcCiWorked) {
+        monitor->noDdcCi = true;
+        return false;
     }
 
-    CoUninitialize();
+    // DDC/CI worked for this monitor before. DDC/CI over I2C can fail once
+    // and then work again, and the handles might be stale, so enumerate the
+    // physical monitors again and retry right away.
+    Wh_Log(L"DDC/CI failed, retrying");
+    monitor = GetDdcCiMonitor(hMonitor, /*forceEnumerate=*/true);
+    if (!monitor->noDdcCi) {
+        ApplyBrightnessDdcCi(monitor, delta);
+    }
 
-    return ret;
+    return true;
 }
 
-bool SetBrightnessWmi(int val) {
-    bool bRet = true;
+// WMI brightness control (for laptop displays).
+//
+// Reference:
+// https://github.com/stefankueng/tools/blob/e7cd50c6ac3a50f6dac84c6aace519349164155e/Misc/AAClr/src/Utils.cpp
 
-    IWbemLocator* pLocator = NULL;
-    IWbemServices* pNamespace = 0;
-    IWbemClassObject* pClass = NULL;
-    IWbemClassObject* pInClass = NULL;
-    IWbemClassObject* pInInst = NULL;
-    IEnumWbemClassObject* pEnum = NULL;
-    HRESULT hr = S_OK;
+// Brightness thread only.
+IWbemServices* g_wmiNamespace;
+std::vector<_bstr_t> g_wmiBrightnessMethodsPaths;
+IWbemClassObject* g_wmiSetBrightnessInParams;
+int g_wmiBrightness = -1;
+DWORD g_wmiLastAccessTime;
 
-    BSTR path = SysAllocString(L"root\\wmi");
-    BSTR ClassPath = SysAllocString(L"WmiMonitorBrightnessMethods");
-    BSTR MethodName = SysAllocString(L"WmiSetBrightness");
-    BSTR ArgName0 = SysAllocString(L"Timeout");
-    BSTR ArgName1 = SysAllocString(L"Brightness");
-    BSTR bstrQuery =
-        SysAllocString(L"Select * from WmiMonitorBrightnessMethods");
+void DisconnectWmi() {
+    if (g_wmiSetBrightnessInParams) {
+        g_wmiSetBrightnessInParams->Release();
+        g_wmiSetBrightnessInParams = nullptr;
+    }
 
-    if (!path || !ClassPath || !MethodName || !ArgName0) {
-        bRet = false;
-        goto cleanup;
+    g_wmiBrightnessMethodsPaths.clear();
+
+    if (g_wmiNamespace) {
+        g_wmiNamespace->Release();
+        g_wmiNamespace = nullptr;
     }
 
-    // Initialize COM as MTA so WMI calls are direct (no cross-apartment
-    // proxy). This function is meant to be called from a worker thread.
+    g_wmiBrightness = -1;
+}
 
-    hr = CoInitializeEx(0, COINIT_MULTITHREADED);
-    if (FAILED(hr)) {
-        bRet = false;
-        goto cleanup;
+bool ConnectWmi() {
+    if (g_wmiNamespace) {
+        return true;
     }
 
-    hr = CoCreateInstance(CLSID_WbemLocator, 0, CLSCTX_INPROC_SERVER,
-                          IID_IWbemLocator, (LPVOID*)&pLocator);
+    IWbemLocator* pLocator = nullptr;
+    HRESULT hr = CoCreateInstance(CLSID_WbemLocator, 0, CLSCTX_INPROC_SERVER,
+                                  IID_IWbemLocator, (LPVOID*)&pLocator);
     if (FAILED(hr)) {
-        bRet = false;
-        goto cleanup;
+        return false;
     }
-    hr = pLocator->ConnectServer(path, NULL, NULL, NULL, 0, NULL, NULL,
-                                 &pNamespace);
+
+    IWbemServices* pNamespace = nullptr;
+    hr = pLocator->ConnectServer(_bstr_t(L"root\\wmi"), nullptr, nullptr,
+                                 nullptr, 0, nullptr, nullptr, &pNamespace);
+    pLocator->Release();
     if (hr != WBEM_S_NO_ERROR) {
-        bRet = false;
-        goto cleanup;
+        return false;
     }
 
     hr = CoSetProxyBlanket(pNamespace, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE,
-                           NULL, RPC_C_AUTHN_LEVEL_PKT,
-                           RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE);
-
+                           nullptr, RPC_C_AUTHN_LEVEL_PKT,
+                           RPC_C_IMP_LEVEL_IMPERSONATE, nullptr, EOAC_NONE);
     if (hr != WBEM_S_NO_ERROR) {
-        bRet = false;
-        goto cleanup;
+        pNamespace->Release();
+        return false;
     }
 
-    hr = pNamespace->ExecQuery(
-        _bstr_t(L"WQL"),               // Query Language
-        bstrQuery,                     // Query to Execute
-        WBEM_FLAG_RETURN_IMMEDIATELY,  // Make a semi-synchronous call
-        NULL,                          // Context
-        &pEnum                         // Enumeration Interface
-    );
+    g_wmiNamespace = pNamespace;
+    return true;
+}
 
+// Calls `callback` with each object returned by the query, until it returns
+// false.
+template <typename Callback>
+bool ForEachWmiQueryResult(PCWSTR query, Callback callback) {
+    IEnumWbemClassObject* pEnum = nullptr;
+    HRESULT hr = g_wmiNamespace->ExecQuery(
+        _bstr_t(L"WQL"), _bstr_t(query), WBEM_FLAG_RETURN_IMMEDIATELY, nullptr,
+        &pEnum);
     if (hr != WBEM_S_NO_ERROR) {
-        bRet = false;
-        goto cleanup;
+        return false;
     }
 
-    hr = WBEM_S_NO_ERROR;
-
-    while (WBEM_S_NO_ERROR == hr) {
-        ULONG ulReturned;
-        IWbemClassObject* pObj;
-
-        // Get the Next Object from the collection
-        hr = pEnum->Next(WBEM_INFINITE,  // Timeout
-                         1,              // No of objects requested
-                         &pObj,          // Returned Object
-                         &ulReturned     // No of object returned
-        );
-
-        if (hr != WBEM_S_NO_ERROR) {
-            bRet = false;
-            goto cleanup;
-        }
-
-        // Get the class object
-        hr = pNamespace->GetObject(ClassPath, 0, NULL, &pClass, NULL);
-        if (hr != WBEM_S_NO_ERROR) {
-            bRet = false;
-            goto cleanup;
+    while (true) {
+        IWbemClassObject* pObj = nullptr;
+        ULONG ulReturned = 0;
+        hr = pEnum->Next(WBEM_INFINITE, 1, &pObj, &ulReturned);
+        if (hr != WBEM_S_NO_ERROR || ulReturned == 0) {
+            break;
         }
 
-        // Get the input argument and set the property
-        hr = pClass->GetMethod(MethodName, 0, &pInClass, NULL);
-        if (hr != WBEM_S_NO_ERROR) {
-            bRet = false;
-            goto cleanup;
+        bool proceed = callback(pObj);
+        pObj->Release();
+        if (!proceed) {
+            break;
         }
+    }
 
-        hr = pInClass->SpawnInstance(0, &pInInst);
-        if (hr != WBEM_S_NO_ERROR) {
-            bRet = false;
-            goto cleanup;
-        }
+    pEnum->Release();
 
-        VARIANT var1;
-        VariantInit(&var1);
+    // WBEM_S_FALSE means the enumeration is over.
+    return SUCCEEDED(hr);
+}
 
-        V_VT(&var1) = VT_BSTR;
-        V_BSTR(&var1) = SysAllocString(L"0");
-        hr = pInInst->Put(ArgName0, 0, &var1, CIM_UINT32);  // CIM_UINT64
+int GetBrightnessWmi() {
+    int ret = -1;
 
-        // var1.vt = VT_I4;
-        // var1.ullVal = 0;
-        //    hr = pInInst->Put(ArgName0, 0, &var1, 0);
-        VariantClear(&var1);
-        if (hr != WBEM_S_NO_ERROR) {
-            bRet = false;
-            goto cleanup;
-        }
+    ForEachWmiQueryResult(
+        L"Select * from WmiMonitorBrightness", [&ret](IWbemClassObject* pObj) {
+            _variant_t var;
+            if (pObj->Get(L"CurrentBrightness", 0, &var, nullptr, nullptr) ==
+                WBEM_S_NO_ERROR) {
+                ret = V_UI1(&var);
+            }
+            return true;
+        });
 
-        VARIANT var;
-        VariantInit(&var);
-
-        V_VT(&var) = VT_BSTR;
-        WCHAR buf[10] = {0};
-        swprintf_s(buf, _countof(buf), L"%d", val);
-        V_BSTR(&var) = SysAllocString(buf);
-        hr = pInInst->Put(ArgName1, 0, &var, CIM_UINT8);
-
-        // var.vt=VT_UI1;
-        // var.uiVal = 100;
-        // hr = pInInst->Put(ArgName1, 0, &var, 0);
-        VariantClear(&var);
-        if (hr != WBEM_S_NO_ERROR) {
-            bRet = false;
-            goto cleanup;
-        }
-        // Call the method
+    return ret;
+}
 
-        VARIANT pathVariable;
-        VariantInit(&pathVariable);
+// Looks up the WmiMonitorBrightnessMethods instances and the input parameters
+// of their WmiSetBrightness method once per connection.
+bool PrepareSetBrightnessWmi() {
+    if (g_wmiSetBrightnessInParams) {
+        return true;
+    }
 
-        hr = pObj->Get(_bstr_t(L"__PATH"), 0, &pathVariable, NULL, NULL);
-        if (hr != WBEM_S_NO_ERROR) {
-            goto cleanup;
-        }
+    std::vector<_bstr_t> paths;
+    ForEachWmiQueryResult(L"Select * from WmiMonitorBrightnessMethods",
+                          [&paths](IWbemClassObject* pObj) {
+                              _variant_t path;
+                              if (pObj->Get(L"__PATH", 0, &path, nullptr,
+                                            nullptr) == WBEM_S_NO_ERROR &&
+                                  V_VT(&path) == VT_BSTR) {
+                                  paths.push_back(V_BSTR(&path));
+                              }
+                              return true;
+                          });
+    if (paths.empty()) {
+        return false;
+    }
 
-        hr = pNamespace->ExecMethod(pathVariable.bstrVal, MethodName, 0, NULL,
-                                    pInInst, NULL, NULL);
-        VariantClear(&pathVariable);
-        if (hr != WBEM_S_NO_ERROR) {
-            bRet = false;
-            goto cleanup;
-        }
+    IWbemClassObject* pClass = nullptr;
+    HRESULT hr = g_wmiNamespace->GetObject(
+        _bstr_t(L"WmiMonitorBrightnessMethods"), 0, nullptr, &pClass, nullptr);
+    if (hr != WBEM_S_NO_ERROR) {
+        return false;
     }
 
-    // Free up resources
-cleanup:
+    IWbemClassObject* pInClass = nullptr;
+    hr = pClass->GetMethod(L"WmiSetBrightness", 0, &pInClass, nullptr);
+    pClass->Release();
+    if (hr != WBEM_S_NO_ERROR) {
+        return false;
+    }
 
-    SysFreeString(path);
-    SysFreeString(ClassPath);
-    SysFreeString(MethodName);
-    SysFreeString(ArgName0);
-    SysFreeString(ArgName1);
-    SysFreeString(bstrQuery);
+    g_wmiBrightnessMethodsPaths = std::move(paths);
+    g_wmiSetBrightnessInParams = pInClass;
+    return true;
+}
 
-    if (pClass) {
-        pClass->Release();
-    }
-    if (pInInst) {
-        pInInst->Release();
-    }
-    if (pInClass) {
-        pInClass->Release();
-    }
-    if (pLocator) {
-        pLocator->Release();
+bool SetBrightnessWmi(int val) {
+    if (!PrepareSetBrightnessWmi()) {
+        return false;
     }
-    if (pNamespace) {
-        pNamespace->Release();
+
+    IWbemClassObject* pInInst = nullptr;
+    HRESULT hr = g_wmiSetBrightnessInParams->SpawnInstance(0, &pInInst);
+    if (hr != WBEM_S_NO_ERROR) {
+        return false;
     }
 
-    CoUninitialize();
+    WCHAR buf[10];
+    swprintf_s(buf, L"%d", val);
+    _variant_t timeout(L"0");
+    _variant_t brightness(buf);
+    bool anySuccess = false;
+    if (pInInst->Put(L"Timeout", 0, &timeout, CIM_UINT32) == WBEM_S_NO_ERROR &&
+        pInInst->Put(L"Brightness", 0, &brightness, CIM_UINT8) ==
+            WBEM_S_NO_ERROR) {
+        for (const auto& path : g_wmiBrightnessMethodsPaths) {
+            hr = g_wmiNamespace->ExecMethod(path, _bstr_t(L"WmiSetBrightness"),
+                                            0, nullptr, pInInst, nullptr,
+                                            nullptr);
+            if (hr == WBEM_S_NO_ERROR) {
+                anySuccess = true;
+            }
+        }
+    }
 
-    return bRet;
+    pInInst->Release();
+    return anySuccess;
 }
 
-// DDC/CI brightness control (for external monitors).
-// VCP code 0x10 = Luminance (Brightness) per MCCS standard.
-
-bool AdjustBrightnessDdcCi(HMONITOR hMonitor, int delta) {
-    DWORD numPhysical = 0;
-    if (!GetNumberOfPhysicalMonitorsFromHMONITOR(hMonitor, &numPhysical) ||
-        numPhysical == 0) {
+bool AdjustBrightnessWmi(int delta) {
+    if (!ConnectWmi()) {
+        Wh_Log(L"Error connecting to WMI");
         return false;
     }
 
-    std::vector<PHYSICAL_MONITOR> physical(numPhysical);
-    if (!GetPhysicalMonitorsFromHMONITOR(hMonitor, numPhysical,
-                                         physical.data())) {
+    if (g_wmiBrightness < 0 ||
+        GetTickCount() - g_wmiLastAccessTime > kBrightnessValueCacheMs) {
+        g_wmiBrightness = GetBrightnessWmi();
+        if (g_wmiBrightness < 0) {
+            Wh_Log(L"Error getting brightness via WMI");
+            DisconnectWmi();
+            return false;
+        }
+    }
+
+    int newBrightness = std::clamp(g_wmiBrightness + delta, 0, 100);
+    Wh_Log(L"WMI: Changing brightness from %d to %d", g_wmiBrightness,
+           newBrightness);
+    if (!SetBrightnessWmi(newBrightness)) {
+        Wh_Log(L"Error setting brightness via WMI");
+        DisconnectWmi();
         return false;
     }
 
-    bool anySuccess = false;
+    g_wmiBrightness = newBrightness;
+    g_wmiLastAccessTime = GetTickCount();
+    return true;
+}
+
+void BrightnessThread() {
+    // Initialize COM as MTA so WMI calls are direct (no cross-apartment
+    // proxy).
+    HRESULT hrCoInit = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    DWORD lastChangeTime = GetTickCount() - kBrightnessChangeIntervalMs;
+
+    std::unique_lock<std::mutex> lock(g_brightnessMutex);
+    while (true) {
+        g_brightnessCondition.wait(lock, [] {
+            return g_brightnessStop || g_brightnessResetMonitors ||
+                   !g_brightnessPendingChanges.empty();
+        });
+        if (g_brightnessStop) {
+            break;
+        }
 
-    for (DWORD i = 0; i < numPhysical; i++) {
-        DWORD dwMin = 0;
-        DWORD dwCurrent = 0;
-        DWORD dwMax = 0;
-        if (!GetMonitorBrightness(physical[i].hPhysicalMonitor, &dwMin,
-                                  &dwCurrent, &dwMax)) {
+        if (g_brightnessResetMonitors) {
+            g_brightnessResetMonitors = false;
+            lock.unlock();
+            DestroyDdcCiMonitors();
+            lock.lock();
             continue;
         }
 
-        DWORD newVal = dwCurrent;
-        if (delta > 0) {
-            newVal = std::min(dwCurrent + (DWORD)delta, dwMax);
-        } else if (delta < 0) {
-            DWORD sub = (DWORD)(-delta);
-            newVal = sub <= dwCurrent - dwMin ? dwCurrent - sub : dwMin;
+        // Let more clicks accumulate until the interval since the last change
+        // passes.
+        DWORD elapsed = GetTickCount() - lastChangeTime;
+        if (elapsed < kBrightnessChangeIntervalMs) {
+            g_brightnessCondition.wait_for(
+                lock,
+                std::chrono::milliseconds(kBrightnessChangeIntervalMs -
+                                          elapsed),
+                [] { return g_brightnessStop; });
+            if (g_brightnessStop) {
+                break;
+            }
         }
 
-        Wh_Log(L"DDC/CI: %s brightness %lu -> %lu (min %lu, max %lu)",
-               physical[i].szPhysicalMonitorDescription, dwCurrent, newVal,
-               dwMin, dwMax);
+        auto changes = std::move(g_brightnessPendingChanges);
+        g_brightnessPendingChanges.clear();
+        lock.unlock();
 
-        if (SetMonitorBrightness(physical[i].hPhysicalMonitor, newVal)) {
-            anySuccess = true;
+        for (auto [hMonitor, delta] : changes) {
+            if (delta == 0) {
+                continue;
+            }
+
+            if (!hMonitor || !AdjustBrightnessDdcCi(hMonitor, delta)) {
+                AdjustBrightnessWmi(delta);
+            }
         }
+
+        lastChangeTime = GetTickCount();
+        lock.lock();
     }
+    lock.unlock();
 
-    DestroyPhysicalMonitors(numPhysical, physical.data());
-    return anySuccess;
+    DestroyDdcCiMonitors();
+    DisconnectWmi();
+
+    if (SUCCEEDED(hrCoInit)) {
+        CoUninitialize();
+    }
 }
 
-void AdjustBrightnessThread(HMONITOR hMonitor, int delta) {
-    if (!hMonitor || !AdjustBrightnessDdcCi(hMonitor, delta)) {
-        int brightness = GetBrightnessWmi();
-        if (brightness >= 0) {
-            int newBrightness = std::clamp(brightness + delta, 0, 100);
-            Wh_Log(L"WMI: Changing brightness from %d to %d", brightness,
-                   newBrightness);
-            if (!SetBrightnessWmi(newBrightness)) {
-                Wh_Log(L"Error setting brightness via WMI");
-            }
-        } else {
-            Wh_Log(L"Error getting brightness via WMI");
+// Called on the taskbar thread. The brightness thread is started on first use.
+void QueueBrightnessChange(HMONITOR hMonitor, int delta) {
+    std::lock_guard<std::mutex> lock(g_brightnessMutex);
+    if (g_brightnessStop) {
+        return;
+    }
+
+    auto it = std::find_if(
+        g_brightnessPendingChanges.begin(), g_brightnessPendingChanges.end(),
+        [hMonitor](const auto& change) { return change.first == hMonitor; });
+    if (it != g_brightnessPendingChanges.end()) {
+        it->second += delta;
+    } else {
+        g_brightnessPendingChanges.push_back({hMonitor, delta});
+    }
+
+    if (!g_brightnessThread.joinable()) {
+        g_brightnessThread = std::thread(BrightnessThread);
+    }
+
+    g_brightnessCondition.notify_one();
+}
+
+// Called on the taskbar thread on a display change. The cached monitor handles
+// might be stale, so they're dropped before the next change.
+void ResetBrightnessMonitors() {
+    {
+        std::lock_guard<std::mutex> lock(g_brightnessMutex);
+        if (!g_brightnessThread.joinable()) {
+            return;
         }
+
+        g_brightnessResetMonitors = true;
+    }
+
+    g_brightnessCondition.notify_one();
+}
+
+void StopBrightnessThread() {
+    {
+        std::lock_guard<std::mutex> lock(g_brightnessMutex);
+        g_brightnessStop = true;
+    }
+
+    g_brightnessCondition.notify_one();
+
+    if (g_brightnessThread.joinable()) {
+        g_brightnessThread.join();
     }
 }
 
@@ -1164,11 +1328,11 @@ void InvokeScrollAction(HWND hWnd,
 
             case ScrollAction::brightnessChange: {
                 // Resolve the monitor on the UI thread (fast), then do the
-                // actual brightness work on a background MTA thread to avoid
+                // actual brightness work on the brightness thread to avoid
                 // blocking the taskbar message loop with slow WMI/DDC-CI calls.
                 HMONITOR hMonitor =
                     MonitorFromWindow(hWnd, MONITOR_DEFAULTTONEAREST);
-                std::thread(AdjustBrightnessThread, hMonitor, clicks).detach();
+                QueueBrightnessChange(hMonitor, clicks);
                 break;
             }
 
@@ -1232,6 +1396,14 @@ LRESULT CALLBACK TaskbarWindowSubclassProc(_In_ HWND hWnd,
             }
             break;
 
+        case WM_DISPLAYCHANGE:
+            result = DefSubclassProc(hWnd, uMsg, wParam, lParam);
+
+            if (hWnd == g_hTaskbarWnd) {
+                ResetBrightnessMonitors();
+            }
+            break;
+
         case WM_NCDESTROY:
             result = DefSubclassProc(hWnd, uMsg, wParam, lParam);
 
@@ -1678,6 +1850,8 @@ void Wh_ModUninit() {
     }
 
     MicVolUninit();
+
+    StopBrightnessThread();
 }
 
 BOOL Wh_ModSettingsChanged(BOOL* bReload) {
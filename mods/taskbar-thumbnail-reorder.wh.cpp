@@ -2,7 +2,7 @@
 // @id              taskbar-thumbnail-reorder
 // @name            Taskbar Thumbnail Reorder
 // @description     Reorder taskbar thumbnails with the left mouse button
-// @version         1.1.5
+// @version         1.1.6
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -48,9 +48,11 @@ check out [7+ Taskbar Tweaker](https://tweaker.ramensoftware.com/).
 #include <commctrl.h>
 #include <psapi.h>
 
+#include <algorithm>
 #include <atomic>
 #include <functional>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 #undef GetCurrentTime
@@ -114,7 +116,15 @@ struct ThumbnailTaskItemMapping {
     void* taskItem;
 };
 
-std::vector<ThumbnailTaskItemMapping> g_thumbnailTaskItemMapping;
+// Keyed by the thumbnail's ABI pointer. The weak reference confirms that the
+// pointer still refers to the same, live thumbnail.
+std::unordered_map<void*, ThumbnailTaskItemMapping> g_thumbnailTaskItemMapping;
+
+// The thumbnail key of each task item in g_thumbnailTaskItemMapping.
+std::unordered_map<void*, void*> g_taskItemThumbnailKeys;
+
+// Dead mapping items are pruned when the mapping grows to this size.
+size_t g_thumbnailTaskItemMappingPruneSize = 64;
 
 bool g_inHoverFlyoutModel_TargetItemKey;
 
@@ -610,25 +620,80 @@ LRESULT WINAPI CTaskListThumbnailWnd_v_WndProc_Hook(void* pThis,
     return result;
 }
 
+auto EraseTaskItemThumbnailMapping(
+    std::unordered_map<void*, ThumbnailTaskItemMapping>::iterator it) {
+    auto keyIt = g_taskItemThumbnailKeys.find(it->second.taskItem);
+    if (keyIt != g_taskItemThumbnailKeys.end() && keyIt->second == it->first) {
+        g_taskItemThumbnailKeys.erase(keyIt);
+    }
+
+    return g_thumbnailTaskItemMapping.erase(it);
+}
+
+void PruneTaskItemThumbnailMapping() {
+    for (auto it = g_thumbnailTaskItemMapping.begin();
+         it != g_thumbnailTaskItemMapping.end();) {
+        if (!it->second.thumbnail.get()) {
+            it = EraseTaskItemThumbnailMapping(it);
+        } else {
+            ++it;
+        }
+    }
+
+    g_thumbnailTaskItemMappingPruneSize =
+        std::max(size_t{64}, g_thumbnailTaskItemMapping.size() * 2);
+}
+
 void AddTaskItemThumbnailMapping(
     winrt::Windows::Foundation::IInspectable thumbnail,
     void* taskGroup,
     void* taskItem) {
-    // Delete stale mapping items.
-    std::erase_if(g_thumbnailTaskItemMapping, [&](const auto& item) {
-        auto thumbnailIter = item.thumbnail.get();
-        if (!thumbnailIter || thumbnailIter == thumbnail) {
-            return true;
+    void* thumbnailKey = winrt::get_abi(thumbnail);
+
+    // Delete stale mapping items: a previous thumbnail of the same task item,
+    // and a previous mapping of the same thumbnail.
+    auto keyIt = g_taskItemThumbnailKeys.find(taskItem);
+    if (keyIt != g_taskItemThumbnailKeys.end()) {
+        auto it = g_thumbnailTaskItemMapping.find(keyIt->second);
+        if (it != g_thumbnailTaskItemMapping.end() &&
+            it->second.taskGroup == taskGroup) {
+            EraseTaskItemThumbnailMapping(it);
         }
+    }
 
-        if (item.taskGroup == taskGroup && item.taskItem == taskItem) {
-            return true;
-        }
+    auto it = g_thumbnailTaskItemMapping.find(thumbnailKey);
+    if (it != g_thumbnailTaskItemMapping.end()) {
+        EraseTaskItemThumbnailMapping(it);
+    }
+
+    if (g_thumbnailTaskItemMapping.size() >=
+        g_thumbnailTaskItemMappingPruneSize) {
+        PruneTaskItemThumbnailMapping();
+    }
 
+    g_thumbnailTaskItemMapping.try_emplace(
+        thumbnailKey, ThumbnailTaskItemMapping{thumbnail, taskGroup, taskItem});
+    g_taskItemThumbnailKeys[taskItem] = thumbnailKey;
+}
+
+// Maps a thumbnail's ABI pointer to its task item and task group.
+bool LookupTaskItemThumbnailMapping(void* thumbnailPtr,
+                                    void** taskItem,
+                                    void** taskGroup) {
+    auto it = g_thumbnailTaskItemMapping.find(thumbnailPtr);
+    if (it == g_thumbnailTaskItemMapping.end()) {
         return false;
-    });
+    }
 
-    g_thumbnailTaskItemMapping.push_back({thumbnail, taskGroup, taskItem});
+    auto thumbnail = it->second.thumbnail.get();
+    if (!thumbnail || winrt::get_abi(thumbnail) != thumbnailPtr) {
+        EraseTaskItemThumbnailMapping(it);
+        return false;
+    }
+
+    *taskItem = it->second.taskItem;
+    *taskGroup = it->second.taskGroup;
+    return true;
 }
 
 using TaskItemThumbnail_TaskItemThumbnail_t = void*(WINAPI*)(void* param1,
@@ -729,9 +794,7 @@ void* WINAPI TaskGroup_Thumbnails_Hook(void* pThis, void* param1) {
             g_TaskGroup_Thumbnails = obj;
 
             // Remove invalid weak pointers.
-            std::erase_if(g_thumbnailTaskItemMapping, [](const auto& item) {
-                return !item.thumbnail.get();
-            });
+            PruneTaskItemThumbnailMapping();
         }
     }
 
@@ -815,32 +878,14 @@ void MoveItemsFromXAMLThumbnail(int indexFrom, int indexTo) {
         return;
     }
 
-    // Maps a thumbnail's ABI pointer to its task item and task group.
-    auto lookupTaskItem = [](void* thumbnailPtr, void** taskItem,
-                             void** taskGroup) -> bool {
-        for (const auto& iter : g_thumbnailTaskItemMapping) {
-            auto thumbnail = iter.thumbnail.get();
-            if (!thumbnail) {
-                continue;
-            }
-
-            if (winrt::get_abi(thumbnail) == thumbnailPtr) {
-                *taskItem = iter.taskItem;
-                *taskGroup = iter.taskGroup;
-                return true;
-            }
-        }
-
-        return false;
-    };
-
     winrt::com_ptr<IUnknown> from;
     TaskItemThumbnail_GetAt_Original(&thumbnailsPtr, from.put_void(),
                                      indexFrom);
 
     void* taskItemFrom = nullptr;
     void* taskGroupFrom = nullptr;
-    if (!lookupTaskItem(from.get(), &taskItemFrom, &taskGroupFrom)) {
+    if (!LookupTaskItemThumbnailMapping(from.get(), &taskItemFrom,
+                                        &taskGroupFrom)) {
         Wh_Log(L"Task item/group not found");
         return;
     }
@@ -850,7 +895,7 @@ void MoveItemsFromXAMLThumbnail(int indexFrom, int indexTo) {
 
     void* taskItemTo = nullptr;
     void* taskGroupTo = nullptr;
-    if (!lookupTaskItem(to.get(), &taskItemTo, &taskGroupTo)) {
+    if (!LookupTaskItemThumbnailMapping(to.get(), &taskItemTo, &taskGroupTo)) {
         Wh_Log(L"Task item/group not found");
         return;
     }
@@ -873,7 +918,8 @@ void MoveItemsFromXAMLThumbnail(int indexFrom, int indexTo) {
 
         void* taskItem = nullptr;
         void* taskGroup = nullptr;
-        if (!lookupTaskItem(thumbnail.get(), &taskItem, &taskGroup)) {
+        if (!LookupTaskItemThumbnailMapping(thumbnail.get(), &taskItem,
+                                            &taskGroup)) {
             Wh_Log(L"Task item/group not found");
             return;
         }
@@ -2,7 +2,7 @@
 // @id              taskbar-tray-system-icon-tweaks
 // @name            Taskbar tray system icon tweaks
 // @description     Allows hiding system icons: volume, network, battery, microphone, location/GPS, Studio Effects, Recall, language bar, bell (always or when there are no new notifications), and the "Show desktop" button (hide or set width)
-// @version         1.3
+// @version         1.3.1
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -78,7 +78,6 @@ Only Windows 11 is supported.
 #include <atomic>
 #include <functional>
 #include <limits>
-#include <list>
 #include <string>
 #include <vector>
 
@@ -122,7 +121,10 @@ using FrameworkElementLoadedEventRevoker = winrt::impl::event_revoker<
     IFrameworkElement,
     &winrt::impl::abi<IFrameworkElement>::type::remove_Loaded>;
 
-std::list<FrameworkElementLoadedEventRevoker> g_autoRevokerList;
+// Pending Loaded handlers of icon views. A slot is returned to the free list
+// once its handler runs, so slots are reused across taskbar rebuilds.
+std::vector<FrameworkElementLoadedEventRevoker> g_autoRevokerSlots;
+std::vector<size_t> g_autoRevokerFreeSlots;
 
 winrt::weak_ref<Controls::TextBlock> g_mainStackInnerTextBlock;
 int64_t g_mainStackTextChangedToken;
@@ -197,6 +199,55 @@ bool IsChildOfElementByClassName(FrameworkElement element, PCWSTR className) {
     return !!GetParentElementByClassName(element, className);
 }
 
+enum class SystemTrayIconContainer {
+    None,
+    MainStack,
+    NonActivatableStack,
+    ControlCenterButton,
+    NotificationCenterButton,
+    ShowDesktopStack,
+};
+
+// Finds the container of a system tray icon with a single walk up the tree.
+// If the icon is inside several containers, the one listed first in
+// SystemTrayIconContainer wins, regardless of nesting order.
+SystemTrayIconContainer GetSystemTrayIconContainer(FrameworkElement element) {
+    struct ContainerName {
+        std::wstring_view name;
+        SystemTrayIconContainer container;
+    };
+
+    static constexpr ContainerName kContainerNames[] = {
+        {L"MainStack", SystemTrayIconContainer::MainStack},
+        {L"NonActivatableStack", SystemTrayIconContainer::NonActivatableStack},
+        {L"ControlCenterButton", SystemTrayIconContainer::ControlCenterButton},
+        {L"NotificationCenterButton",
+         SystemTrayIconContainer::NotificationCenterButton},
+        {L"ShowDesktopStack", SystemTrayIconContainer::ShowDesktopStack},
+    };
+
+    auto result = SystemTrayIconContainer::None;
+
+    EnumParentElements(element, [&result](FrameworkElement parent) {
+        auto parentName = parent.Name();
+        std::wstring_view name(parentName.data(), parentName.size());
+        for (const auto& containerName : kContainerNames) {
+            if (name == containerName.name) {
+                if (result == SystemTrayIconContainer::None ||
+                    containerName.container < result) {
+                    result = containerName.container;
+                }
+                break;
+            }
+        }
+
+        // Nothing can take precedence over the first container kind.
+        return result == SystemTrayIconContainer::MainStack;
+    });
+
+    return result;
+}
+
 FrameworkElement EnumChildElements(
     FrameworkElement element,
     std::function<bool(FrameworkElement)> enumCallback) {
@@ -1330,17 +1381,24 @@ void* WINAPI IconView_IconView_Hook(void* pThis) {
         return ret;
     }
 
-    g_autoRevokerList.emplace_back();
-    auto autoRevokerIt = g_autoRevokerList.end();
-    --autoRevokerIt;
+    size_t autoRevokerSlot;
+    if (!g_autoRevokerFreeSlots.empty()) {
+        autoRevokerSlot = g_autoRevokerFreeSlots.back();
+        g_autoRevokerFreeSlots.pop_back();
+    } else {
+        autoRevokerSlot = g_autoRevokerSlots.size();
+        g_autoRevokerSlots.emplace_back();
+    }
 
-    *autoRevokerIt = iconView.Loaded(
+    g_autoRevokerSlots[autoRevokerSlot] = iconView.Loaded(
         winrt::auto_revoke_t{},
-        [autoRevokerIt](winrt::Windows::Foundation::IInspectable const& sender,
-                        RoutedEventArgs const& e) {
+        [autoRevokerSlot](
+            winrt::Windows::Foundation::IInspectable const& sender,
+            RoutedEventArgs const& e) {
             Wh_Log(L">");
 
-            g_autoRevokerList.erase(autoRevokerIt);
+            g_autoRevokerSlots[autoRevokerSlot] = {};
+            g_autoRevokerFreeSlots.push_back(autoRevokerSlot);
 
             auto iconView = sender.try_as<FrameworkElement>();
             if (!iconView) {
@@ -1352,20 +1410,24 @@ void* WINAPI IconView_IconView_Hook(void* pThis) {
 
             if (className == L"SystemTray.IconView") {
                 if (iconView.Name() == L"SystemTrayIcon") {
-                    if (IsChildOfElementByName(iconView, L"MainStack")) {
-                        ApplyMainStackIconViewStyle(iconView);
-                    } else if (IsChildOfElementByName(iconView,
-                                                      L"NonActivatableStack")) {
-                        ApplyNonActivatableStackIconViewStyle(iconView);
-                    } else if (IsChildOfElementByName(iconView,
-                                                      L"ControlCenterButton")) {
-                        ApplyControlCenterButtonIconStyle(iconView);
-                    } else if (IsChildOfElementByName(
-                                   iconView, L"NotificationCenterButton")) {
-                        ApplyBellIconStyle(iconView);
-                    } else if (IsChildOfElementByName(iconView,
-                                                      L"ShowDesktopStack")) {
-                        ApplyShowDesktopStyle(iconView);
+                    switch (GetSystemTrayIconContainer(iconView)) {
+                        case SystemTrayIconContainer::MainStack:
+                            ApplyMainStackIconViewStyle(iconView);
+                            break;
+                        case SystemTrayIconContainer::NonActivatableStack:
+                            ApplyNonActivatableStackIconViewStyle(iconView);
+                            break;
+                        case SystemTrayIconContainer::ControlCenterButton:
+                            ApplyControlCenterButtonIconStyle(iconView);
+                            break;
+                        case SystemTrayIconContainer::NotificationCenterButton:
+                            ApplyBellIconStyle(iconView);
+                            break;
+                        case SystemTrayIconContainer::ShowDesktopStack:
+                            ApplyShowDesktopStyle(iconView);
+                            break;
+                        case SystemTrayIconContainer::None:
+                            break;
                     }
                 }
             }
@@ -1559,7 +1621,8 @@ void ApplySettings() {
         [](void* pParam) {
             ApplySettingsParam& param = *(ApplySettingsParam*)pParam;
 
-            g_autoRevokerList.clear();
+            g_autoRevokerSlots.clear();
+            g_autoRevokerFreeSlots.clear();
 
             if (auto bellSystemTrayIconElement =
                     g_bellSystemTrayIconElement.get()) {
@@ -2,7 +2,7 @@
 // @id              taskbar-vertical
 // @name            Vertical Taskbar for Windows 11
 // @description     Finally, the missing vertical taskbar option for Windows 11! Move the taskbar to the left or right side of the screen.
-// @version         1.3.13
+// @version         1.3.14
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -136,6 +136,8 @@ With labels:
 #include <functional>
 #include <limits>
 #include <list>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #ifdef _M_ARM64
@@ -349,6 +351,113 @@ FrameworkElement FindChildByClassName(FrameworkElement element,
     });
 }
 
+// Resolves a path of child elements such as
+// "SystemTray.SystemTrayFrame > SystemTrayFrameGrid" from a root element. Path
+// parts containing a dot are matched by class name, the others by element
+// name. The path is parsed once, and the resolved element is cached per root
+// as a weak reference. It's reused as long as it's still attached at the same
+// depth below the root, which takes one GetParent call per path part, and the
+// full tree walk is only done if it was detached.
+//
+// Must be used from the taskbar UI thread.
+std::atomic<DWORD> g_elementPathCacheHits;
+std::atomic<DWORD> g_elementPathCacheWalks;
+
+class ElementPathResolver {
+   public:
+    explicit ElementPathResolver(std::wstring_view path) {
+        while (!path.empty()) {
+            size_t separator = path.find(L'>');
+            std::wstring_view part = path.substr(0, separator);
+            path = separator == path.npos ? std::wstring_view{}
+                                          : path.substr(separator + 1);
+
+            part.remove_prefix(std::min(part.find_first_not_of(L' '),
+                                        part.size()));
+            part.remove_suffix(part.size() -
+                               (part.find_last_not_of(L' ') + 1));
+            if (!part.empty()) {
+                m_steps.push_back({std::wstring(part),
+                                   part.find(L'.') != part.npos});
+            }
+        }
+    }
+
+    FrameworkElement Resolve(FrameworkElement root) {
+        if (!root) {
+            return nullptr;
+        }
+
+        for (auto it = m_cache.begin(); it != m_cache.end();) {
+            auto cachedRoot = it->root.get();
+            if (!cachedRoot) {
+                it = m_cache.erase(it);
+                continue;
+            }
+
+            if (cachedRoot == root) {
+                auto element = it->element.get();
+                if (element && IsAttachedBelow(element, root)) {
+                    g_elementPathCacheHits++;
+                    return element;
+                }
+
+                m_cache.erase(it);
+                break;
+            }
+
+            ++it;
+        }
+
+        g_elementPathCacheWalks++;
+
+        FrameworkElement element = root;
+        for (const auto& step : m_steps) {
+            element = step.byClassName
+                          ? FindChildByClassName(element, step.value.c_str())
+                          : FindChildByName(element, step.value.c_str());
+            if (!element) {
+                return nullptr;
+            }
+        }
+
+        m_cache.push_back({winrt::make_weak(root), winrt::make_weak(element)});
+        return element;
+    }
+
+   private:
+    bool IsAttachedBelow(FrameworkElement element, FrameworkElement root) {
+        DependencyObject ancestor = element;
+        for (size_t i = 0; i < m_steps.size(); i++) {
+            ancestor = Media::VisualTreeHelper::GetParent(ancestor);
+            if (!ancestor) {
+                return false;
+            }
+        }
+
+        return ancestor == root;
+    }
+
+    struct Step {
+        std::wstring value;
+        bool byClassName;
+    };
+
+    struct CacheEntry {
+        winrt::weak_ref<FrameworkElement> root;
+        winrt::weak_ref<FrameworkElement> element;
+    };
+
+    std::vector<Step> m_steps;
+    std::vector<CacheEntry> m_cache;
+};
+
+ElementPathResolver g_taskbarFrameRootGridPath{L"TaskbarFrame > RootGrid"};
+ElementPathResolver g_systemTrayFrameGridPath{
+    L"SystemTray.SystemTrayFrame > SystemTrayFrameGrid"};
+ElementPathResolver g_controlCenterButtonPath{
+    L"SystemTray.SystemTrayFrame > SystemTrayFrameGrid > ControlCenterButton"};
+
 TaskbarLocation GetTaskbarLocationForMonitor(HMONITOR monitor) {
     if (g_settings.taskbarLocation == g_settings.taskbarLocationSecondary) {
         return g_settings.taskbarLocation;
@@ -1358,16 +1467,8 @@ void WINAPI SystemTrayFrame_Height_Hook(void* pThis, double value) {
 }
 
 bool IsSecondaryTaskbar(XamlRoot xamlRoot) {
-    FrameworkElement controlCenterButton = nullptr;
-
-    FrameworkElement child = xamlRoot.Content().try_as<FrameworkElement>();
-    if (child &&
-        (child = FindChildByClassName(child, L"SystemTray.SystemTrayFrame")) &&
-        (child = FindChildByName(child, L"SystemTrayFrameGrid")) &&
-        (child = FindChildByName(child, L"ControlCenterButton"))) {
-        controlCenterButton = child;
-    }
-
+    FrameworkElement controlCenterButton = g_controlCenterButtonPath.Resolve(
+        xamlRoot.Content().try_as<FrameworkElement>());
     if (!controlCenterButton) {
         return false;
     }
@@ -2076,12 +2177,7 @@ bool ApplyStyleIfNeeded(XamlRoot xamlRoot) {
     FrameworkElement contentGrid =
         xamlRoot.Content().try_as<FrameworkElement>();
 
-    auto taskbarFrame = FindChildByName(contentGrid, L"TaskbarFrame");
-    if (!taskbarFrame) {
-        return true;
-    }
-
-    FrameworkElement rootGrid = FindChildByName(taskbarFrame, L"RootGrid");
+    FrameworkElement rootGrid = g_taskbarFrameRootGridPath.Resolve(contentGrid);
     if (!rootGrid) {
         return true;
     }
@@ -2096,15 +2192,8 @@ bool ApplyStyleIfNeeded(XamlRoot xamlRoot) {
 bool UpdateNotifyIcons(XamlRoot xamlRoot) {
     FrameworkElement rootGrid = xamlRoot.Content().try_as<FrameworkElement>();
 
-    FrameworkElement systemTrayFrameGrid = nullptr;
-
-    FrameworkElement child = rootGrid;
-    if (child &&
-        (child = FindChildByClassName(child, L"SystemTray.SystemTrayFrame")) &&
-        (child = FindChildByName(child, L"SystemTrayFrameGrid"))) {
-        systemTrayFrameGrid = child;
-    }
-
+    FrameworkElement systemTrayFrameGrid =
+        g_systemTrayFrameGridPath.Resolve(rootGrid);
     if (!systemTrayFrameGrid) {
         return false;
     }
@@ -2112,10 +2201,9 @@ bool UpdateNotifyIcons(XamlRoot xamlRoot) {
     // Copy margin from TaskbarFrame root. It's done in
     // TaskbarFrame_MeasureOverride_Hook as well, but SystemTrayFrameGrid might
     // not exist yet at this point.
-    child = rootGrid;
-    if (child && (child = FindChildByName(child, L"TaskbarFrame")) &&
-        (child = FindChildByName(child, L"RootGrid"))) {
-        systemTrayFrameGrid.Margin(child.Margin());
+    if (auto taskbarFrameRootGrid =
+            g_taskbarFrameRootGridPath.Resolve(rootGrid)) {
+        systemTrayFrameGrid.Margin(taskbarFrameRootGrid.Margin());
     }
 
     FrameworkElement notificationAreaIcons =
@@ -5310,6 +5398,9 @@ void Wh_ModBeforeUninit() {
 void Wh_ModUninit() {
     Wh_Log(L">");
 
+    Wh_Log(L"Element path cache: %u hits, %u walks",
+           g_elementPathCacheHits.load(), g_elementPathCacheWalks.load());
+
     while (g_hookCallCounter > 0) {
         Sleep(100);
     }
@@ -2,7 +2,7 @@
 // @id              taskbar-volume-control
 // @name            Taskbar Volume Control
 // @description     Control the system volume by scrolling over the taskbar or anywhere with modifier keys
-// @version         1.3.1
+// @version         1.3.3
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -145,6 +145,7 @@ issue](https://tweaker.userecho.com/topics/826-scroll-on-trackpadtouchpad-doesnt
 
 #include <algorithm>
 #include <atomic>
+#include <memory>
 #include <optional>
 #include <string_view>
 #include <unordered_set>
@@ -631,6 +632,195 @@ bool IsPointInsideScrollArea(HWND hMMTaskbarWnd, POINT pt) {
            IsPointInsideAdditionalRegion(hMMTaskbarWnd, pt);
 }
 
+// The low level mouse hook sees every wheel event of the system, and Windows
+// removes the hook if it's too slow, so instead of querying the taskbar windows
+// for each event, it uses a table of the scroll areas of all taskbars. The
+// table is built on the taskbar thread and published as an immutable snapshot,
+// the hook only reads it. It's rebuilt when a taskbar window reports a change
+// (move, DPI or display change), and when the hook finds it old, since the
+// notification area can be resized without the taskbar window being notified.
+constexpr DWORD kScrollAreaTableMaxAgeMs = 1000;
+
+UINT g_rebuildScrollAreaTableMsg =
+    RegisterWindowMessage(L"Windhawk_RebuildScrollAreaTable_" WH_MOD_ID);
+
+struct TaskbarScrollArea {
+    RECT rcArea;
+    RECT rcExclude;
+    std::vector<RECT> additional;
+};
+
+struct ScrollAreaTable {
+    std::vector<TaskbarScrollArea> areas;
+    DWORD buildTime;
+};
+
+// Accessed with std::atomic_load and std::atomic_store.
+std::shared_ptr<const ScrollAreaTable> g_scrollAreaTable;
+std::atomic<bool> g_scrollAreaTableRebuildPending;
+
+// Can be called from any thread, the table is rebuilt on the taskbar thread.
+void InvalidateScrollAreaTable() {
+    if (g_settings.fullScreenScrolling == FullScreenScrolling::disabled) {
+        return;
+    }
+
+    HWND hTaskbarWnd = g_hTaskbarWnd;
+    if (!hTaskbarWnd || g_scrollAreaTableRebuildPending.exchange(true)) {
+        return;
+    }
+
+    if (!PostMessage(hTaskbarWnd, g_rebuildScrollAreaTableMsg, 0, 0)) {
+        g_scrollAreaTableRebuildPending = false;
+    }
+}
+
+bool GetTaskbarScrollArea(HWND hMMTaskbarWnd, TaskbarScrollArea* area) {
+    RECT rcTaskbar;
+    if (!GetWindowRect(hMMTaskbarWnd, &rcTaskbar)) {
+        return false;
+    }
+
+    SetRectEmpty(&area->rcArea);
+    SetRectEmpty(&area->rcExclude);
+    area->additional.clear();
+
+    switch (g_settings.scrollArea) {
+        case ScrollArea::taskbar:
+            CopyRect(&area->rcArea, &rcTaskbar);
+            break;
+
+        case ScrollArea::notificationArea:
+            if (!GetNotificationAreaRect(hMMTaskbarWnd, &area->rcArea)) {
+                SetRectEmpty(&area->rcArea);
+            }
+            break;
+
+        case ScrollArea::taskbarWithoutNotificationArea:
+            CopyRect(&area->rcArea, &rcTaskbar);
+            if (!GetNotificationAreaRect(hMMTaskbarWnd, &area->rcExclude)) {
+                SetRectEmpty(&area->rcExclude);
+            }
+            break;
+
+        case ScrollArea::none:
+            break;
+    }
+
+    if (g_settings.additionalScrollRegions.empty()) {
+        return true;
+    }
+
+    // Convert the regions to screen rects, see IsPointInsideAdditionalRegion.
+    bool isHorizontal = (rcTaskbar.right - rcTaskbar.left) >=
+                        (rcTaskbar.bottom - rcTaskbar.top);
+    int taskbarLength = isHorizontal ? rcTaskbar.right - rcTaskbar.left
+                                     : rcTaskbar.bottom - rcTaskbar.top;
+    bool isRtl = GetWindowLong(hMMTaskbarWnd, GWL_EXSTYLE) & WS_EX_LAYOUTRTL;
+
+    UINT dpi = GetDpiForWindowWithFallback(hMMTaskbarWnd);
+
+    for (const auto& region : g_settings.additionalScrollRegions) {
+        int start, end;
+        if (region.isPercentage) {
+            start = MulDiv(taskbarLength, region.start, 100);
+            end = MulDiv(taskbarLength, region.end, 100);
+        } else {
+            start = MulDiv(region.start, dpi, 96);
+            end = MulDiv(region.end, dpi, 96);
+        }
+
+        RECT rc = rcTaskbar;
+        if (!isHorizontal) {
+            rc.top = rcTaskbar.top + start;
+            rc.bottom = rcTaskbar.top + end + 1;
+        } else if (isRtl) {
+            rc.left = rcTaskbar.right - 1 - end;
+            rc.right = rcTaskbar.right - start;
+        } else {
+            rc.left = rcTaskbar.left + start;
+            rc.right = rcTaskbar.left + end + 1;
+        }
+
+        if (IntersectRect(&rc, &rc, &rcTaskbar)) {
+            area->additional.push_back(rc);
+        }
+    }
+
+    return true;
+}
+
+void BuildScrollAreaTable(std::vector<TaskbarScrollArea>& areas) {
+    HWND hTaskbarWnd = g_hTaskbarWnd;
+    DWORD dwTaskbarThreadId = g_dwTaskbarThreadId;
+    if (!hTaskbarWnd || !dwTaskbarThreadId) {
+        return;
+    }
+
+    TaskbarScrollArea area;
+    if (GetTaskbarScrollArea(hTaskbarWnd, &area)) {
+        areas.push_back(std::move(area));
+    }
+
+    EnumThreadWindows(
+        dwTaskbarThreadId,
+        [](HWND hWnd, LPARAM lParam) WINAPI_LAMBDA_RETURN(BOOL) {
+            auto& areas = *(std::vector<TaskbarScrollArea>*)lParam;
+
+            WCHAR szClassName[32];
+            if (GetClassName(hWnd, szClassName, ARRAYSIZE(szClassName)) &&
+                _wcsicmp(szClassName, L"Shell_SecondaryTrayWnd") == 0) {
+                TaskbarScrollArea area;
+                if (GetTaskbarScrollArea(hWnd, &area)) {
+                    areas.push_back(std::move(area));
+                }
+            }
+            return TRUE;
+        },
+        (LPARAM)&areas);
+}
+
+// Taskbar thread only.
+void RebuildScrollAreaTable() {
+    // Cleared first, so that a change during the rebuild requests another one.
+    g_scrollAreaTableRebuildPending = false;
+
+    auto table = std::make_shared<ScrollAreaTable>();
+    BuildScrollAreaTable(table->areas);
+    table->buildTime = GetTickCount();
+
+    std::atomic_store(&g_scrollAreaTable,
+                      std::shared_ptr<const ScrollAreaTable>(std::move(table)));
+}
+
+// Called from the hook thread. Until the first table is built, or while a
+// rebuild is pending, the current table is used as is.
+bool IsPointInsideCachedScrollArea(POINT pt) {
+    auto table = std::atomic_load(&g_scrollAreaTable);
+    if (!table) {
+        InvalidateScrollAreaTable();
+        return false;
+    }
+
+    if (GetTickCount() - table->buildTime > kScrollAreaTableMaxAgeMs) {
+        InvalidateScrollAreaTable();
+    }
+
+    for (const auto& area : table->areas) {
+        if (PtInRect(&area.rcArea, pt) && !PtInRect(&area.rcExclude, pt)) {
+            return true;
+        }
+
+        for (const auto& rc : area.additional) {
+            if (PtInRect(&rc, pt)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 #pragma endregion  // regions
 
 #pragma region volume_functions
@@ -1520,12 +1710,21 @@ LRESULT CALLBACK TaskbarWindowSubclassProc(_In_ HWND hWnd,
             }
             break;
 
+        case WM_WINDOWPOSCHANGED:
+        case WM_DPICHANGED:
+        case WM_DISPLAYCHANGE:
+        case WM_SETTINGCHANGE:
+            InvalidateScrollAreaTable();
+            result = DefSubclassProc(hWnd, uMsg, wParam, lParam);
+            break;
+
         case WM_NCDESTROY:
             result = DefSubclassProc(hWnd, uMsg, wParam, lParam);
 
             if (hWnd != g_hTaskbarWnd) {
                 g_secondaryTaskbarWindows.erase(hWnd);
             }
+            InvalidateScrollAreaTable();
             break;
 
         default:
@@ -1537,6 +1736,9 @@ LRESULT CALLBACK TaskbarWindowSubclassProc(_In_ HWND hWnd,
                     OpenScrollSndVol(wParam, lParam);
                 }
                 result = 0;
+            } else if (uMsg == g_rebuildScrollAreaTableMsg) {
+                RebuildScrollAreaTable();
+                result = 0;
             } else {
                 result = DefSubclassProc(hWnd, uMsg, wParam, lParam);
             }
@@ -1617,6 +1819,9 @@ void HandleIdentifiedTaskbarWindow(HWND hWnd) {
     for (HWND hSecondaryWnd : g_secondaryTaskbarWindows) {
         SubclassTaskbarWindow(hSecondaryWnd);
     }
+    // A rebuild posted to a previous taskbar window is lost.
+    g_scrollAreaTableRebuildPending = false;
+    InvalidateScrollAreaTable();
 
     if (g_nExplorerVersion >= WIN_VERSION_11_21H2 && !g_inputSiteProcHooked) {
         HWND hXamlIslandWnd = FindWindowEx(
@@ -1641,6 +1846,7 @@ void HandleIdentifiedSecondaryTaskbarWindow(HWND hWnd) {
 
     g_secondaryTaskbarWindows.insert(hWnd);
     SubclassTaskbarWindow(hWnd);
+    InvalidateScrollAreaTable();
 
     if (g_nExplorerVersion >= WIN_VERSION_11_21H2 && !g_inputSiteProcHooked) {
         HWND hXamlIslandWnd = FindWindowEx(
@@ -2157,48 +2363,16 @@ LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam) {
     if (g_settings.fullScreenScrolling != FullScreenScrolling::disabled) {
         POINT pt = pMouseStruct->pt;
 
-        HWND hPointWnd = WindowFromPoint(pt);
-        if (hPointWnd) {
-            HWND hRootWnd = GetAncestor(hPointWnd, GA_ROOT);
+        if (IsPointInsideCachedScrollArea(pt)) {
+            // If the taskbar is visible at this point, it handles the event
+            // itself.
+            HWND hPointWnd = WindowFromPoint(pt);
+            HWND hRootWnd =
+                hPointWnd ? GetAncestor(hPointWnd, GA_ROOT) : nullptr;
             if (hRootWnd && IsTaskbarWindow(hRootWnd)) {
                 return CallNextHookEx(nullptr, nCode, wParam, lParam);
             }
-        }
-
-        bool isInScrollArea = false;
-
-        if (IsPointInsideScrollArea(hTaskbarWnd, pt)) {
-            isInScrollArea = true;
-        }
-
-        if (!isInScrollArea) {
-            DWORD dwTaskbarThreadId = g_dwTaskbarThreadId;
-            if (dwTaskbarThreadId) {
-                // EnumThreadWindows returns FALSE if the callback returned
-                // FALSE, i.e. a match was found.
-                if (!EnumThreadWindows(
-                        dwTaskbarThreadId,
-                        [](HWND hWnd, LPARAM lParam)
-                            WINAPI_LAMBDA_RETURN(BOOL) {
-                                WCHAR szClassName[32];
-                                if (GetClassName(hWnd, szClassName,
-                                                 ARRAYSIZE(szClassName)) &&
-                                    _wcsicmp(szClassName,
-                                             L"Shell_SecondaryTrayWnd") == 0) {
-                                    if (IsPointInsideScrollArea(
-                                            hWnd, *(POINT*)lParam)) {
-                                        return FALSE;
-                                    }
-                                }
-                                return TRUE;
-                            },
-                        (LPARAM)&pt)) {
-                    isInScrollArea = true;
-                }
-            }
-        }
 
-        if (isInScrollArea) {
             WORD mode = (g_settings.fullScreenScrolling ==
                          FullScreenScrolling::withoutIndicator)
                             ? 1
@@ -2503,6 +2677,7 @@ BOOL Wh_ModSettingsChanged(BOOL* bReload) {
     *bReload = g_settings.oldTaskbarOnWin11 != prevOldTaskbarOnWin11 ||
                g_settings.middleClickToMute != prevMiddleClickToMute;
     if (!*bReload) {
+        InvalidateScrollAreaTable();
         ScrollAnywhereThreadUninit();
         if (IsMouseHookNeeded()) {
             ScrollAnywhereThreadInit();
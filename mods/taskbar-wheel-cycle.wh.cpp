@@ -2,7 +2,7 @@
 // @id              taskbar-wheel-cycle
 // @name            Cycle taskbar buttons with mouse wheel
 // @description     Use the mouse wheel and/or keyboard shortcuts to cycle between taskbar buttons
-// @version         1.1.11
+// @version         1.1.13
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -102,6 +102,12 @@ struct Region {
     int end;
 };
 
+// An inclusive range of pixel offsets along the taskbar.
+struct ScrollInterval {
+    int start;
+    int end;
+};
+
 struct {
     bool skipMinimizedWindows;
     bool wrapAround;
@@ -126,7 +132,17 @@ std::atomic<bool> g_taskbarViewDllLoaded;
 std::atomic<bool> g_initialized;
 std::atomic<bool> g_explorerPatcherInitialized;
 
-std::unordered_map<void*, void*> g_lastTaskListActiveTaskItem;
+// The last active task item of a task list and its position, as reported by
+// CTaskListWnd::_SetActiveItem. Groups and items can be added or removed
+// without the mod being notified, so the position is validated before use.
+struct TaskListActiveItem {
+    void* taskItem;
+    void* taskBtnGroup;
+    int buttonIndex;
+    int buttonGroupIndexHint;
+};
+
+std::unordered_map<void*, TaskListActiveItem> g_lastTaskListActiveTaskItem;
 
 HWND g_lastScrollTarget = nullptr;
 DWORD g_lastScrollTime;
@@ -415,6 +431,55 @@ HDPA GetTaskBtnGroupsArray(void* taskList_ITaskListUI) {
     return (HDPA)((void**)taskList_ITaskListUI)[offset];
 }
 
+// Locates the active item from its cached position. Only compares group
+// pointers and queries a single group, instead of every task item.
+bool FindCachedActiveItemPosition(int button_groups_count,
+                                  LONG_PTR** button_groups,
+                                  TaskListActiveItem* activeItem,
+                                  int* p_button_group_index,
+                                  int* p_button_index) {
+    if (!activeItem->taskBtnGroup) {
+        return false;
+    }
+
+    int button_group_index = activeItem->buttonGroupIndexHint;
+    if (button_group_index < 0 || button_group_index >= button_groups_count ||
+        button_groups[button_group_index] != activeItem->taskBtnGroup) {
+        button_group_index = -1;
+        for (int i = 0; i < button_groups_count; i++) {
+            if (button_groups[i] == activeItem->taskBtnGroup) {
+                button_group_index = i;
+                break;
+            }
+        }
+
+        if (button_group_index == -1) {
+            return false;
+        }
+
+        activeItem->buttonGroupIndexHint = button_group_index;
+    }
+
+    LONG_PTR* button_group = button_groups[button_group_index];
+    int button_group_type = CTaskBtnGroup_GetGroupType(button_group);
+    if (button_group_type != 1 && button_group_type != 3) {
+        return false;
+    }
+
+    int button_index = activeItem->buttonIndex;
+    if (button_index < 0 ||
+        button_index >= CTaskBtnGroup_GetNumItems(button_group) ||
+        CTaskBtnGroup_GetTaskItem(button_group, button_index) !=
+            activeItem->taskItem) {
+        return false;
+    }
+
+    *p_button_group_index = button_group_index;
+    *p_button_index = button_index;
+
+    return true;
+}
+
 LONG_PTR* TaskbarScroll(LONG_PTR lpMMTaskListLongPtr,
                         int nRotates,
                         BOOL bSkipMinimized,
@@ -438,15 +503,23 @@ LONG_PTR* TaskbarScroll(LONG_PTR lpMMTaskListLongPtr,
     int button_group_index_active = -1;
     int button_index_active = -1;
 
+    TaskListActiveItem* activeItem = nullptr;
     LONG_PTR* taskItem = src_task_item;
     if (!taskItem) {
         auto it = g_lastTaskListActiveTaskItem.find((void*)lpMMTaskListLongPtr);
         if (it != g_lastTaskListActiveTaskItem.end()) {
-            taskItem = (LONG_PTR*)it->second;
+            activeItem = &it->second;
+            taskItem = (LONG_PTR*)activeItem->taskItem;
         }
     }
 
-    if (taskItem) {
+    bool foundCachedPosition =
+        activeItem &&
+        FindCachedActiveItemPosition(button_groups_count, button_groups,
+                                     activeItem, &button_group_index_active,
+                                     &button_index_active);
+
+    if (taskItem && !foundCachedPosition) {
         for (int i = 0; i < button_groups_count; i++) {
             int button_group_type =
                 CTaskBtnGroup_GetGroupType(button_groups[i]);
@@ -466,6 +539,12 @@ LONG_PTR* TaskbarScroll(LONG_PTR lpMMTaskListLongPtr,
                 }
             }
         }
+
+        if (activeItem && button_group_index_active != -1) {
+            activeItem->taskBtnGroup = button_groups[button_group_index_active];
+            activeItem->buttonIndex = button_index_active;
+            activeItem->buttonGroupIndexHint = button_group_index_active;
+        }
     }
 
     return TaskbarScrollHelper(button_groups_count, button_groups,
@@ -677,10 +756,88 @@ std::optional<Region> ParseRegion(std::wstring_view regionStr) {
     return Region{isPercentage, start, end};
 }
 
+// The custom scroll regions resolved for a taskbar. Only used from the taskbar
+// thread.
+struct TaskbarScrollIntervals {
+    int regionsVersion;
+    int taskbarLength;
+    UINT dpi;
+    std::vector<ScrollInterval> intervals;
+};
+
+std::unordered_map<HWND, TaskbarScrollIntervals> g_taskbarScrollIntervals;
+
+// Incremented when the custom scroll regions change.
+std::atomic<int> g_customScrollRegionsVersion;
+
 bool HasCustomScrollRegions() {
     return !g_settings.customScrollRegions.empty();
 }
 
+// Resolves regions to pixel intervals along a taskbar of the given length,
+// sorted by start and with overlapping or adjacent intervals merged.
+std::vector<ScrollInterval> ResolveScrollIntervals(
+    const std::vector<Region>& regions,
+    int taskbarLength,
+    UINT dpi) {
+    std::vector<ScrollInterval> intervals;
+    intervals.reserve(regions.size());
+
+    for (const auto& region : regions) {
+        int start, end;
+        if (region.isPercentage) {
+            start = MulDiv(taskbarLength, region.start, 100);
+            end = MulDiv(taskbarLength, region.end, 100);
+        } else {
+            start = MulDiv(region.start, dpi, 96);
+            end = MulDiv(region.end, dpi, 96);
+        }
+
+        intervals.push_back({start, end});
+    }
+
+    std::sort(intervals.begin(), intervals.end(),
+              [](const ScrollInterval& a, const ScrollInterval& b) {
+                  return a.start < b.start;
+              });
+
+    size_t merged = 0;
+    for (size_t i = 0; i < intervals.size(); i++) {
+        if (merged > 0 && intervals[i].start <= intervals[merged - 1].end + 1) {
+            intervals[merged - 1].end =
+                std::max(intervals[merged - 1].end, intervals[i].end);
+        } else {
+            intervals[merged++] = intervals[i];
+        }
+    }
+
+    intervals.resize(merged);
+    return intervals;
+}
+
+bool IsOffsetInsideScrollIntervals(const std::vector<ScrollInterval>& intervals,
+                                   int offset) {
+    // The first interval which starts after the offset, the one before it is
+    // the only candidate.
+    auto it = std::upper_bound(
+        intervals.begin(), intervals.end(), offset,
+        [](int value, const ScrollInterval& interval) {
+            return value < interval.start;
+        });
+    if (it == intervals.begin()) {
+        return false;
+    }
+
+    return offset <= std::prev(it)->end;
+}
+
+// Called from the taskbar window procedures.
+void OnTaskbarScrollIntervalsWndProc(HWND hWnd, UINT Msg) {
+    if (Msg == WM_DPICHANGED || Msg == WM_NCDESTROY) {
+        g_taskbarScrollIntervals.erase(hWnd);
+    }
+}
+
 bool IsPointInsideCustomRegion(HWND hMMTaskbarWnd, POINT pt) {
     RECT rc;
     if (!GetWindowRect(hMMTaskbarWnd, &rc) || !PtInRect(&rc, pt)) {
@@ -702,24 +859,28 @@ bool IsPointInsideCustomRegion(HWND hMMTaskbarWnd, POINT pt) {
         cursorOffset = pt.y - rc.top;
     }
 
-    UINT dpi = GetDpiForWindowWithFallback(hMMTaskbarWnd);
+    int regionsVersion = g_customScrollRegionsVersion;
 
-    for (const auto& region : g_settings.customScrollRegions) {
-        int start, end;
-        if (region.isPercentage) {
-            start = MulDiv(taskbarLength, region.start, 100);
-            end = MulDiv(taskbarLength, region.end, 100);
-        } else {
-            start = MulDiv(region.start, dpi, 96);
-            end = MulDiv(region.end, dpi, 96);
-        }
+    auto it = g_taskbarScrollIntervals.find(hMMTaskbarWnd);
+    if (it == g_taskbarScrollIntervals.end() ||
+        it->second.regionsVersion != regionsVersion ||
+        it->second.taskbarLength != taskbarLength) {
+        // The DPI only changes with WM_DPICHANGED, which drops the entry.
+        UINT dpi = it != g_taskbarScrollIntervals.end()
+                       ? it->second.dpi
+                       : GetDpiForWindowWithFallback(hMMTaskbarWnd);
 
-        if (cursorOffset >= start && cursorOffset <= end) {
-            return true;
-        }
+        TaskbarScrollIntervals& entry = g_taskbarScrollIntervals[hMMTaskbarWnd];
+        entry.regionsVersion = regionsVersion;
+        entry.taskbarLength = taskbarLength;
+        entry.dpi = dpi;
+        entry.intervals = ResolveScrollIntervals(
+            g_settings.customScrollRegions, taskbarLength, dpi);
+
+        return IsOffsetInsideScrollIntervals(entry.intervals, cursorOffset);
     }
 
-    return false;
+    return IsOffsetInsideScrollIntervals(it->second.intervals, cursorOffset);
 }
 
 #pragma endregion  // regions
@@ -1259,9 +1420,16 @@ void WINAPI CTaskListWnd__SetActiveItem_Hook(void* pThis,
                                              int buttonIndex) {
     Wh_Log(L">");
 
-    g_lastTaskListActiveTaskItem[pThis] =
+    TaskListActiveItem& activeItem = g_lastTaskListActiveTaskItem[pThis];
+    void* prevTaskBtnGroup = activeItem.taskBtnGroup;
+    activeItem.taskItem =
         taskBtnGroup ? CTaskBtnGroup_GetTaskItem(taskBtnGroup, buttonIndex)
                      : nullptr;
+    activeItem.taskBtnGroup = taskBtnGroup;
+    activeItem.buttonIndex = buttonIndex;
+    if (taskBtnGroup != prevTaskBtnGroup) {
+        activeItem.buttonGroupIndexHint = -1;
+    }
 
     CTaskListWnd__SetActiveItem_Original(pThis, taskBtnGroup, buttonIndex);
 }
@@ -1344,6 +1512,8 @@ LRESULT WINAPI TrayUI_WndProc_Hook(void* pThis,
                                    WPARAM wParam,
                                    LPARAM lParam,
                                    bool* flag) {
+    OnTaskbarScrollIntervalsWndProc(hWnd, Msg);
+
     if (Msg == WM_MOUSEWHEEL && g_settings.enableMouseWheelCycling) {
         HWND hTaskListWnd = TaskListFromTaskbarWnd(hWnd);
 
@@ -1384,6 +1554,8 @@ LRESULT WINAPI CSecondaryTray_v_WndProc_Hook(void* pThis,
                                              UINT Msg,
                                              WPARAM wParam,
                                              LPARAM lParam) {
+    OnTaskbarScrollIntervalsWndProc(hWnd, Msg);
+
     if (Msg == WM_MOUSEWHEEL && g_settings.enableMouseWheelCycling) {
         HWND hSecondaryTaskListWnd = TaskListFromSecondaryTaskbarWnd(hWnd);
 
@@ -1506,6 +1678,7 @@ void LoadSettings() {
         }
     }
     Wh_FreeStringSetting(customScrollRegions);
+    g_customScrollRegionsVersion++;
 
     g_settings.cycleLeftKeyboardShortcut =
         WindhawkUtils::StringSetting::make(L"cycleLeftKeyboardShortcut");
@@ -2,7 +2,7 @@
 // @id              windows-11-file-explorer-styler
 // @name            Windows 11 File Explorer Styler
 // @description     Customize the File Explorer with themes contributed by others or create your own
-// @version         1.6
+// @version         1.6.4
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -439,9 +439,11 @@ from the **TranslucentTB** project.
 
 #include <winrt/Microsoft.UI.Xaml.h>
 
+// Themes are constant-initialized, with the lists backed by static read-only
+// arrays, so that loading the mod doesn't construct any of them.
 struct ThemeTargetStyles {
     PCWSTR target;
-    std::vector<PCWSTR> styles;
+    std::initializer_list<PCWSTR> styles;
 };
 
 enum class BackgroundTranslucentEffect {
@@ -453,9 +455,9 @@ enum class BackgroundTranslucentEffect {
 };
 
 struct Theme {
-    std::vector<ThemeTargetStyles> targetStyles;
-    std::vector<PCWSTR> styleConstants;
-    std::vector<PCWSTR> themeResourceVariables;
+    std::initializer_list<ThemeTargetStyles> targetStyles;
+    std::initializer_list<PCWSTR> styleConstants;
+    std::initializer_list<PCWSTR> themeResourceVariables;
     int explorerFrameContainerHeight = 0;
     BackgroundTranslucentEffect backgroundTranslucentEffect =
         BackgroundTranslucentEffect::kDefault;
@@ -463,7 +465,7 @@ struct Theme {
 
 // clang-format off
 
-const Theme g_themeTranslucent_Explorer11 = {{
+constexpr Theme g_themeTranslucent_Explorer11 = {{
     ThemeTargetStyles{L"FileExplorerExtensions.CommandBarControl_Wave1 > Grid, Grid#CommandBarControlRootGrid", {
         L"Background=Transparent",
         L"BorderThickness=0,0,0,1",
@@ -488,7 +490,7 @@ const Theme g_themeTranslucent_Explorer11 = {{
         L"Background=Transparent"}},
 }, {}, {}, /*explorerFrameContainerHeight=*/0, BackgroundTranslucentEffect::kAcrylic};
 
-const Theme g_themeMicaBar = {{
+constexpr Theme g_themeMicaBar = {{
     ThemeTargetStyles{L"FileExplorerExtensions.CommandBarControl_Wave1 > Grid, Grid#CommandBarControlRootGrid", {
         L"Background:=<SolidColorBrush Color=\"{ThemeResource LayerOnMicaBaseAltFillColorDefault}\"/>",
         L"BorderThickness=0,0,0,1"}},
@@ -496,7 +498,7 @@ const Theme g_themeMicaBar = {{
         L"Background=Transparent"}},
 }};
 
-const Theme g_themeNoCommandBar = {{
+constexpr Theme g_themeNoCommandBar = {{
     ThemeTargetStyles{L"FileExplorerExtensions.CommandBarControl_Wave1, FileExplorerExtensions.CommandBarControl", {
         L"Visibility=Collapsed"}},
     ThemeTargetStyles{L"FileExplorerExtensions.NavigationBarControl", {
@@ -504,7 +506,7 @@ const Theme g_themeNoCommandBar = {{
         L"Margin=0,0,0,1"}},
 }, {}, {}, /*explorerFrameContainerHeight=*/87};
 
-const Theme g_themeMinimal_Explorer11 = {{
+constexpr Theme g_themeMinimal_Explorer11 = {{
     ThemeTargetStyles{L"AppBarButton#backButton > Grid#Root@CommonStates > Border#AppBarButtonInnerBorder", {
         L"Background@Normal:=<AcrylicBrush TintColor=\"Transparent\" Opacity=\"0.07\"/>",
         L"Background@PointerOver:=<AcrylicBrush TintColor=\"Transparent\" Opacity=\"0.12\"/>",
@@ -588,7 +590,7 @@ const Theme g_themeMinimal_Explorer11 = {{
         L"HorizontalAlignment=0"}},
 }, {}, {}, /*explorerFrameContainerHeight=*/42};
 
-const Theme g_themeTabless = {{
+constexpr Theme g_themeTabless = {{
     ThemeTargetStyles{L"FileExplorerExtensions.CommandBarControl_Wave1 > Grid, Grid#CommandBarControlRootGrid", {
         L"Background=Transparent"}},
     ThemeTargetStyles{L"Microsoft.UI.Xaml.Controls.Grid#ContentRoot", {
@@ -625,7 +627,7 @@ const Theme g_themeTabless = {{
     L"CommandBarGrid=1",
 }};
 
-const Theme g_themeMatter = {{
+constexpr Theme g_themeMatter = {{
     ThemeTargetStyles{L"CommandBar#FileExplorerCommandBar", {
         L"Background=Transparent",
         L"HorizontalAlignment  = 1"}},
@@ -703,7 +705,7 @@ const Theme g_themeMatter = {{
     L"accentColor2=<SolidColorBrush Color=\"{ThemeResource SystemAccentColorLight1}\" Opacity=\"0.5\" />",
 }};
 
-const Theme g_themeWindowGlass = {{
+constexpr Theme g_themeWindowGlass = {{
     ThemeTargetStyles{L"Microsoft.UI.Xaml.Controls.Grid#PART_LayoutRoot", {
         L"Background=Transparent",
         L"RenderTransform:=<TranslateTransform X=\"0\"/>"}},
@@ -845,7 +847,7 @@ const Theme g_themeWindowGlass = {{
     L"MainContentBG=<SolidColorBrush Color=\"{ThemeResource SystemChromeAltHighColor}\" Opacity=\"1\" />",
 }, {}, /*explorerFrameContainerHeight=*/0, BackgroundTranslucentEffect::kAcrylic};
 
-const Theme g_themeAddressSearchOnly = {{
+constexpr Theme g_themeAddressSearchOnly = {{
     ThemeTargetStyles{L"FileExplorerExtensions.NavigationBarControl", {
         L"Grid.Row=0",
         L"Background=Transparent",
@@ -865,7 +867,7 @@ const Theme g_themeAddressSearchOnly = {{
         L"Visibility=Collapsed"}},
 }, {}, {}, /*explorerFrameContainerHeight=*/80};
 
-const Theme g_themeTintedGlass = {{
+constexpr Theme g_themeTintedGlass = {{
     ThemeTargetStyles{L"FileExplorerExtensions.CommandBarControl_Wave1 > Grid, Grid#CommandBarControlRootGrid", {
         L"Background:=$CommonBgBrush",
         L"BorderThickness=0,0,0,0",
@@ -892,7 +894,7 @@ const Theme g_themeTintedGlass = {{
     L"CommonBgBrush=<WindhawkBlur BlurAmount=\"18\" TintColor=\"#80000000\"/>",
 }, {}, /*explorerFrameContainerHeight=*/0, BackgroundTranslucentEffect::kAcrylic};
 
-const Theme g_themeLiquidGlass = {{
+constexpr Theme g_themeLiquidGlass = {{
     ThemeTargetStyles{L"Microsoft.UI.Xaml.Controls.Grid#PART_LayoutRoot", {
         L"Background=Transparent",
         L"HorizontalAlignment=Stretch"}},
@@ -1011,7 +1013,7 @@ const Theme g_themeLiquidGlass = {{
     L"ElementCornerRadius=8",
 }, {}, /*explorerFrameContainerHeight=*/87};
 
-const Theme g_themeMicaTabless = {{
+constexpr Theme g_themeMicaTabless = {{
     ThemeTargetStyles{L"FileExplorerExtensions.CommandBarControl_Wave1 > Grid, Grid#CommandBarControlRootGrid", {
         L"Background=Transparent"}},
     ThemeTargetStyles{L"Microsoft.UI.Xaml.Controls.Grid#ContentRoot", {
@@ -1052,7 +1054,7 @@ const Theme g_themeMicaTabless = {{
     L"CommandBarGrid=2",
 }};
 
-const Theme g_themeOS26_Liquid_Glass = {{
+constexpr Theme g_themeOS26_Liquid_Glass = {{
     ThemeTargetStyles{L"Grid#DetailsViewControlRootGrid", {
         L"Margin=20,20,20,1",
         L"Background:=<WindhawkBlur BlurAmount=\"30\" TintColor=\"#2D101010\" TintOpacity=\"0.4\"/>",
@@ -1188,7 +1190,7 @@ const Theme g_themeOS26_Liquid_Glass = {{
         L"Margin=0,9,9,0"}},
 }};
 
-const Theme g_themeOS26_Liquid_Glass_variant_Compact = {{
+constexpr Theme g_themeOS26_Liquid_Glass_variant_Compact = {{
     ThemeTargetStyles{L"Microsoft.UI.Xaml.Controls.Primitives.SuggestionsPopup", {
         L"Margin=0,0,0,900"}},
     ThemeTargetStyles{L"Microsoft.UI.Xaml.Controls.AppBarButton > Grid@CommonStates", {
@@ -1383,7 +1385,7 @@ const Theme g_themeOS26_Liquid_Glass_variant_Compact = {{
         L"Grid.RowSpan=2"}},
 }, {}, {}, /*explorerFrameContainerHeight=*/87};
 
-const Theme g_themeZEUSosX_044 = {{
+constexpr Theme g_themeZEUSosX_044 = {{
     ThemeTargetStyles{L"FileExplorerExtensions.CommandBarControl_Wave1 > Grid, Grid#CommandBarControlRootGrid", {
         L"Background=Transparent",
         L"BorderThickness=0",
@@ -1444,7 +1446,7 @@ const Theme g_themeZEUSosX_044 = {{
         L"FontSize=14"}},
 }, {}, {}, /*explorerFrameContainerHeight=*/44, BackgroundTranslucentEffect::kMica};
 
-const Theme g_themeCompact_Explorer11 = {{
+constexpr Theme g_themeCompact_Explorer11 = {{
     ThemeTargetStyles{L"Microsoft.UI.Xaml.Controls.Primitives.SuggestionsPopup", {
         L"Margin=0,0,0,900"}},
     ThemeTargetStyles{L"Microsoft.UI.Xaml.Controls.AppBarButton > Grid@CommonStates", {
@@ -1627,7 +1629,7 @@ const Theme g_themeCompact_Explorer11 = {{
         L"Grid.RowSpan=2"}},
 }, {}, {}, /*explorerFrameContainerHeight=*/87};
 
-const Theme g_themeFloat = {{
+constexpr Theme g_themeFloat = {{
     ThemeTargetStyles{L"TabViewItem > Grid#LayoutRoot@CommonStates", {
         L"Background@Selected:=<AcrylicBrush TintColor=\"{ThemeResource Tab}\" TintOpacity=\"0.9\" Opacity=\"0.6\"/>",
         L"Background@PointerOverSelected:=<AcrylicBrush TintColor=\"{ThemeResource Tab}\" TintOpacity=\"0.9\" Opacity=\"0.7\"/>",
@@ -2481,11 +2483,29 @@ struct CapturePropertyCustomizationState {
 };
 
 struct ElementCustomizationStateForVisualStateGroup {
-    std::unordered_map<DependencyProperty, ElementPropertyCustomizationState>
+    // A flat vector rather than a map, since an element rarely has more than a
+    // few customized properties. It's reserved for all of them before the first
+    // one is added and never grows afterwards, as the property changed
+    // callbacks hold references to the entries.
+    std::vector<
+        std::pair<DependencyProperty, ElementPropertyCustomizationState>>
         propertyCustomizationStates;
     winrt::event_token visualStateGroupCurrentStateChangedToken;
 };
 
+ElementPropertyCustomizationState* FindPropertyCustomizationState(
+    ElementCustomizationStateForVisualStateGroup& stateForVisualStateGroup,
+    DependencyProperty const& property) {
+    for (auto& [itemProperty, propertyCustomizationState] :
+         stateForVisualStateGroup.propertyCustomizationStates) {
+        if (itemProperty == property) {
+            return &propertyCustomizationState;
+        }
+    }
+
+    return nullptr;
+}
+
 struct ElementCustomizationState {
     winrt::weak_ref<FrameworkElement> element;
 
@@ -2507,10 +2527,11 @@ struct ElementCustomizationState {
     // changes.
     winrt::event_token captureSizeChangedToken;
 
-    // Use list to avoid reallocations on insertion, as pointers to items are
-    // captured in callbacks and stored.
-    std::list<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
-                        ElementCustomizationStateForVisualStateGroup>>
+    // Pointers to items are captured in callbacks and stored, so the vector is
+    // reserved for all of the element's visual state groups before the first
+    // one is added, and never grows afterwards.
+    std::vector<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
+                          ElementCustomizationStateForVisualStateGroup>>
         perVisualStateGroup;
 };
 
@@ -6690,12 +6711,12 @@ void PropagateStyleVariableChangeCore(
                 : consumer.fallbackClassName.c_str();
 
         for (auto& [vsgWeak, vsgState] : elementState.perVisualStateGroup) {
-            auto propIt =
-                vsgState.propertyCustomizationStates.find(consumer.property);
-            if (propIt == vsgState.propertyCustomizationStates.end()) {
+            auto* propStatePtr =
+                FindPropertyCustomizationState(vsgState, consumer.property);
+            if (!propStatePtr) {
                 continue;
             }
-            auto& propState = propIt->second;
+            auto& propState = *propStatePtr;
             if (!propState.dynamicTemplate) {
                 continue;
             }
@@ -7002,16 +7023,17 @@ void ApplyCustomizationsForVisualStateGroup(
     std::wstring currentVisualStateName(
         currentVisualState ? currentVisualState.Name() : L"");
 
-    for (const auto& [property, valuesPerVisualState] : propertyOverrides) {
-        const auto [propertyCustomizationStatesIt, inserted] =
-            elementCustomizationStateForVisualStateGroup
-                ->propertyCustomizationStates.insert({property, {}});
-        if (!inserted) {
-            continue;
-        }
+    // Property keys are unique, so each one gets a new entry. Reserved up front
+    // since the callbacks registered below hold references to the entries.
+    elementCustomizationStateForVisualStateGroup->propertyCustomizationStates
+        .reserve(propertyOverrides.size());
 
+    for (const auto& [property, valuesPerVisualState] : propertyOverrides) {
         auto& propertyCustomizationState =
-            propertyCustomizationStatesIt->second;
+            elementCustomizationStateForVisualStateGroup
+                ->propertyCustomizationStates
+                .emplace_back(property, ElementPropertyCustomizationState{})
+                .second;
 
         auto it = valuesPerVisualState.find(currentVisualStateName);
         if (it == valuesPerVisualState.end() &&
@@ -7108,10 +7130,6 @@ void ApplyCustomizationsForVisualStateGroup(
 
                     g_elementPropertyModifying = true;
 
-                    auto& propertyCustomizationStates =
-                        elementCustomizationStateForVisualStateGroup
-                            ->propertyCustomizationStates;
-
                     PCWSTR fallbackClassNamePtr =
                         fallbackClassNameStr.empty()
                             ? nullptr
@@ -7120,7 +7138,9 @@ void ApplyCustomizationsForVisualStateGroup(
                     for (const auto& [property, valuesPerVisualState] :
                          propertyOverrides) {
                         auto& propertyCustomizationState =
-                            propertyCustomizationStates.at(property);
+                            *FindPropertyCustomizationState(
+                                *elementCustomizationStateForVisualStateGroup,
+                                property);
 
                         auto newState = e.NewState();
                         auto newStateName =
@@ -7445,6 +7465,8 @@ void ApplyCustomizations(InstanceHandle handle,
 
     elementCustomizationState.element = element;
     elementCustomizationState.perVisualStateGroup.clear();
+    elementCustomizationState.perVisualStateGroup.reserve(
+        resolved.overridesPerVSG.size());
 
     // Elements that neither capture nor consume a variable pay nothing. The
     // rest get their spine now that the element has been matched; if it isn't
@@ -7624,7 +7646,7 @@ std::optional<StyleConstant> ParseStyleConstant(
 }
 
 StyleConstants LoadStyleConstants(
-    const std::vector<PCWSTR>& themeStyleConstants) {
+    std::initializer_list<PCWSTR> themeStyleConstants) {
     StyleConstants result;
 
     auto addToResult = [&result](StyleConstant sc) {
@@ -8247,7 +8269,7 @@ void RefreshThemeResourceEntries() {
 
 std::vector<ResourceVariableEntry> ProcessResourceVariablesFromSettings(
     const StyleConstants& styleConstants,
-    const std::vector<PCWSTR>& themeResourceVariables) {
+    std::initializer_list<PCWSTR> themeResourceVariables) {
     std::vector<ResourceVariableEntry> resourceVariables;
 
     for (const auto& themeResourceVariable : themeResourceVariables) {
@@ -8330,41 +8352,69 @@ void MergeResourceVariables() {
     }
 }
 
+// FNV-1a hash of a theme name, used to pick the selected theme with a single
+// switch instead of comparing against each theme name in turn.
+constexpr UINT64 ThemeNameHash(std::wstring_view name) {
+    UINT64 hash = 14695981039346656037ULL;
+    for (WCHAR c : name) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
 const Theme* GetSelectedTheme() {
     PCWSTR themeName = Wh_GetStringSetting(L"theme");
     const Theme* theme = nullptr;
-    if (wcscmp(themeName, L"Translucent Explorer11") == 0) {
-        theme = &g_themeTranslucent_Explorer11;
-    } else if (wcscmp(themeName, L"MicaBar") == 0) {
-        theme = &g_themeMicaBar;
-    } else if (wcscmp(themeName, L"NoCommandBar") == 0) {
-        theme = &g_themeNoCommandBar;
-    } else if (wcscmp(themeName, L"Minimal Explorer11") == 0) {
-        theme = &g_themeMinimal_Explorer11;
-    } else if (wcscmp(themeName, L"Tabless") == 0) {
-        theme = &g_themeTabless;
-    } else if (wcscmp(themeName, L"Matter") == 0) {
-        theme = &g_themeMatter;
-    } else if (wcscmp(themeName, L"WindowGlass") == 0) {
-        theme = &g_themeWindowGlass;
-    } else if (wcscmp(themeName, L"AddressSearchOnly") == 0) {
-        theme = &g_themeAddressSearchOnly;
-    } else if (wcscmp(themeName, L"TintedGlass") == 0) {
-        theme = &g_themeTintedGlass;
-    } else if (wcscmp(themeName, L"LiquidGlass") == 0) {
-        theme = &g_themeLiquidGlass;
-    } else if (wcscmp(themeName, L"MicaTabless") == 0) {
-        theme = &g_themeMicaTabless;
-    } else if (wcscmp(themeName, L"OS26 Liquid Glass") == 0) {
-        theme = &g_themeOS26_Liquid_Glass;
-    } else if (wcscmp(themeName, L"OS26 Liquid Glass_variant_Compact") == 0) {
-        theme = &g_themeOS26_Liquid_Glass_variant_Compact;
-    } else if (wcscmp(themeName, L"ZEUSosX_044") == 0) {
-        theme = &g_themeZEUSosX_044;
-    } else if (wcscmp(themeName, L"Compact Explorer11") == 0) {
-        theme = &g_themeCompact_Explorer11;
-    } else if (wcscmp(themeName, L"Float") == 0) {
-        theme = &g_themeFloat;
+    switch (ThemeNameHash(themeName)) {
+        case ThemeNameHash(L"Translucent Explorer11"):
+            theme = &g_themeTranslucent_Explorer11;
+            break;
+        case ThemeNameHash(L"MicaBar"):
+            theme = &g_themeMicaBar;
+            break;
+        case ThemeNameHash(L"NoCommandBar"):
+            theme = &g_themeNoCommandBar;
+            break;
+        case ThemeNameHash(L"Minimal Explorer11"):
+            theme = &g_themeMinimal_Explorer11;
+            break;
+        case ThemeNameHash(L"Tabless"):
+            theme = &g_themeTabless;
+            break;
+        case ThemeNameHash(L"Matter"):
+            theme = &g_themeMatter;
+            break;
+        case ThemeNameHash(L"WindowGlass"):
+            theme = &g_themeWindowGlass;
+            break;
+        case ThemeNameHash(L"AddressSearchOnly"):
+            theme = &g_themeAddressSearchOnly;
+            break;
+        case ThemeNameHash(L"TintedGlass"):
+            theme = &g_themeTintedGlass;
+            break;
+        case ThemeNameHash(L"LiquidGlass"):
+            theme = &g_themeLiquidGlass;
+            break;
+        case ThemeNameHash(L"MicaTabless"):
+            theme = &g_themeMicaTabless;
+            break;
+        case ThemeNameHash(L"OS26 Liquid Glass"):
+            theme = &g_themeOS26_Liquid_Glass;
+            break;
+        case ThemeNameHash(L"OS26 Liquid Glass_variant_Compact"):
+            theme = &g_themeOS26_Liquid_Glass_variant_Compact;
+            break;
+        case ThemeNameHash(L"ZEUSosX_044"):
+            theme = &g_themeZEUSosX_044;
+            break;
+        case ThemeNameHash(L"Compact Explorer11"):
+            theme = &g_themeCompact_Explorer11;
+            break;
+        case ThemeNameHash(L"Float"):
+            theme = &g_themeFloat;
+            break;
     }
     Wh_FreeStringSetting(themeName);
     return theme;
@@ -8374,7 +8424,7 @@ void ProcessAllStylesFromSettings() {
     const Theme* theme = GetSelectedTheme();
 
     StyleConstants styleConstants = LoadStyleConstants(
-        theme ? theme->styleConstants : std::vector<PCWSTR>{});
+        theme ? theme->styleConstants : std::initializer_list<PCWSTR>{});
 
     if (theme) {
         for (const auto& themeTargetStyle : theme->targetStyles) {
@@ -8407,8 +8457,8 @@ void ProcessAllStylesFromSettings() {
     }
 
     g_resourceVariables = ProcessResourceVariablesFromSettings(
-        styleConstants,
-        theme ? theme->themeResourceVariables : std::vector<PCWSTR>{});
+        styleConstants, theme ? theme->themeResourceVariables
+                              : std::initializer_list<PCWSTR>{});
 }
 
 void UninitializeResourceVariables() {
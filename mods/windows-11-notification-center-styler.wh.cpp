@@ -2,7 +2,7 @@
 // @id              windows-11-notification-center-styler
 // @name            Windows 11 Notification Center Styler
 // @description     Customize the Notification Center and Action Center with themes contributed by others or create your own
-// @version         1.6
+// @version         1.6.4
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -410,20 +410,22 @@ from the **TranslucentTB** project.
 
 #include <winrt/Windows.UI.Xaml.h>
 
+// Themes are constant-initialized, with the lists backed by static read-only
+// arrays, so that loading the mod doesn't construct any of them.
 struct ThemeTargetStyles {
     PCWSTR target;
-    std::vector<PCWSTR> styles;
+    std::initializer_list<PCWSTR> styles;
 };
 
 struct Theme {
-    std::vector<ThemeTargetStyles> targetStyles;
-    std::vector<PCWSTR> styleConstants;
-    std::vector<PCWSTR> themeResourceVariables;
+    std::initializer_list<ThemeTargetStyles> targetStyles;
+    std::initializer_list<PCWSTR> styleConstants;
+    std::initializer_list<PCWSTR> themeResourceVariables;
 };
 
 // clang-format off
 
-const Theme g_themeTranslucentShell = {{
+constexpr Theme g_themeTranslucentShell = {{
     ThemeTargetStyles{L"Grid#NotificationCenterGrid", {
         L"Background:=$CommonBgBrush",
         L"BorderThickness=0,0,0,0",
@@ -521,7 +523,7 @@ const Theme g_themeTranslucentShell = {{
     L"thumbnailImageSize=300",
 }};
 
-const Theme g_themeMatter = {{
+constexpr Theme g_themeMatter = {{
     ThemeTargetStyles{L"Grid#NotificationCenterGrid", {
         L"Background:=$base",
         L"BorderThickness=0,0,0,0",
@@ -802,7 +804,7 @@ const Theme g_themeMatter = {{
     L"thumbnailImageSize = 300",
 }};
 
-const Theme g_themeUnified = {{
+constexpr Theme g_themeUnified = {{
     ThemeTargetStyles{L"ActionCenter.FocusSessionControl", {
         L"Height=0"}},
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#CalendarCenterGrid", {
@@ -831,7 +833,7 @@ const Theme g_themeUnified = {{
         L"BackgroundTransition:=<BrushTransition Duration=\"0:0:0.083\"/>"}},
 }};
 
-const Theme g_theme10JumpLists = {{
+constexpr Theme g_theme10JumpLists = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#JumpListGrid", {
         L"Margin=0,0,0,0",
         L"CornerRadius=0",
@@ -914,7 +916,7 @@ const Theme g_theme10JumpLists = {{
         L"Margin=0"}},
 }};
 
-const Theme g_themeWindowGlass = {{
+constexpr Theme g_themeWindowGlass = {{
     ThemeTargetStyles{L"Grid#NotificationCenterGrid", {
         L"Background:=$Background",
         L"BorderThickness=$BorderThickness",
@@ -1237,7 +1239,7 @@ const Theme g_themeWindowGlass = {{
     L"ElementSysColor4=<SolidColorBrush Color=\"{ThemeResource SystemAccentColorDark1}\" Opacity=\"1\" />",
 }};
 
-const Theme g_themeWindowGlass_variant_alternative = {{
+constexpr Theme g_themeWindowGlass_variant_alternative = {{
     ThemeTargetStyles{L"Grid#NotificationCenterGrid", {
         L"Background:=$Background",
         L"BorderThickness=$BorderThickness",
@@ -1551,7 +1553,7 @@ const Theme g_themeWindowGlass_variant_alternative = {{
     L"ElementSysColor4=<SolidColorBrush Color=\"{ThemeResource SystemAccentColorDark1}\" Opacity=\"1\" />",
 }};
 
-const Theme g_themeOversimplified_Accentuated = {{
+constexpr Theme g_themeOversimplified_Accentuated = {{
     ThemeTargetStyles{L"MenuFlyoutPresenter", {
         L"Background:=$DarkAccent",
         L"BorderBrush=Transparent",
@@ -1830,7 +1832,7 @@ const Theme g_themeOversimplified_Accentuated = {{
     L"Reveal = <RevealBorderBrush Color=\"Transparent\" TargetTheme=\"1\" Opacity=\"1\" />",
 }};
 
-const Theme g_themeTintedGlass = {{
+constexpr Theme g_themeTintedGlass = {{
     ThemeTargetStyles{L"Grid#NotificationCenterGrid", {
         L"Background:=$Base",
         L"BorderThickness=0,0,0,0",
@@ -1929,7 +1931,7 @@ const Theme g_themeTintedGlass = {{
     L"thumbnailImageSize=300",
 }};
 
-const Theme g_themeFluid = {{
+constexpr Theme g_themeFluid = {{
     ThemeTargetStyles{L"MenuFlyoutPresenter", {
         L"BorderBrush:=$BorderBrush",
         L"BorderThickness=1",
@@ -2025,7 +2027,7 @@ const Theme g_themeFluid = {{
     L"CornerRadius=4",
 }};
 
-const Theme g_themeLiquidGlass = {{
+constexpr Theme g_themeLiquidGlass = {{
     ThemeTargetStyles{L"Grid#NotificationCenterGrid", {
         L"Background:=$Background",
         L"CornerRadius = $CornerRadius",
@@ -2329,7 +2331,7 @@ const Theme g_themeLiquidGlass = {{
     L"ElementCornerRadius = 8",
 }};
 
-const Theme g_themeBetterControl11 = {{
+constexpr Theme g_themeBetterControl11 = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.ItemsWrapGrid", {
         L"MaximumRowsOrColumns=2"}},
     ThemeTargetStyles{L"ContentControl#TogglesGroup > ContentPresenter > ControlCenter.PaginatedGridView > Grid > GridView#RootGridView", {
@@ -2598,7 +2600,7 @@ const Theme g_themeBetterControl11 = {{
     L"NativeOverlayBorder@Light=#14000000",
 }};
 
-const Theme g_themeLayerMicaUI = {{
+constexpr Theme g_themeLayerMicaUI = {{
     ThemeTargetStyles{L"Microsoft.UI.Xaml.Controls.AnimatedIcon#BrightnessPlayer", {
         L"Height=22",
         L"Width=22"}},
@@ -3159,7 +3161,7 @@ const Theme g_themeLayerMicaUI = {{
     L"Hover@Dark=#09FFFFFF",
 }};
 
-const Theme g_themeBorderless = {{
+constexpr Theme g_themeBorderless = {{
     ThemeTargetStyles{L"ActionCenter.FocusSessionControl", {
         L"Visibility=Collapsed"}},
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid", {
@@ -3239,7 +3241,7 @@ const Theme g_themeBorderless = {{
         L"MaxWidth=348"}},
 }};
 
-const Theme g_themeDensy = {{
+constexpr Theme g_themeDensy = {{
     ThemeTargetStyles{L"ScrollViewer > ScrollContentPresenter > Border > Frame > ContentPresenter > ActionCenter.NotificationCenterPage > Grid#RootGrid", {
         L"Margin=0,0,0,0"}},
     ThemeTargetStyles{L"ScrollViewer > ScrollContentPresenter > Border > Frame > ContentPresenter > ActionCenter.NotificationCenterPage > Grid#RootGrid > Grid#RootContent > Grid#NotificationCenterGrid", {
@@ -3577,7 +3579,7 @@ const Theme g_themeDensy = {{
     L"thumbnailImageSize=100",
 }};
 
-const Theme g_themeFrostyGlass = {{
+constexpr Theme g_themeFrostyGlass = {{
     ThemeTargetStyles{L"Grid#NotificationCenterGrid", {
         L"CornerRadius=$CornerRadius",
         L"BorderThickness=$BorderThickness",
@@ -4511,11 +4513,29 @@ struct CapturePropertyCustomizationState {
 };
 
 struct ElementCustomizationStateForVisualStateGroup {
-    std::unordered_map<DependencyProperty, ElementPropertyCustomizationState>
+    // A flat vector rather than a map, since an element rarely has more than a
+    // few customized properties. It's reserved for all of them before the first
+    // one is added and never grows afterwards, as the property changed
+    // callbacks hold references to the entries.
+    std::vector<
+        std::pair<DependencyProperty, ElementPropertyCustomizationState>>
         propertyCustomizationStates;
     winrt::event_token visualStateGroupCurrentStateChangedToken;
 };
 
+ElementPropertyCustomizationState* FindPropertyCustomizationState(
+    ElementCustomizationStateForVisualStateGroup& stateForVisualStateGroup,
+    DependencyProperty const& property) {
+    for (auto& [itemProperty, propertyCustomizationState] :
+         stateForVisualStateGroup.propertyCustomizationStates) {
+        if (itemProperty == property) {
+            return &propertyCustomizationState;
+        }
+    }
+
+    return nullptr;
+}
+
 struct ElementCustomizationState {
     winrt::weak_ref<FrameworkElement> element;
 
@@ -4537,10 +4557,11 @@ struct ElementCustomizationState {
     // changes.
     winrt::event_token captureSizeChangedToken;
 
-    // Use list to avoid reallocations on insertion, as pointers to items are
-    // captured in callbacks and stored.
-    std::list<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
-                        ElementCustomizationStateForVisualStateGroup>>
+    // Pointers to items are captured in callbacks and stored, so the vector is
+    // reserved for all of the element's visual state groups before the first
+    // one is added, and never grows afterwards.
+    std::vector<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
+                          ElementCustomizationStateForVisualStateGroup>>
         perVisualStateGroup;
 };
 
@@ -8799,12 +8820,12 @@ void PropagateStyleVariableChangeCore(
                 : consumer.fallbackClassName.c_str();
 
         for (auto& [vsgWeak, vsgState] : elementState.perVisualStateGroup) {
-            auto propIt =
-                vsgState.propertyCustomizationStates.find(consumer.property);
-            if (propIt == vsgState.propertyCustomizationStates.end()) {
+            auto* propStatePtr =
+                FindPropertyCustomizationState(vsgState, consumer.property);
+            if (!propStatePtr) {
                 continue;
             }
-            auto& propState = propIt->second;
+            auto& propState = *propStatePtr;
             if (!propState.dynamicTemplate) {
                 continue;
             }
@@ -9111,16 +9132,17 @@ void ApplyCustomizationsForVisualStateGroup(
     std::wstring currentVisualStateName(
         currentVisualState ? currentVisualState.Name() : L"");
 
-    for (const auto& [property, valuesPerVisualState] : propertyOverrides) {
-        const auto [propertyCustomizationStatesIt, inserted] =
-            elementCustomizationStateForVisualStateGroup
-                ->propertyCustomizationStates.insert({property, {}});
-        if (!inserted) {
-            continue;
-        }
+    // Property keys are unique, so each one gets a new entry. Reserved up front
+    // since the callbacks registered below hold references to the entries.
+    elementCustomizationStateForVisualStateGroup->propertyCustomizationStates
+        .reserve(propertyOverrides.size());
 
+    for (const auto& [property, valuesPerVisualState] : propertyOverrides) {
         auto& propertyCustomizationState =
-            propertyCustomizationStatesIt->second;
+            elementCustomizationStateForVisualStateGroup
+                ->propertyCustomizationStates
+                .emplace_back(property, ElementPropertyCustomizationState{})
+                .second;
 
         auto it = valuesPerVisualState.find(currentVisualStateName);
         if (it == valuesPerVisualState.end() &&
@@ -9217,10 +9239,6 @@ void ApplyCustomizationsForVisualStateGroup(
 
                     g_elementPropertyModifying = true;
 
-                    auto& propertyCustomizationStates =
-                        elementCustomizationStateForVisualStateGroup
-                            ->propertyCustomizationStates;
-
                     PCWSTR fallbackClassNamePtr =
                         fallbackClassNameStr.empty()
                             ? nullptr
@@ -9229,7 +9247,9 @@ void ApplyCustomizationsForVisualStateGroup(
                     for (const auto& [property, valuesPerVisualState] :
                          propertyOverrides) {
                         auto& propertyCustomizationState =
-                            propertyCustomizationStates.at(property);
+                            *FindPropertyCustomizationState(
+                                *elementCustomizationStateForVisualStateGroup,
+                                property);
 
                         auto newState = e.NewState();
                         auto newStateName =
@@ -9554,6 +9574,8 @@ void ApplyCustomizations(InstanceHandle handle,
 
     elementCustomizationState.element = element;
     elementCustomizationState.perVisualStateGroup.clear();
+    elementCustomizationState.perVisualStateGroup.reserve(
+        resolved.overridesPerVSG.size());
 
     // Elements that neither capture nor consume a variable pay nothing. The
     // rest get their spine now that the element has been matched; if it isn't
@@ -9733,7 +9755,7 @@ std::optional<StyleConstant> ParseStyleConstant(
 }
 
 StyleConstants LoadStyleConstants(
-    const std::vector<PCWSTR>& themeStyleConstants) {
+    std::initializer_list<PCWSTR> themeStyleConstants) {
     StyleConstants result;
 
     auto addToResult = [&result](StyleConstant sc) {
@@ -10356,7 +10378,7 @@ void RefreshThemeResourceEntries() {
 
 std::vector<ResourceVariableEntry> ProcessResourceVariablesFromSettings(
     const StyleConstants& styleConstants,
-    const std::vector<PCWSTR>& themeResourceVariables) {
+    std::initializer_list<PCWSTR> themeResourceVariables) {
     std::vector<ResourceVariableEntry> resourceVariables;
 
     for (const auto& themeResourceVariable : themeResourceVariables) {
@@ -10439,44 +10461,71 @@ void MergeResourceVariables() {
     }
 }
 
+// FNV-1a hash of a theme name, used to pick the selected theme with a single
+// switch instead of comparing against each theme name in turn.
+constexpr UINT64 ThemeNameHash(std::wstring_view name) {
+    UINT64 hash = 14695981039346656037ULL;
+    for (WCHAR c : name) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
 void ProcessAllStylesFromSettings() {
     PCWSTR themeName = Wh_GetStringSetting(L"theme");
     const Theme* theme = nullptr;
-    if (wcscmp(themeName, L"TranslucentShell") == 0) {
-        theme = &g_themeTranslucentShell;
-    } else if (wcscmp(themeName, L"Matter") == 0) {
-        theme = &g_themeMatter;
-    } else if (wcscmp(themeName, L"Unified") == 0) {
-        theme = &g_themeUnified;
-    } else if (wcscmp(themeName, L"10JumpLists") == 0) {
-        theme = &g_theme10JumpLists;
-    } else if (wcscmp(themeName, L"WindowGlass") == 0) {
-        theme = &g_themeWindowGlass;
-    } else if (wcscmp(themeName, L"WindowGlass_variant_alternative") == 0) {
-        theme = &g_themeWindowGlass_variant_alternative;
-    } else if (wcscmp(themeName, L"Oversimplified&Accentuated") == 0) {
-        theme = &g_themeOversimplified_Accentuated;
-    } else if (wcscmp(themeName, L"TintedGlass") == 0) {
-        theme = &g_themeTintedGlass;
-    } else if (wcscmp(themeName, L"Fluid") == 0) {
-        theme = &g_themeFluid;
-    } else if (wcscmp(themeName, L"LiquidGlass") == 0) {
-        theme = &g_themeLiquidGlass;
-    } else if (wcscmp(themeName, L"BetterControl11") == 0) {
-        theme = &g_themeBetterControl11;
-    } else if (wcscmp(themeName, L"LayerMicaUI") == 0) {
-        theme = &g_themeLayerMicaUI;
-    } else if (wcscmp(themeName, L"Borderless") == 0) {
-        theme = &g_themeBorderless;
-    } else if (wcscmp(themeName, L"Densy") == 0) {
-        theme = &g_themeDensy;
-    } else if (wcscmp(themeName, L"FrostyGlass") == 0) {
-        theme = &g_themeFrostyGlass;
+    switch (ThemeNameHash(themeName)) {
+        case ThemeNameHash(L"TranslucentShell"):
+            theme = &g_themeTranslucentShell;
+            break;
+        case ThemeNameHash(L"Matter"):
+            theme = &g_themeMatter;
+            break;
+        case ThemeNameHash(L"Unified"):
+            theme = &g_themeUnified;
+            break;
+        case ThemeNameHash(L"10JumpLists"):
+            theme = &g_theme10JumpLists;
+            break;
+        case ThemeNameHash(L"WindowGlass"):
+            theme = &g_themeWindowGlass;
+            break;
+        case ThemeNameHash(L"WindowGlass_variant_alternative"):
+            theme = &g_themeWindowGlass_variant_alternative;
+            break;
+        case ThemeNameHash(L"Oversimplified&Accentuated"):
+            theme = &g_themeOversimplified_Accentuated;
+            break;
+        case ThemeNameHash(L"TintedGlass"):
+            theme = &g_themeTintedGlass;
+            break;
+        case ThemeNameHash(L"Fluid"):
+            theme = &g_themeFluid;
+            break;
+        case ThemeNameHash(L"LiquidGlass"):
+            theme = &g_themeLiquidGlass;
+            break;
+        case ThemeNameHash(L"BetterControl11"):
+            theme = &g_themeBetterControl11;
+            break;
+        case ThemeNameHash(L"LayerMicaUI"):
+            theme = &g_themeLayerMicaUI;
+            break;
+        case ThemeNameHash(L"Borderless"):
+            theme = &g_themeBorderless;
+            break;
+        case ThemeNameHash(L"Densy"):
+            theme = &g_themeDensy;
+            break;
+        case ThemeNameHash(L"FrostyGlass"):
+            theme = &g_themeFrostyGlass;
+            break;
     }
     Wh_FreeStringSetting(themeName);
 
     StyleConstants styleConstants = LoadStyleConstants(
-        theme ? theme->styleConstants : std::vector<PCWSTR>{});
+        theme ? theme->styleConstants : std::initializer_list<PCWSTR>{});
 
     if (theme) {
         for (const auto& themeTargetStyle : theme->targetStyles) {
@@ -10509,8 +10558,8 @@ void ProcessAllStylesFromSettings() {
     }
 
     g_resourceVariables = ProcessResourceVariablesFromSettings(
-        styleConstants,
-        theme ? theme->themeResourceVariables : std::vector<PCWSTR>{});
+        styleConstants, theme ? theme->themeResourceVariables
+                              : std::initializer_list<PCWSTR>{});
 }
 
 void UninitializeResourceVariables() {
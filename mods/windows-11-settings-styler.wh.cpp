@@ -2,7 +2,7 @@
 // @id              windows-11-settings-styler
 // @name            Windows 11 Settings Styler
 // @description     Customize the Windows Settings app with themes contributed by others or create your own
-// @version         1.1
+// @version         1.1.2
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -138,20 +138,22 @@ from the **TranslucentTB** project.
 
 #include <winrt/Windows.UI.Xaml.h>
 
+// Themes are constant-initialized, with the lists backed by static read-only
+// arrays, so that loading the mod doesn't construct any of them.
 struct ThemeTargetStyles {
     PCWSTR target;
-    std::vector<PCWSTR> styles;
+    std::initializer_list<PCWSTR> styles;
 };
 
 struct Theme {
-    std::vector<ThemeTargetStyles> targetStyles;
-    std::vector<PCWSTR> styleConstants;
-    std::vector<PCWSTR> themeResourceVariables;
+    std::initializer_list<ThemeTargetStyles> targetStyles;
+    std::initializer_list<PCWSTR> styleConstants;
+    std::initializer_list<PCWSTR> themeResourceVariables;
 };
 
 // clang-format off
 
-const Theme g_themeDensy = {{
+constexpr Theme g_themeDensy = {{
     ThemeTargetStyles{L"SystemSettings.View.RootPage > Grid#RootPageGrid > Grid#RootCommandSearchGrid > SystemSettings.View.SettingsAutoSuggestCommandSearchBox#CommandSearchBox", {
         L"Margin=0,0,0,0"}},
     ThemeTargetStyles{L"SystemSettings.View.RootPage > Grid#RootPageGrid > Microsoft.UI.Xaml.Controls.NavigationView#PermanentNavigationView > Grid#RootGrid > Grid > SplitView#RootSplitView > Grid > Grid#PaneRoot > Border > Grid#PaneContentGrid > Grid#ItemsContainerGrid > Microsoft.UI.Xaml.Controls.ItemsRepeaterScrollHost > ScrollViewer#MenuItemsScrollViewer > Border#Root > Grid > ScrollContentPresenter#ScrollContentPresenter > Microsoft.UI.Xaml.Controls.ItemsRepeater#MenuItemsHost > SystemSettings.View.SettingsNavigationViewItem > Grid#NVIRootGrid > Microsoft.UI.Xaml.Controls.Primitives.NavigationViewItemPresenter#NavigationViewItemPresenter > Grid#LayoutRoot", {
@@ -407,7 +409,7 @@ const Theme g_themeDensy = {{
     L"Icon_Margin=0,0,8,0",
 }};
 
-const Theme g_themeClassicSearchBar = {{
+constexpr Theme g_themeClassicSearchBar = {{
     ThemeTargetStyles{L"Grid@DisplayModeStates > Grid#PaneRoot > Border > Grid#PaneContentGrid > Grid#ItemsContainerGrid", {
         L"Margin=0,52,0,0",
         L"Margin@OpenOverlayLeft=-11,-15,0,0",
@@ -445,7 +447,7 @@ const Theme g_themeClassicSearchBar = {{
         L"Margin=140,-125,0,0"}},
 }};
 
-const Theme g_themeStoreFrame11 = {{
+constexpr Theme g_themeStoreFrame11 = {{
     ThemeTargetStyles{L"Border > Frame > ContentPresenter > SystemSettings.View.RootPage > Grid#RootPageGrid > Microsoft.UI.Xaml.Controls.NavigationView#PermanentNavigationView > Grid#RootGrid > Grid > SplitView#RootSplitView > Grid > Grid#ContentRoot > Border > Grid#ContentGrid > ContentPresenter#ContentPresenter", {
         L"Margin=2"}},
     ThemeTargetStyles{L"Grid#ContentRoot > Border > Grid#ContentGrid > ContentControl#HeaderContent", {
@@ -683,7 +685,7 @@ const Theme g_themeStoreFrame11 = {{
     L"Accent@Light={ThemeResource SystemAccentColorDark1}",
 }};
 
-const Theme g_themeBlue = {{
+constexpr Theme g_themeBlue = {{
     ThemeTargetStyles{L"Frame#PermanentNavRootFrame", {
         L"Background=#03A5FC"}},
     ThemeTargetStyles{L"SystemSettings.View.EntityItem", {
@@ -714,7 +716,7 @@ const Theme g_themeBlue = {{
         L"Foreground=White"}},
 }};
 
-const Theme g_themeTranslucent_Settings11 = {{
+constexpr Theme g_themeTranslucent_Settings11 = {{
     ThemeTargetStyles{L"ContentPresenter#IconContentPresenter", {
         L"Foreground:=<SolidColorBrush Color=\"{ThemeResource SystemAccentColor}\" />"}},
     ThemeTargetStyles{L"SystemSettings.View.SettingsExpander > Grid > SystemSettings.View.ExpanderToggleButton#ContainerButton > ContentPresenter#ContentPresenter", {
@@ -1060,7 +1062,7 @@ const Theme g_themeTranslucent_Settings11 = {{
     L"ApplicationPageBackgroundThemeBrush@Light=#00000000",
 }};
 
-const Theme g_themeWindowGlass = {{
+constexpr Theme g_themeWindowGlass = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#ContentRoot > Windows.UI.Xaml.Controls.Border > Windows.UI.Xaml.Controls.Grid#ContentGrid", {
         L"Background:=$ElementBG",
         L"BorderBrush:=$ElementBorderBrush",
@@ -1202,7 +1204,7 @@ const Theme g_themeWindowGlass = {{
     L"Backdrop=<AcrylicBrush BackgroundSource=\"HostBackdrop\" TintColor=\"{ThemeResource SystemChromeAltHighColor}\" TintOpacity=\"0.3\" FallbackColor=\"{ThemeResource SystemChromeAltHighColor}\" />",
 }};
 
-const Theme g_themeOLED_variant_ModrinthGreen = {{
+constexpr Theme g_themeOLED_variant_ModrinthGreen = {{
     ThemeTargetStyles{L"ContentControl#GridViewItemContentControl > ContentPresenter > Grid", {
         L"Background=#101013"}},
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Primitives.ListViewItemPresenter > Border", {
@@ -1892,7 +1894,7 @@ const Theme g_themeOLED_variant_ModrinthGreen = {{
         L"Background=Transparent"}},
 }};
 
-const Theme g_themeOLED_variant_SystemAscent = {{
+constexpr Theme g_themeOLED_variant_SystemAscent = {{
     ThemeTargetStyles{L"ContentControl#GridViewItemContentControl > ContentPresenter > Grid", {
         L"Background=#101013"}},
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Primitives.ListViewItemPresenter > Border", {
@@ -3353,11 +3355,29 @@ struct CapturePropertyCustomizationState {
 };
 
 struct ElementCustomizationStateForVisualStateGroup {
-    std::unordered_map<DependencyProperty, ElementPropertyCustomizationState>
+    // A flat vector rather than a map, since an element rarely has more than a
+    // few customized properties. It's reserved for all of them before the first
+    // one is added and never grows afterwards, as the property changed
+    // callbacks hold references to the entries.
+    std::vector<
+        std::pair<DependencyProperty, ElementPropertyCustomizationState>>
         propertyCustomizationStates;
     winrt::event_token visualStateGroupCurrentStateChangedToken;
 };
 
+ElementPropertyCustomizationState* FindPropertyCustomizationState(
+    ElementCustomizationStateForVisualStateGroup& stateForVisualStateGroup,
+    DependencyProperty const& property) {
+    for (auto& [itemProperty, propertyCustomizationState] :
+         stateForVisualStateGroup.propertyCustomizationStates) {
+        if (itemProperty == property) {
+            return &propertyCustomizationState;
+        }
+    }
+
+    return nullptr;
+}
+
 struct ElementCustomizationState {
     winrt::weak_ref<FrameworkElement> element;
 
@@ -3379,10 +3399,11 @@ struct ElementCustomizationState {
     // changes.
     winrt::event_token captureSizeChangedToken;
 
-    // Use list to avoid reallocations on insertion, as pointers to items are
-    // captured in callbacks and stored.
-    std::list<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
-                        ElementCustomizationStateForVisualStateGroup>>
+    // Pointers to items are captured in callbacks and stored, so the vector is
+    // reserved for all of the element's visual state groups before the first
+    // one is added, and never grows afterwards.
+    std::vector<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
+                          ElementCustomizationStateForVisualStateGroup>>
         perVisualStateGroup;
 };
 
@@ -7597,12 +7618,12 @@ void PropagateStyleVariableChangeCore(
                 : consumer.fallbackClassName.c_str();
 
         for (auto& [vsgWeak, vsgState] : elementState.perVisualStateGroup) {
-            auto propIt =
-                vsgState.propertyCustomizationStates.find(consumer.property);
-            if (propIt == vsgState.propertyCustomizationStates.end()) {
+            auto* propStatePtr =
+                FindPropertyCustomizationState(vsgState, consumer.property);
+            if (!propStatePtr) {
                 continue;
             }
-            auto& propState = propIt->second;
+            auto& propState = *propStatePtr;
             if (!propState.dynamicTemplate) {
                 continue;
             }
@@ -7909,16 +7930,17 @@ void ApplyCustomizationsForVisualStateGroup(
     std::wstring currentVisualStateName(
         currentVisualState ? currentVisualState.Name() : L"");
 
-    for (const auto& [property, valuesPerVisualState] : propertyOverrides) {
-        const auto [propertyCustomizationStatesIt, inserted] =
-            elementCustomizationStateForVisualStateGroup
-                ->propertyCustomizationStates.insert({property, {}});
-        if (!inserted) {
-            continue;
-        }
+    // Property keys are unique, so each one gets a new entry. Reserved up front
+    // since the callbacks registered below hold references to the entries.
+    elementCustomizationStateForVisualStateGroup->propertyCustomizationStates
+        .reserve(propertyOverrides.size());
 
+    for (const auto& [property, valuesPerVisualState] : propertyOverrides) {
         auto& propertyCustomizationState =
-            propertyCustomizationStatesIt->second;
+            elementCustomizationStateForVisualStateGroup
+                ->propertyCustomizationStates
+                .emplace_back(property, ElementPropertyCustomizationState{})
+                .second;
 
         auto it = valuesPerVisualState.find(currentVisualStateName);
         if (it == valuesPerVisualState.end() &&
@@ -8015,10 +8037,6 @@ void ApplyCustomizationsForVisualStateGroup(
 
                     g_elementPropertyModifying = true;
 
-                    auto& propertyCustomizationStates =
-                        elementCustomizationStateForVisualStateGroup
-                            ->propertyCustomizationStates;
-
                     PCWSTR fallbackClassNamePtr =
                         fallbackClassNameStr.empty()
                             ? nullptr
@@ -8027,7 +8045,9 @@ void ApplyCustomizationsForVisualStateGroup(
                     for (const auto& [property, valuesPerVisualState] :
                          propertyOverrides) {
                         auto& propertyCustomizationState =
-                            propertyCustomizationStates.at(property);
+                            *FindPropertyCustomizationState(
+                                *elementCustomizationStateForVisualStateGroup,
+                                property);
 
                         auto newState = e.NewState();
                         auto newStateName =
@@ -8352,6 +8372,8 @@ void ApplyCustomizations(InstanceHandle handle,
 
     elementCustomizationState.element = element;
     elementCustomizationState.perVisualStateGroup.clear();
+    elementCustomizationState.perVisualStateGroup.reserve(
+        resolved.overridesPerVSG.size());
 
     // Elements that neither capture nor consume a variable pay nothing. The
     // rest get their spine now that the element has been matched; if it isn't
@@ -8609,7 +8631,7 @@ std::optional<StyleConstant> ParseStyleConstant(
 }
 
 StyleConstants LoadStyleConstants(
-    const std::vector<PCWSTR>& themeStyleConstants) {
+    std::initializer_list<PCWSTR> themeStyleConstants) {
     StyleConstants result;
 
     auto addToResult = [&result](StyleConstant sc) {
@@ -9219,7 +9241,7 @@ void RefreshThemeResourceEntries() {
 
 std::vector<ResourceVariableEntry> ProcessResourceVariablesFromSettings(
     const StyleConstants& styleConstants,
-    const std::vector<PCWSTR>& themeResourceVariables) {
+    std::initializer_list<PCWSTR> themeResourceVariables) {
     std::vector<ResourceVariableEntry> resourceVariables;
 
     for (const auto& themeResourceVariable : themeResourceVariables) {
@@ -9302,30 +9324,50 @@ void MergeResourceVariables() {
     }
 }
 
+// FNV-1a hash of a theme name, used to pick the selected theme with a single
+// switch instead of comparing against each theme name in turn.
+constexpr UINT64 ThemeNameHash(std::wstring_view name) {
+    UINT64 hash = 14695981039346656037ULL;
+    for (WCHAR c : name) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
 void ProcessAllStylesFromSettings() {
     PCWSTR themeName = Wh_GetStringSetting(L"theme");
     const Theme* theme = nullptr;
-    if (wcscmp(themeName, L"Densy") == 0) {
-        theme = &g_themeDensy;
-    } else if (wcscmp(themeName, L"ClassicSearchBar") == 0) {
-        theme = &g_themeClassicSearchBar;
-    } else if (wcscmp(themeName, L"StoreFrame11") == 0) {
-        theme = &g_themeStoreFrame11;
-    } else if (wcscmp(themeName, L"Blue") == 0) {
-        theme = &g_themeBlue;
-    } else if (wcscmp(themeName, L"Translucent_Settings11") == 0) {
-        theme = &g_themeTranslucent_Settings11;
-    } else if (wcscmp(themeName, L"WindowGlass") == 0) {
-        theme = &g_themeWindowGlass;
-    } else if (wcscmp(themeName, L"OLED_variant_ModrinthGreen") == 0) {
-        theme = &g_themeOLED_variant_ModrinthGreen;
-    } else if (wcscmp(themeName, L"OLED_variant_SystemAscent") == 0) {
-        theme = &g_themeOLED_variant_SystemAscent;
+    switch (ThemeNameHash(themeName)) {
+        case ThemeNameHash(L"Densy"):
+            theme = &g_themeDensy;
+            break;
+        case ThemeNameHash(L"ClassicSearchBar"):
+            theme = &g_themeClassicSearchBar;
+            break;
+        case ThemeNameHash(L"StoreFrame11"):
+            theme = &g_themeStoreFrame11;
+            break;
+        case ThemeNameHash(L"Blue"):
+            theme = &g_themeBlue;
+            break;
+        case ThemeNameHash(L"Translucent_Settings11"):
+            theme = &g_themeTranslucent_Settings11;
+            break;
+        case ThemeNameHash(L"WindowGlass"):
+            theme = &g_themeWindowGlass;
+            break;
+        case ThemeNameHash(L"OLED_variant_ModrinthGreen"):
+            theme = &g_themeOLED_variant_ModrinthGreen;
+            break;
+        case ThemeNameHash(L"OLED_variant_SystemAscent"):
+            theme = &g_themeOLED_variant_SystemAscent;
+            break;
     }
     Wh_FreeStringSetting(themeName);
 
     StyleConstants styleConstants = LoadStyleConstants(
-        theme ? theme->styleConstants : std::vector<PCWSTR>{});
+        theme ? theme->styleConstants : std::initializer_list<PCWSTR>{});
 
     if (theme) {
         for (const auto& themeTargetStyle : theme->targetStyles) {
@@ -9358,8 +9400,8 @@ void ProcessAllStylesFromSettings() {
     }
 
     g_resourceVariables = ProcessResourceVariablesFromSettings(
-        styleConstants,
-        theme ? theme->themeResourceVariables : std::vector<PCWSTR>{});
+        styleConstants, theme ? theme->themeResourceVariables
+                              : std::initializer_list<PCWSTR>{});
 }
 
 void UninitializeResourceVariables() {
@@ -2,7 +2,7 @@
 // @id              windows-11-start-menu-styler
 // @name            Windows 11 Start Menu Styler
 // @description     Customize the Start menu with themes contributed by others or create your own
-// @version         1.7
+// @version         1.7.2
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -509,9 +509,11 @@ from the **TranslucentTB** project.
 
 #include <winrt/Windows.UI.Xaml.h>
 
+// Themes are constant-initialized, with the lists backed by static read-only
+// arrays, so that loading the mod doesn't construct any of them.
 struct ThemeTargetStyles {
     PCWSTR target;
-    std::vector<PCWSTR> styles;
+    std::initializer_list<PCWSTR> styles;
 };
 
 enum class DisableNewStartMenuLayout {
@@ -523,17 +525,17 @@ enum class DisableNewStartMenuLayout {
 };
 
 struct Theme {
-    std::vector<ThemeTargetStyles> targetStyles;
-    std::vector<PCWSTR> styleConstants;
-    std::vector<PCWSTR> themeResourceVariables;
-    std::vector<ThemeTargetStyles> webViewTargetStyles;
+    std::initializer_list<ThemeTargetStyles> targetStyles;
+    std::initializer_list<PCWSTR> styleConstants;
+    std::initializer_list<PCWSTR> themeResourceVariables;
+    std::initializer_list<ThemeTargetStyles> webViewTargetStyles;
     DisableNewStartMenuLayout startMenuLayout =
         DisableNewStartMenuLayout::windowsDefault;
 };
 
 // clang-format off
 
-const Theme g_themeTranslucentStartMenu = {{
+constexpr Theme g_themeTranslucentStartMenu = {{
     ThemeTargetStyles{L"Border#AcrylicBorder", {
         L"Background:=$CommonBgBrush",
         L"BorderThickness=0",
@@ -632,7 +634,7 @@ const Theme g_themeTranslucentStartMenu = {{
     L"CommonBgBrush=<WindhawkBlur BlurAmount=\"25\" TintColor=\"#25323232\"/>",
 }};
 
-const Theme g_themeTranslucentStartMenu_variant_ClassicStartMenu = {{
+constexpr Theme g_themeTranslucentStartMenu_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Border#AcrylicBorder", {
         L"Background:=$CommonBgBrush",
         L"BorderThickness=0",
@@ -731,7 +733,7 @@ const Theme g_themeTranslucentStartMenu_variant_ClassicStartMenu = {{
     L"CommonBgBrush=<WindhawkBlur BlurAmount=\"25\" TintColor=\"#25323232\"/>",
 }};
 
-const Theme g_themeNoRecommendedSection = {{
+constexpr Theme g_themeNoRecommendedSection = {{
     ThemeTargetStyles{L"Grid#TopLevelSuggestionsListHeader", {
         L"Height=0",
         L"Visibility=>showMoreSuggestionsVisible"}},
@@ -748,7 +750,7 @@ const Theme g_themeNoRecommendedSection = {{
         L"RenderTransform:=<TranslateTransform X=\"{{(1-showMoreSuggestionsVisible)*-135}}\"/>"}},
 }};
 
-const Theme g_themeNoRecommendedSection_variant_ClassicStartMenu = {{
+constexpr Theme g_themeNoRecommendedSection_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#TopLevelSuggestionsListHeader", {
         L"Visibility=Collapsed"}},
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#NoTopLevelSuggestionsText", {
@@ -763,7 +765,7 @@ const Theme g_themeNoRecommendedSection_variant_ClassicStartMenu = {{
         L"Height=504"}},
 }};
 
-const Theme g_themeSideBySide = {{
+constexpr Theme g_themeSideBySide = {{
     ThemeTargetStyles{L"Grid#SideBySidePinnedWrapper", {
         L"ColumnDefinitions:=<ColumnDefinitionCollection><ColumnDefinition Width=\"540*\"/><ColumnDefinition Width=\"292*\"/></ColumnDefinitionCollection>"}},
     ThemeTargetStyles{L"Grid#SideBySidePinnedWrapper > ScrollViewer > Border#Root > Grid > ScrollContentPresenter > ItemsPresenter > ItemsWrapGrid", {
@@ -776,7 +778,7 @@ const Theme g_themeSideBySide = {{
         L"Margin=28,0,0,0"}},
 }, {}, {}, {}, DisableNewStartMenuLayout::newLayoutSideBySide};
 
-const Theme g_themeSideBySide_variant_ClassicStartMenu = {{
+constexpr Theme g_themeSideBySide_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Grid#UndockedRoot", {
         L"MaxWidth=700",
         L"Margin=0,0,300,0"}},
@@ -839,7 +841,7 @@ const Theme g_themeSideBySide_variant_ClassicStartMenu = {{
         L"Background:=<AcrylicBrush TintColor=\"{ThemeResource CardStrokeColorDefaultSolid}\" FallbackColor=\"{ThemeResource CardStrokeColorDefaultSolid}\" TintOpacity=\"0.1\" TintLuminosityOpacity=\"1\" Opacity=\"1\"/>"}},
 }};
 
-const Theme g_themeSideBySide2 = {{
+constexpr Theme g_themeSideBySide2 = {{
     ThemeTargetStyles{L"Grid#SideBySidePinnedWrapper", {
         L"ColumnDefinitions:=<ColumnDefinitionCollection><ColumnDefinition Width=\"292*\"/><ColumnDefinition Width=\"540*\"/></ColumnDefinitionCollection>"}},
     ThemeTargetStyles{L"GridView#AllAppsGrid > Border > Grid#SideBySidePinnedWrapper > ScrollViewer#ScrollViewer", {
@@ -864,7 +866,7 @@ const Theme g_themeSideBySide2 = {{
         L"FlowDirection=0"}},
 }, {}, {}, {}, DisableNewStartMenuLayout::newLayoutSideBySide};
 
-const Theme g_themeSideBySide2_variant_ClassicStartMenu = {{
+constexpr Theme g_themeSideBySide2_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#UndockedRoot", {
         L"Visibility=Visible",
         L"Width=510",
@@ -971,7 +973,7 @@ const Theme g_themeSideBySide2_variant_ClassicStartMenu = {{
         L"Margin=-245,-12,0,0"}},
 }};
 
-const Theme g_themeSideBySideMinimal = {{
+constexpr Theme g_themeSideBySideMinimal = {{
     ThemeTargetStyles{L"Grid#MainMenu", {
         L"Width=600"}},
     ThemeTargetStyles{L"Grid#FrameRoot", {
@@ -1006,7 +1008,7 @@ const Theme g_themeSideBySideMinimal = {{
         L"Visibility=Collapsed"}},
 }, {}, {}, {}, DisableNewStartMenuLayout::newLayoutSideBySide};
 
-const Theme g_themeSideBySideMinimal_variant_ClassicStartMenu = {{
+constexpr Theme g_themeSideBySideMinimal_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#UndockedRoot", {
         L"Visibility=Visible",
         L"Width=348",
@@ -1052,7 +1054,7 @@ const Theme g_themeSideBySideMinimal_variant_ClassicStartMenu = {{
         L"Margin=38,0,-38,0"}},
 }};
 
-const Theme g_themeDown_Aero = {{
+constexpr Theme g_themeDown_Aero = {{
     ThemeTargetStyles{L"Grid#FrameRoot", {
         L"MaxHeight=520"}},
     ThemeTargetStyles{L"TextBlock#ZoomedOutHeading", {
@@ -1177,7 +1179,7 @@ const Theme g_themeDown_Aero = {{
         L"Canvas.ZIndex=1"}},
 }};
 
-const Theme g_themeDown_Aero_variant_ClassicStartMenu = {{
+constexpr Theme g_themeDown_Aero_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"StartDocked.StartSizingFrame", {
         L"MaxHeight=520"}},
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#TopLevelSuggestionsListHeader", {
@@ -1263,7 +1265,7 @@ const Theme g_themeDown_Aero_variant_ClassicStartMenu = {{
         L"MaxHeight=350"}},
 }};
 
-const Theme g_themeWindows10 = {{
+constexpr Theme g_themeWindows10 = {{
     ThemeTargetStyles{L"Grid#FrameRoot", {
         L"Height=720",
         L"Margin=-16,0,0,-14"}},
@@ -1536,7 +1538,7 @@ const Theme g_themeWindows10 = {{
         L"Height=29"}},
 }, {}, {}, {}, DisableNewStartMenuLayout::newLayoutSideBySide};
 
-const Theme g_themeWindows10_variant_ClassicStartMenu = {{
+constexpr Theme g_themeWindows10_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Grid", {
         L"RequestedTheme=2"}},
     ThemeTargetStyles{L"Grid#RootContent", {
@@ -1731,7 +1733,7 @@ const Theme g_themeWindows10_variant_ClassicStartMenu = {{
         L"BorderBrush:=<RevealBorderBrush Color=\"Transparent\" TargetTheme=\"1\" Opacity=\"1\"/>"}},
 }};
 
-const Theme g_themeWindows10_variant_Minimal = {{
+constexpr Theme g_themeWindows10_variant_Minimal = {{
     ThemeTargetStyles{L"Grid", {
         L"RequestedTheme=2"}},
     ThemeTargetStyles{L"Grid#FrameRoot", {
@@ -1985,7 +1987,7 @@ const Theme g_themeWindows10_variant_Minimal = {{
         L"Visibility=Collapsed"}},
 }};
 
-const Theme g_themeWindows10_variant_Minimal_ClassicStartMenu = {{
+constexpr Theme g_themeWindows10_variant_Minimal_ClassicStartMenu = {{
     ThemeTargetStyles{L"Grid", {
         L"RequestedTheme=2"}},
     ThemeTargetStyles{L"Grid#RootContent", {
@@ -2176,7 +2178,7 @@ const Theme g_themeWindows10_variant_Minimal_ClassicStartMenu = {{
         L"MaxWidth=150"}},
 }};
 
-const Theme g_themeWindows11_Metro10 = {{
+constexpr Theme g_themeWindows11_Metro10 = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Frame", {
         L"Margin=0,-64,0,0"}},
     ThemeTargetStyles{L"Grid#FrameRoot", {
@@ -2333,7 +2335,7 @@ const Theme g_themeWindows11_Metro10 = {{
         L"RenderTransform:=<TranslateTransform X=\"20\" Y=\"-24\" />"}},
 }, {}, {}, {}, DisableNewStartMenuLayout::newLayoutSideBySide};
 
-const Theme g_themeWindows11_Metro10_variant_ClassicStartMenu = {{
+constexpr Theme g_themeWindows11_Metro10_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#UndockedRoot", {
         L"Visibility=Visible",
         L"MaxWidth=600",
@@ -2441,7 +2443,7 @@ const Theme g_themeWindows11_Metro10_variant_ClassicStartMenu = {{
         L"Margin=-20,0,20,0"}},
 }};
 
-const Theme g_themeFluent2Inspired = {{
+constexpr Theme g_themeFluent2Inspired = {{
     ThemeTargetStyles{L"Grid#ShowMoreSuggestions", {
         L"Visibility=1"}},
     ThemeTargetStyles{L"Grid#SuggestionsParentContainer", {
@@ -2641,7 +2643,7 @@ const Theme g_themeFluent2Inspired = {{
         L"Margin=-80,0,80,0"}},
 }};
 
-const Theme g_themeFluent2Inspired_variant_ClassicStartMenu = {{
+constexpr Theme g_themeFluent2Inspired_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Button#CloseAllAppsButton", {
         L"CornerRadius=14",
         L"Margin=0,0,-32,0",
@@ -2846,7 +2848,7 @@ const Theme g_themeFluent2Inspired_variant_ClassicStartMenu = {{
         L"Height=84"}},
 }};
 
-const Theme g_themeRosePine = {{
+constexpr Theme g_themeRosePine = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#ShowMoreSuggestions", {
         L"Visibility=Collapsed"}},
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#TopLevelSuggestionsListHeader", {
@@ -2944,7 +2946,7 @@ const Theme g_themeRosePine = {{
         L"CornerRadius=25"}},
 }};
 
-const Theme g_themeRosePine_variant_ClassicStartMenu = {{
+constexpr Theme g_themeRosePine_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#UndockedRoot", {
         L"Width=350",
         L"Margin=0,-40,0,0"}},
@@ -3056,7 +3058,7 @@ const Theme g_themeRosePine_variant_ClassicStartMenu = {{
         L"Margin=-50,0,-50,0"}},
 }};
 
-const Theme g_themeWindows11_Metro10Minimal = {{
+constexpr Theme g_themeWindows11_Metro10Minimal = {{
     ThemeTargetStyles{L"Grid#MainMenu", {
         L"Visibility=Visible",
         L"Width=420",
@@ -3125,7 +3127,7 @@ const Theme g_themeWindows11_Metro10Minimal = {{
         L"Canvas.ZIndex=1"}},
 }};
 
-const Theme g_themeWindows11_Metro10Minimal_variant_ClassicStartMenu = {{
+constexpr Theme g_themeWindows11_Metro10Minimal_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#UndockedRoot", {
         L"MaxWidth=0",
         L"Margin=0"}},
@@ -3179,7 +3181,7 @@ const Theme g_themeWindows11_Metro10Minimal_variant_ClassicStartMenu = {{
         L"Visibility=1"}},
 }};
 
-const Theme g_themeEverblush = {{
+constexpr Theme g_themeEverblush = {{
     ThemeTargetStyles{L"Border#AcrylicBorder", {
         L"Background=#141b1e",
         L"BorderBrush=#268ccf7e"}},
@@ -3250,7 +3252,7 @@ const Theme g_themeEverblush = {{
         L"Background=#d28ccf7e"}},
 }};
 
-const Theme g_themeEverblush_variant_ClassicStartMenu = {{
+constexpr Theme g_themeEverblush_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Border#AcrylicBorder", {
         L"Background=#141b1e",
         L"BorderBrush=#268ccf7e"}},
@@ -3318,7 +3320,7 @@ const Theme g_themeEverblush_variant_ClassicStartMenu = {{
         L"Foreground=#232a2d"}},
 }};
 
-const Theme g_themeSunValley = {{
+constexpr Theme g_themeSunValley = {{
     ThemeTargetStyles{L"Cortana.UI.Views.TaskbarSearchPage", {
         L"Margin=-2,0,0,0"}},
     ThemeTargetStyles{L"Border#TaskbarMargin", {
@@ -3510,7 +3512,7 @@ const Theme g_themeSunValley = {{
         L"Opacity=0.5"}},
 }};
 
-const Theme g_theme21996 = {{
+constexpr Theme g_theme21996 = {{
     ThemeTargetStyles{L"Border#TaskbarSearchBackground", {
         L"CornerRadius=4",
         L"BorderThickness=0,0,0,0",
@@ -3612,7 +3614,7 @@ const Theme g_theme21996 = {{
         L"TextAlignment=Left"}},
 }};
 
-const Theme g_theme21996_variant_ClassicStartMenu = {{
+constexpr Theme g_theme21996_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Border#TaskbarSearchBackground", {
         L"CornerRadius=4",
         L"BorderThickness=0,0,0,0",
@@ -3684,7 +3686,7 @@ const Theme g_theme21996_variant_ClassicStartMenu = {{
         L"Background:=<AcrylicBrush TintColor=\"{ThemeResource SystemChromeMediumColor}\" TintOpacity=\"0\" TintLuminosityOpacity=\"0.7\" FallbackColor=\"{ThemeResource SystemChromeLowColor}\" />"}},
 }};
 
-const Theme g_themeUniMenu = {{
+constexpr Theme g_themeUniMenu = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#NoTopLevelSuggestionsText", {
         L"Visibility=Collapsed"}},
     ThemeTargetStyles{L"Grid#MoreSuggestionsRoot > Grid", {
@@ -3855,7 +3857,7 @@ const Theme g_themeUniMenu = {{
         L"Visibility=Collapsed"}},
 }};
 
-const Theme g_themeUniMenu_variant_ClassicStartMenu = {{
+constexpr Theme g_themeUniMenu_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#NoTopLevelSuggestionsText", {
         L"Visibility=Collapsed"}},
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#TopLevelSuggestionsContainer", {
@@ -3959,7 +3961,7 @@ const Theme g_themeUniMenu_variant_ClassicStartMenu = {{
         L"Visibility=Collapsed"}},
 }};
 
-const Theme g_themeLegacyFluent = {{
+constexpr Theme g_themeLegacyFluent = {{
     ThemeTargetStyles{L"GridView#PinnedList > Border > ScrollViewer > Border > Grid > Windows.UI.Xaml.Controls.ScrollContentPresenter > ItemsPresenter > ItemsWrapGrid > Windows.UI.Xaml.Controls.GridViewItem > Windows.UI.Xaml.Controls.Border#ContentBorder@CommonStates > Windows.UI.Xaml.Controls.Grid#DroppedFlickerWorkaroundWrapper", {
         L"BorderBrush:=<RevealBorderBrush Color=\"{ThemeResource SystemListLowColor}\" TargetTheme=\"1\" Opacity=\"1\" />",
         L"BorderThickness=1.5",
@@ -4204,7 +4206,7 @@ const Theme g_themeLegacyFluent = {{
         L"font-family: Segoe MDL2 Assets !important"}},
 }};
 
-const Theme g_themeLegacyFluent_variant_ClassicStartMenu = {{
+constexpr Theme g_themeLegacyFluent_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.GridViewItem > Windows.UI.Xaml.Controls.Border#ContentBorder@CommonStates > Windows.UI.Xaml.Controls.Grid#DroppedFlickerWorkaroundWrapper > Windows.UI.Xaml.Controls.Border#BackgroundBorder", {
         L"BorderBrush:=<RevealBorderBrush Color=\"{ThemeResource SystemListLowColor}\" TargetTheme=\"1\" Opacity=\"1\" />",
         L"BorderThickness=2",
@@ -4404,7 +4406,7 @@ const Theme g_themeLegacyFluent_variant_ClassicStartMenu = {{
         L"font-family: Segoe MDL2 Assets !important"}},
 }};
 
-const Theme g_themeOnlySearch = {{
+constexpr Theme g_themeOnlySearch = {{
     ThemeTargetStyles{L"Grid#FrameRoot", {
         L"MaxHeight=160",
         L"MinHeight=100"}},
@@ -4416,7 +4418,7 @@ const Theme g_themeOnlySearch = {{
         L"Visibility=Collapsed"}},
 }};
 
-const Theme g_themeOnlySearch_variant_ClassicStartMenu = {{
+constexpr Theme g_themeOnlySearch_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"StartDocked.StartSizingFrame", {
         L"MinHeight=100",
         L"MaxHeight=160"}},
@@ -4424,7 +4426,7 @@ const Theme g_themeOnlySearch_variant_ClassicStartMenu = {{
         L"Visibility=Collapsed"}},
 }};
 
-const Theme g_themeOnlySearch_variant_Minimal = {{
+constexpr Theme g_themeOnlySearch_variant_Minimal = {{
     ThemeTargetStyles{L"Frame#StartFrame", {
         L"Visibility=Collapsed"}},
     ThemeTargetStyles{L"Grid#MainContent > Grid", {
@@ -4454,7 +4456,7 @@ const Theme g_themeOnlySearch_variant_Minimal = {{
         L"Margin=0,-2,0,2"}},
 }};
 
-const Theme g_themeWindowGlass = {{
+constexpr Theme g_themeWindowGlass = {{
     ThemeTargetStyles{L"StackPanel#TimeAndDatePanel", {
         L"VerticalAlignment=Top",
         L"HorizontalAlignment=Center",
@@ -4715,7 +4717,7 @@ const Theme g_themeWindowGlass = {{
     L"HoverCornerRadius=15",
 }};
 
-const Theme g_themeFluid = {{
+constexpr Theme g_themeFluid = {{
     ThemeTargetStyles{L"Border#ContentBorder@CommonStates > Grid > Border#BackgroundBorder", {
         L"BorderThickness=2",
         L"BorderBrush@PointerOver:=$borderColor",
@@ -4844,7 +4846,7 @@ const Theme g_themeFluid = {{
         L"transition: background-color 0.083s ease-in-out !important"}},
 }};
 
-const Theme g_themeOversimplified_Accentuated = {{
+constexpr Theme g_themeOversimplified_Accentuated = {{
     ThemeTargetStyles{L"MenuFlyoutPresenter", {
         L"Background:=$DarkAccent",
         L"BorderBrush=Transparent",
@@ -5033,7 +5035,7 @@ const Theme g_themeOversimplified_Accentuated = {{
         L"display: none !important"}},
 }};
 
-const Theme g_themeLiquidGlass2 = {{
+constexpr Theme g_themeLiquidGlass2 = {{
     ThemeTargetStyles{L"Border#AcrylicOverlay", {
         L"Visibility=1"}},
     ThemeTargetStyles{L"Border#AcrylicBorder", {
@@ -5535,7 +5537,7 @@ const Theme g_themeLiquidGlass2 = {{
         L"margin: 0px 10px 15px 5px !important"}},
 }};
 
-const Theme g_themeLiquidGlass = {{
+constexpr Theme g_themeLiquidGlass = {{
     ThemeTargetStyles{L"Border#AcrylicOverlay", {
         L"Visibility=1"}},
     ThemeTargetStyles{L"Border#AcrylicBorder", {
@@ -5703,7 +5705,7 @@ const Theme g_themeLiquidGlass = {{
         L"transition: background-color 0.083s ease-in-out !important"}},
 }, DisableNewStartMenuLayout::forceNewLayout};
 
-const Theme g_themeWindows10X = {{
+constexpr Theme g_themeWindows10X = {{
     ThemeTargetStyles{L"Grid#ShowMoreSuggestions", {
         L"Visibility=1"}},
     ThemeTargetStyles{L"Grid#TopLevelSuggestionsListHeader", {
@@ -5999,7 +6001,7 @@ const Theme g_themeWindows10X = {{
         L"margin-bottom: -2px !important"}},
 }};
 
-const Theme g_themeWindows10X_variant_ClassicStartMenu = {{
+constexpr Theme g_themeWindows10X_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Button#CloseAllAppsButton", {
         L"Margin=0,0,16,0",
         L"Padding=16,3,16,3.5",
@@ -6301,7 +6303,7 @@ const Theme g_themeWindows10X_variant_ClassicStartMenu = {{
         L"margin-bottom: -2px !important"}},
 }};
 
-const Theme g_themeTintedGlass = {{
+constexpr Theme g_themeTintedGlass = {{
     ThemeTargetStyles{L"Border#AcrylicBorder", {
         L"Background:=$CommonBgBrush",
         L"BorderThickness=0",
@@ -6400,7 +6402,7 @@ const Theme g_themeTintedGlass = {{
     L"CommonBgBrush=<WindhawkBlur BlurAmount=\"18\" TintColor=\"#80000000\"/>",
 }};
 
-const Theme g_themeTintedGlass_variant_ClassicStartMenu = {{
+constexpr Theme g_themeTintedGlass_variant_ClassicStartMenu = {{
     ThemeTargetStyles{L"Border#AcrylicBorder", {
         L"Background:=$CommonBgBrush",
         L"BorderThickness=0",
@@ -6497,7 +6499,7 @@ const Theme g_themeTintedGlass_variant_ClassicStartMenu = {{
     L"CommonBgBrush=<WindhawkBlur BlurAmount=\"18\" TintColor=\"#80000000\"/>",
 }};
 
-const Theme g_themeLayerMicaUI = {{
+constexpr Theme g_themeLayerMicaUI = {{
     ThemeTargetStyles{L"Border#AcrylicBorder", {
         L"CornerRadius=$OuterRadius",
         L"BorderThickness=1",
@@ -6814,7 +6816,7 @@ const Theme g_themeLayerMicaUI = {{
         L"margin-left: 0px !important"}},
 }};
 
-const Theme g_themeBorderless = {{
+constexpr Theme g_themeBorderless = {{
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#TopLevelSuggestionsListHeader", {
         L"Visibility=Collapsed"}},
     ThemeTargetStyles{L"Windows.UI.Xaml.Controls.Grid#NoTopLevelSuggestionsText", {
@@ -6906,7 +6908,7 @@ const Theme g_themeBorderless = {{
         L"BorderThickness=0"}},
 }};
 
-const Theme g_themeCommand_Center = {{
+constexpr Theme g_themeCommand_Center = {{
     ThemeTargetStyles{L"StackPanel#TimeAndDatePanel", {
         L"VerticalAlignment=Top",
         L"HorizontalAlignment=Center",
@@ -7222,7 +7224,7 @@ const Theme g_themeCommand_Center = {{
         L"transition: background-color 0.083s ease-in-out !important"}},
 }};
 
-const Theme g_themeFullScreen = {{
+constexpr Theme g_themeFullScreen = {{
     ThemeTargetStyles{L"StartMenu.StartBlendedFlexFrame", {
         L"ActualWidth=>frameWidth",
         L"ActualHeight=>frameHeight"}},
@@ -7239,7 +7241,7 @@ const Theme g_themeFullScreen = {{
         L"MaximumRowsOrColumns:="}},
 }};
 
-const Theme g_themeFullScreen_variant_1 = {{
+constexpr Theme g_themeFullScreen_variant_1 = {{
     ThemeTargetStyles{L":root > Canvas", {
         L"ActualWidth=>canvasWidth",
         L"ActualHeight=>canvasHeight"}},
@@ -7254,7 +7256,7 @@ const Theme g_themeFullScreen_variant_1 = {{
         L"CornerRadius=0"}},
 }};
 
-const Theme g_themeFrostyGlass = {{
+constexpr Theme g_themeFrostyGlass = {{
     ThemeTargetStyles{L"StartDocked.SearchBoxToggleButton", {
         L"Height=32",
         L"Margin=32,30,32,59",
@@ -8337,11 +8339,29 @@ struct CapturePropertyCustomizationState {
 };
 
 struct ElementCustomizationStateForVisualStateGroup {
-    std::unordered_map<DependencyProperty, ElementPropertyCustomizationState>
+    // A flat vector rather than a map, since an element rarely has more than a
+    // few customized properties. It's reserved for all of them before the first
+    // one is added and never grows afterwards, as the property changed
+    // callbacks hold references to the entries.
+    std::vector<
+        std::pair<DependencyProperty, ElementPropertyCustomizationState>>
         propertyCustomizationStates;
     winrt::event_token visualStateGroupCurrentStateChangedToken;
 };
 
+ElementPropertyCustomizationState* FindPropertyCustomizationState(
+    ElementCustomizationStateForVisualStateGroup& stateForVisualStateGroup,
+    DependencyProperty const& property) {
+    for (auto& [itemProperty, propertyCustomizationState] :
+         stateForVisualStateGroup.propertyCustomizationStates) {
+        if (itemProperty == property) {
+            return &propertyCustomizationState;
+        }
+    }
+
+    return nullptr;
+}
+
 struct ElementCustomizationState {
     winrt::weak_ref<FrameworkElement> element;
 
@@ -8363,10 +8383,11 @@ struct ElementCustomizationState {
     // changes.
     winrt::event_token captureSizeChangedToken;
 
-    // Use list to avoid reallocations on insertion, as pointers to items are
-    // captured in callbacks and stored.
-    std::list<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
-                        ElementCustomizationStateForVisualStateGroup>>
+    // Pointers to items are captured in callbacks and stored, so the vector is
+    // reserved for all of the element's visual state groups before the first
+    // one is added, and never grows afterwards.
+    std::vector<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
+                          ElementCustomizationStateForVisualStateGroup>>
         perVisualStateGroup;
 };
 
@@ -12874,12 +12895,12 @@ void PropagateStyleVariableChangeCore(
                 : consumer.fallbackClassName.c_str();
 
         for (auto& [vsgWeak, vsgState] : elementState.perVisualStateGroup) {
-            auto propIt =
-                vsgState.propertyCustomizationStates.find(consumer.property);
-            if (propIt == vsgState.propertyCustomizationStates.end()) {
+            auto* propStatePtr =
+                FindPropertyCustomizationState(vsgState, consumer.property);
+            if (!propStatePtr) {
                 continue;
             }
-            auto& propState = propIt->second;
+            auto& propState = *propStatePtr;
             if (!propState.dynamicTemplate) {
                 continue;
             }
@@ -13186,16 +13207,17 @@ void ApplyCustomizationsForVisualStateGroup(
     std::wstring currentVisualStateName(
         currentVisualState ? currentVisualState.Name() : L"");
 
-    for (const auto& [property, valuesPerVisualState] : propertyOverrides) {
-        const auto [propertyCustomizationStatesIt, inserted] =
-            elementCustomizationStateForVisualStateGroup
-                ->propertyCustomizationStates.insert({property, {}});
-        if (!inserted) {
-            continue;
-        }
+    // Property keys are unique, so each one gets a new entry. Reserved up front
+    // since the callbacks registered below hold references to the entries.
+    elementCustomizationStateForVisualStateGroup->propertyCustomizationStates
+        .reserve(propertyOverrides.size());
 
+    for (const auto& [property, valuesPerVisualState] : propertyOverrides) {
         auto& propertyCustomizationState =
-            propertyCustomizationStatesIt->second;
+            elementCustomizationStateForVisualStateGroup
+                ->propertyCustomizationStates
+                .emplace_back(property, ElementPropertyCustomizationState{})
+                .second;
 
         auto it = valuesPerVisualState.find(currentVisualStateName);
         if (it == valuesPerVisualState.end() &&
@@ -13292,10 +13314,6 @@ void ApplyCustomizationsForVisualStateGroup(
 
                     g_elementPropertyModifying = true;
 
-                    auto& propertyCustomizationStates =
-                        elementCustomizationStateForVisualStateGroup
-                            ->propertyCustomizationStates;
-
                     PCWSTR fallbackClassNamePtr =
                         fallbackClassNameStr.empty()
                             ? nullptr
@@ -13304,7 +13322,9 @@ void ApplyCustomizationsForVisualStateGroup(
                     for (const auto& [property, valuesPerVisualState] :
                          propertyOverrides) {
                         auto& propertyCustomizationState =
-                            propertyCustomizationStates.at(property);
+                            *FindPropertyCustomizationState(
+                                *elementCustomizationStateForVisualStateGroup,
+                                property);
 
                         auto newState = e.NewState();
                         auto newStateName =
@@ -14383,6 +14403,8 @@ void ApplyCustomizations(InstanceHandle handle,
 
     elementCustomizationState.element = element;
     elementCustomizationState.perVisualStateGroup.clear();
+    elementCustomizationState.perVisualStateGroup.reserve(
+        resolved.overridesPerVSG.size());
 
     // Elements that neither capture nor consume a variable pay nothing. The
     // rest get their spine now that the element has been matched; if it isn't
@@ -14574,7 +14596,7 @@ std::optional<StyleConstant> ParseStyleConstant(
 }
 
 StyleConstants LoadStyleConstants(
-    const std::vector<PCWSTR>& themeStyleConstants) {
+    std::initializer_list<PCWSTR> themeStyleConstants) {
     StyleConstants result;
 
     auto addToResult = [&result](StyleConstant sc) {
@@ -14994,7 +15016,7 @@ bool ProcessSingleTargetStylesFromSettings(
 
 void ProcessWebStylesFromSettings(
     const StyleConstants& styleConstants,
-    const std::vector<ThemeTargetStyles>& themeStyles) {
+    std::initializer_list<ThemeTargetStyles> themeStyles) {
     std::wstring webContentCss;
 
     for (const auto& themeStyle : themeStyles) {
@@ -15255,7 +15277,7 @@ void RefreshThemeResourceEntries() {
 
 std::vector<ResourceVariableEntry> ProcessResourceVariablesFromSettings(
     const StyleConstants& styleConstants,
-    const std::vector<PCWSTR>& themeResourceVariables) {
+    std::initializer_list<PCWSTR> themeResourceVariables) {
     std::vector<ResourceVariableEntry> resourceVariables;
 
     for (const auto& themeResourceVariable : themeResourceVariables) {
@@ -15338,110 +15360,158 @@ void MergeResourceVariables() {
     }
 }
 
+// FNV-1a hash of a theme name, used to pick the selected theme with a single
+// switch instead of comparing against each theme name in turn.
+constexpr UINT64 ThemeNameHash(std::wstring_view name) {
+    UINT64 hash = 14695981039346656037ULL;
+    for (WCHAR c : name) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
 const Theme* GetSelectedTheme(bool useNewLayoutVariant) {
     PCWSTR themeName = Wh_GetStringSetting(L"theme");
     const Theme* theme = nullptr;
-    if (wcscmp(themeName, L"TranslucentStartMenu") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeTranslucentStartMenu
-                    : &g_themeTranslucentStartMenu_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"NoRecommendedSection") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeNoRecommendedSection
-                    : &g_themeNoRecommendedSection_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"SideBySide") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeSideBySide
-                    : &g_themeSideBySide_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"SideBySide2") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeSideBySide2
-                    : &g_themeSideBySide2_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"SideBySideMinimal") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeSideBySideMinimal
-                    : &g_themeSideBySideMinimal_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"Down Aero") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeDown_Aero
-                    : &g_themeDown_Aero_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"Windows10") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeWindows10
-                    : &g_themeWindows10_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"Windows10_variant_Minimal") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeWindows10_variant_Minimal
-                    : &g_themeWindows10_variant_Minimal_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"Windows11_Metro10") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeWindows11_Metro10
-                    : &g_themeWindows11_Metro10_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"Fluent2Inspired") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeFluent2Inspired
-                    : &g_themeFluent2Inspired_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"RosePine") == 0) {
-        theme = useNewLayoutVariant ? &g_themeRosePine
-                                    : &g_themeRosePine_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"Windows11_Metro10Minimal") == 0) {
-        theme = useNewLayoutVariant
+    switch (ThemeNameHash(themeName)) {
+        case ThemeNameHash(L"TranslucentStartMenu"):
+            theme = useNewLayoutVariant
+                        ? &g_themeTranslucentStartMenu
+                        : &g_themeTranslucentStartMenu_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"NoRecommendedSection"):
+            theme = useNewLayoutVariant
+                        ? &g_themeNoRecommendedSection
+                        : &g_themeNoRecommendedSection_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"SideBySide"):
+            theme = useNewLayoutVariant
+                        ? &g_themeSideBySide
+                        : &g_themeSideBySide_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"SideBySide2"):
+            theme = useNewLayoutVariant
+                        ? &g_themeSideBySide2
+                        : &g_themeSideBySide2_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"SideBySideMinimal"):
+            theme = useNewLayoutVariant
+                        ? &g_themeSideBySideMinimal
+                        : &g_themeSideBySideMinimal_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"Down Aero"):
+            theme = useNewLayoutVariant
+                        ? &g_themeDown_Aero
+                        : &g_themeDown_Aero_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"Windows10"):
+            theme = useNewLayoutVariant
+                        ? &g_themeWindows10
+                        : &g_themeWindows10_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"Windows10_variant_Minimal"):
+            theme = useNewLayoutVariant
+                        ? &g_themeWindows10_variant_Minimal
+                        : &g_themeWindows10_variant_Minimal_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"Windows11_Metro10"):
+            theme = useNewLayoutVariant
+                        ? &g_themeWindows11_Metro10
+                        : &g_themeWindows11_Metro10_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"Fluent2Inspired"):
+            theme = useNewLayoutVariant
+                        ? &g_themeFluent2Inspired
+                        : &g_themeFluent2Inspired_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"RosePine"):
+            theme = useNewLayoutVariant
+                        ? &g_themeRosePine
+                        : &g_themeRosePine_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"Windows11_Metro10Minimal"):
+            theme =
+                useNewLayoutVariant
                     ? &g_themeWindows11_Metro10Minimal
                     : &g_themeWindows11_Metro10Minimal_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"Everblush") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeEverblush
-                    : &g_themeEverblush_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"SunValley") == 0) {
-        theme = &g_themeSunValley;
-    } else if (wcscmp(themeName, L"21996") == 0) {
-        theme = useNewLayoutVariant ? &g_theme21996
-                                    : &g_theme21996_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"UniMenu") == 0) {
-        theme = useNewLayoutVariant ? &g_themeUniMenu
-                                    : &g_themeUniMenu_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"LegacyFluent") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeLegacyFluent
-                    : &g_themeLegacyFluent_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"OnlySearch") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeOnlySearch
-                    : &g_themeOnlySearch_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"OnlySearch_variant_Minimal") == 0) {
-        theme = &g_themeOnlySearch_variant_Minimal;
-    } else if (wcscmp(themeName, L"WindowGlass") == 0) {
-        theme = &g_themeWindowGlass;
-    } else if (wcscmp(themeName, L"WindowGlass_variant_Minimal") == 0) {
-        // Same as WindowGlass, kept for backward compatibility.
-        theme = &g_themeWindowGlass;
-    } else if (wcscmp(themeName, L"Fluid") == 0) {
-        theme = &g_themeFluid;
-    } else if (wcscmp(themeName, L"Oversimplified&Accentuated") == 0) {
-        theme = &g_themeOversimplified_Accentuated;
-    } else if (wcscmp(themeName, L"LiquidGlass2") == 0) {
-        theme = &g_themeLiquidGlass2;
-    } else if (wcscmp(themeName, L"LiquidGlass") == 0) {
-        theme = &g_themeLiquidGlass;
-    } else if (wcscmp(themeName, L"Windows10X") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeWindows10X
-                    : &g_themeWindows10X_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"TintedGlass") == 0) {
-        theme = useNewLayoutVariant
-                    ? &g_themeTintedGlass
-                    : &g_themeTintedGlass_variant_ClassicStartMenu;
-    } else if (wcscmp(themeName, L"LayerMicaUI") == 0) {
-        theme = &g_themeLayerMicaUI;
-    } else if (wcscmp(themeName, L"Borderless") == 0) {
-        theme = &g_themeBorderless;
-    } else if (wcscmp(themeName, L"Command Center") == 0) {
-        theme = &g_themeCommand_Center;
-    } else if (wcscmp(themeName, L"FullScreen") == 0) {
-        theme = useNewLayoutVariant ? &g_themeFullScreen
-                                    : &g_themeFullScreen_variant_1;
-    } else if (wcscmp(themeName, L"FrostyGlass") == 0) {
-        theme = &g_themeFrostyGlass;
+            break;
+        case ThemeNameHash(L"Everblush"):
+            theme = useNewLayoutVariant
+                        ? &g_themeEverblush
+                        : &g_themeEverblush_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"SunValley"):
+            theme = &g_themeSunValley;
+            break;
+        case ThemeNameHash(L"21996"):
+            theme = useNewLayoutVariant
+                        ? &g_theme21996
+                        : &g_theme21996_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"UniMenu"):
+            theme = useNewLayoutVariant
+                        ? &g_themeUniMenu
+                        : &g_themeUniMenu_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"LegacyFluent"):
+            theme = useNewLayoutVariant
+                        ? &g_themeLegacyFluent
+                        : &g_themeLegacyFluent_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"OnlySearch"):
+            theme = useNewLayoutVariant
+                        ? &g_themeOnlySearch
+                        : &g_themeOnlySearch_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"OnlySearch_variant_Minimal"):
+            theme = &g_themeOnlySearch_variant_Minimal;
+            break;
+        case ThemeNameHash(L"WindowGlass"):
+            theme = &g_themeWindowGlass;
+            break;
+        case ThemeNameHash(L"WindowGlass_variant_Minimal"):
+            // Same as WindowGlass, kept for backward compatibility.
+            theme = &g_themeWindowGlass;
+            break;
+        case ThemeNameHash(L"Fluid"):
+            theme = &g_themeFluid;
+            break;
+        case ThemeNameHash(L"Oversimplified&Accentuated"):
+            theme = &g_themeOversimplified_Accentuated;
+            break;
+        case ThemeNameHash(L"LiquidGlass2"):
+            theme = &g_themeLiquidGlass2;
+            break;
+        case ThemeNameHash(L"LiquidGlass"):
+            theme = &g_themeLiquidGlass;
+            break;
+        case ThemeNameHash(L"Windows10X"):
+            theme = useNewLayoutVariant
+                        ? &g_themeWindows10X
+                        : &g_themeWindows10X_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"TintedGlass"):
+            theme = useNewLayoutVariant
+                        ? &g_themeTintedGlass
+                        : &g_themeTintedGlass_variant_ClassicStartMenu;
+            break;
+        case ThemeNameHash(L"LayerMicaUI"):
+            theme = &g_themeLayerMicaUI;
+            break;
+        case ThemeNameHash(L"Borderless"):
+            theme = &g_themeBorderless;
+            break;
+        case ThemeNameHash(L"Command Center"):
+            theme = &g_themeCommand_Center;
+            break;
+        case ThemeNameHash(L"FullScreen"):
+            theme = useNewLayoutVariant ? &g_themeFullScreen
+                                        : &g_themeFullScreen_variant_1;
+            break;
+        case ThemeNameHash(L"FrostyGlass"):
+            theme = &g_themeFrostyGlass;
+            break;
     }
     Wh_FreeStringSetting(themeName);
     return theme;
@@ -15451,7 +15521,7 @@ void ProcessAllStylesFromSettings() {
     const Theme* theme = GetSelectedTheme(g_isRedesignedStartMenu);
 
     StyleConstants styleConstants = LoadStyleConstants(
-        theme ? theme->styleConstants : std::vector<PCWSTR>{});
+        theme ? theme->styleConstants : std::initializer_list<PCWSTR>{});
 
     if (theme) {
         for (const auto& themeTargetStyle : theme->targetStyles) {
@@ -15484,13 +15554,13 @@ void ProcessAllStylesFromSettings() {
     }
 
     g_resourceVariables = ProcessResourceVariablesFromSettings(
-        styleConstants,
-        theme ? theme->themeResourceVariables : std::vector<PCWSTR>{});
+        styleConstants, theme ? theme->themeResourceVariables
+                              : std::initializer_list<PCWSTR>{});
 
     if (g_target == Target::SearchHost) {
-        ProcessWebStylesFromSettings(styleConstants,
-                                     theme ? theme->webViewTargetStyles
-                                           : std::vector<ThemeTargetStyles>{});
+        ProcessWebStylesFromSettings(
+            styleConstants, theme ? theme->webViewTargetStyles
+                                  : std::initializer_list<ThemeTargetStyles>{});
     }
 }
 
@@ -2,7 +2,7 @@
 // @id              windows-11-taskbar-styler
 // @name            Windows 11 Taskbar Styler
 // @description     Customize the taskbar with themes contributed by others or create your own
-// @version         1.8
+// @version         1.8.5
 // @author          m417z
 // @github          https://github.com/m417z
 // @twitter         https://twitter.com/m417z
@@ -588,6 +588,12 @@ from the **TranslucentTB** project.
   - alert: Alert (prompt before blocking)
   - block: Block other consumers
   - allow: Allow other consumers
+- performanceTrace: false
+  $name: Performance trace
+  $description: >-
+    Measure the time spent on styling and write it to the mod log and to a
+    Chrome trace file in the temp folder when the settings are changed or the
+    mod is unloaded. Useful for troubleshooting slowness, has a small overhead.
 */
 // ==/WindhawkModSettings==
 
@@ -601,20 +607,22 @@ from the **TranslucentTB** project.
 
 #include <winrt/Windows.UI.Xaml.h>
 
+// Themes are constant-initialized, with the lists backed by static read-only
+// arrays, so that loading the mod doesn't construct any of them.
 struct ThemeTargetStyles {
     PCWSTR target;
-    std::vector<PCWSTR> styles;
+    std::initializer_list<PCWSTR> styles;
 };
 
 struct Theme {
-    std::vector<ThemeTargetStyles> targetStyles;
-    std::vector<PCWSTR> styleConstants;
-    std::vector<PCWSTR> themeResourceVariables;
+    std::initializer_list<ThemeTargetStyles> targetStyles;
+    std::initializer_list<PCWSTR> styleConstants;
+    std::initializer_list<PCWSTR> themeResourceVariables;
 };
 
 // clang-format off
 
-const Theme g_themeTranslucentTaskbar = {{
+constexpr Theme g_themeTranslucentTaskbar = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill:=$CommonBgBrush"}},
     ThemeTargetStyles{L"Taskbar.TaskbarBackground#HoverFlyoutBackgroundControl > Grid > Rectangle#BackgroundFill", {
@@ -643,7 +651,7 @@ const Theme g_themeTranslucentTaskbar = {{
     L"CommonBgBrush=<WindhawkBlur BlurAmount=\"18\" TintColor=\"#25323232\"/>",
 }};
 
-const Theme g_themeDockLike = {{
+constexpr Theme g_themeDockLike = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
         L"Width=Auto",
         L"HorizontalAlignment=Center",
@@ -686,14 +694,14 @@ const Theme g_themeDockLike = {{
         L"MinWidth=24"}},
 }};
 
-const Theme g_themeSimplyTransparent = {{
+constexpr Theme g_themeSimplyTransparent = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill=Transparent"}},
     ThemeTargetStyles{L"Rectangle#BackgroundStroke", {
         L"Fill=Transparent"}},
 }};
 
-const Theme g_themeSquircle = {{
+constexpr Theme g_themeSquircle = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill=Transparent"}},
     ThemeTargetStyles{L"Taskbar.TaskbarBackground#HoverFlyoutBackgroundControl > Grid > Rectangle#BackgroundFill", {
@@ -768,7 +776,7 @@ const Theme g_themeSquircle = {{
         L"Margin=1"}},
 }};
 
-const Theme g_themeSquircle_variant_WeatherOnTheRight = {{
+constexpr Theme g_themeSquircle_variant_WeatherOnTheRight = {{
     ThemeTargetStyles{L"Rectangle#BackgroundFill", {
         L"Fill=Transparent"}},
     ThemeTargetStyles{L"Taskbar.TaskListLabeledButtonPanel@RunningIndicatorStates > Border#BackgroundElement", {
@@ -855,7 +863,7 @@ const Theme g_themeSquircle_variant_WeatherOnTheRight = {{
         L"MinWidth=Auto"}},
 }};
 
-const Theme g_themeMatter = {{
+constexpr Theme g_themeMatter = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill := $transparent"}},
     ThemeTargetStyles{L"Rectangle#BackgroundStroke", {
@@ -981,7 +989,7 @@ const Theme g_themeMatter = {{
     L"active = <AcrylicBrush TintColor=\"{ThemeResource SystemAltLowColor}\" TintOpacity=\"1\" TintLuminosityOpacity=\"1\" FallbackColor=\"{ThemeResource CardStrokeColorDefaultSolid}\" />",
 }};
 
-const Theme g_themeWinXP = {{
+constexpr Theme g_themeWinXP = {{
     ThemeTargetStyles{L"Rectangle#BackgroundStroke", {
         L"Fill:=<LinearGradientBrush StartPoint=\"0.5,0\" EndPoint=\"0.5,1\"> <GradientStop Color=\"#3168d5\" Offset=\"0.0\" /> <GradientStop Color=\"#4993e6\" Offset=\"0.08\" /> <GradientStop Color=\"#245dd7\" Offset=\"0.18\" /> <GradientStop Color=\"#2561de\" Offset=\"0.9\" /> <GradientStop Color=\"#1941a5\" Offset=\"1.0\" /></LinearGradientBrush>",
         L"VerticalAlignment=Stretch",
@@ -1040,7 +1048,7 @@ const Theme g_themeWinXP = {{
         L"BorderBrush:=<LinearGradientBrush StartPoint=\"0,0\" EndPoint=\"1,1\"> <GradientStop Color=\"#000000\" Offset=\"0.0\" /><GradientStop Color=\"#FFFFFF\" Offset=\"1\" /></LinearGradientBrush>"}},
 }};
 
-const Theme g_themeWinXP_variant_Zune = {{
+constexpr Theme g_themeWinXP_variant_Zune = {{
     ThemeTargetStyles{L"Rectangle#BackgroundFill", {
         L"Fill:=<LinearGradientBrush StartPoint=\"0.5,0.5\" EndPoint=\"0.5,1\"> <GradientStop Color=\"#656565\" Offset=\"0.0\" /> <GradientStop Color=\"#363636\" Offset=\"0.1\" /> <GradientStop Color=\"#363636\" Offset=\"0.35\" /> <GradientStop Color=\"#363636\" Offset=\"0.8\" /> <GradientStop Color=\"#363636\" Offset=\"1.0\" /></LinearGradientBrush>",
         L"VerticalAlignment=Stretch",
@@ -1098,7 +1106,7 @@ const Theme g_themeWinXP_variant_Zune = {{
         L"Background:=<LinearGradientBrush StartPoint=\"0.5,0.5\" EndPoint=\"0.5,1\"> <GradientStop Color=\"#656565\" Offset=\"0.0\" /> <GradientStop Color=\"#363636\" Offset=\"0.1\" /> <GradientStop Color=\"#363636\" Offset=\"0.35\" /> <GradientStop Color=\"#363636\" Offset=\"0.8\" /> <GradientStop Color=\"#363636\" Offset=\"1.0\" /></LinearGradientBrush>"}},
 }};
 
-const Theme g_themeBubbles = {{
+constexpr Theme g_themeBubbles = {{
     ThemeTargetStyles{L"Rectangle#BackgroundFill", {
         L"Fill:=<SolidColorBrush x:Name=\"SystemChromeLow\" Color=\"{ThemeResource SystemChromeLowColor}\" />"}},
     ThemeTargetStyles{L"Taskbar.TaskListLabeledButtonPanel@RunningIndicatorStates > Border#BackgroundElement", {
@@ -1231,7 +1239,7 @@ const Theme g_themeBubbles = {{
         L"BorderBrush:=<SolidColorBrush x:Name=\"SearchBoxTextBlock\" Opacity=\"0.25\" Color=\"{ThemeResource SearchPillButtonForeground}\" />"}},
 }};
 
-const Theme g_themeRosePine = {{
+constexpr Theme g_themeRosePine = {{
     ThemeTargetStyles{L"Taskbar.TaskListButton", {
         L"CornerRadius=3"}},
     ThemeTargetStyles{L"SystemTray.TextIconContent > Grid#ContainerGrid > SystemTray.AdaptiveTextBlock#Base > TextBlock#InnerTextBlock", {
@@ -1294,7 +1302,7 @@ const Theme g_themeRosePine = {{
         L"Background=#302d47"}},
 }};
 
-const Theme g_themeWinVista = {{
+constexpr Theme g_themeWinVista = {{
     ThemeTargetStyles{L"Taskbar.ExperienceToggleButton", {
         L"CornerRadius=2"}},
     ThemeTargetStyles{L"Taskbar.SearchBoxButton", {
@@ -1351,7 +1359,7 @@ const Theme g_themeWinVista = {{
         L"CornerRadius=8"}},
 }};
 
-const Theme g_themeCleanSlate = {{
+constexpr Theme g_themeCleanSlate = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill:=<AcrylicBrush TintColor=\"{ThemeResource SystemAccentColorDark2}\" TintOpacity=\"0.4\" FallbackColor=\"{ThemeResource SystemAccentColorDark1}\" />"}},
     ThemeTargetStyles{L"Taskbar.TaskListButtonPanel@CommonStates > Border#BackgroundElement", {
@@ -1481,7 +1489,7 @@ const Theme g_themeCleanSlate = {{
         L"CornerRadius=8"}},
 }};
 
-const Theme g_themeLucent = {{
+constexpr Theme g_themeLucent = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill:=<LinearGradientBrush StartPoint=\"0,0\" EndPoint=\"0,1\"><GradientStop Color=\"#00000000\" Offset=\"0.3\" /><GradientStop Color=\"#AA000000\" Offset=\"0.9\" /></LinearGradientBrush>"}},
     ThemeTargetStyles{L"Taskbar.TaskbarBackground#HoverFlyoutBackgroundControl > Grid > Rectangle#BackgroundFill", {
@@ -1602,7 +1610,7 @@ const Theme g_themeLucent = {{
         L"Background@ActivePressed_SearchIcon=#EEEEEE"}},
 }};
 
-const Theme g_themeLucent_variant_Light = {{
+constexpr Theme g_themeLucent_variant_Light = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill:=<LinearGradientBrush StartPoint=\"0,0\" EndPoint=\"0,1\"><GradientStop Color=\"#00000000\" Offset=\"0.3\" /><GradientStop Color=\"#AA000000\" Offset=\"0.9\" /></LinearGradientBrush>"}},
     ThemeTargetStyles{L"Taskbar.TaskbarBackground#HoverFlyoutBackgroundControl > Grid > Rectangle#BackgroundFill", {
@@ -1720,7 +1728,7 @@ const Theme g_themeLucent_variant_Light = {{
         L"Background@ActivePointerOver_SearchIcon=#EBEBEB"}},
 }};
 
-const Theme g_themeSunValley = {{
+constexpr Theme g_themeSunValley = {{
     ThemeTargetStyles{L"Taskbar.SearchBoxButton#SearchBoxButton > Taskbar.TaskListButtonPanel#ExperienceToggleButtonRootPanel > Windows.UI.Xaml.Controls.Border#BackgroundElement", {
         L"CornerRadius=4",
         L"BorderThickness=0,1,0,0"}},
@@ -2135,7 +2143,7 @@ const Theme g_themeSunValley = {{
         L"Background@InactivePressed_SearchBoxCustomTheme:=<SolidColorBrush Color=\"White\" Opacity=\"0.7\" />"}},
 }};
 
-const Theme g_theme21996Taskbar = {{
+constexpr Theme g_theme21996Taskbar = {{
     ThemeTargetStyles{L"Taskbar.SearchBoxButton#SearchBoxButton > Taskbar.TaskListButtonPanel#ExperienceToggleButtonRootPanel > Windows.UI.Xaml.Controls.Border#BackgroundElement", {
         L"CornerRadius=4",
         L"BorderThickness=0"}},
@@ -2346,7 +2354,7 @@ const Theme g_theme21996Taskbar = {{
         L"BorderThickness=0,1,0,0"}},
 }};
 
-const Theme g_themeBottomDensy = {{
+constexpr Theme g_themeBottomDensy = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill=Transparent"}},
     ThemeTargetStyles{L"Rectangle#BackgroundStroke", {
@@ -2428,7 +2436,7 @@ const Theme g_themeBottomDensy = {{
     L"volume_bar_width_inner_110=90",
 }};
 
-const Theme g_themeBottomDensy_variant_NoInd = {{
+constexpr Theme g_themeBottomDensy_variant_NoInd = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill=Transparent"}},
     ThemeTargetStyles{L"Rectangle#BackgroundStroke", {
@@ -2518,7 +2526,7 @@ const Theme g_themeBottomDensy_variant_NoInd = {{
     L"volume_bar_width_inner_110=90",
 }};
 
-const Theme g_themeTaskbarXII = {{
+constexpr Theme g_themeTaskbarXII = {{
     ThemeTargetStyles{L"ScrollViewer > ScrollContentPresenter > Border > Grid", {
         L"Background:=<AcrylicBrush TintColor=\"{ThemeResource SystemListLowColor}\" TintOpacity=\"0.1\" FallbackColor=\"{ThemeResource SystemChromeHighColor}\" />"}},
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
@@ -2587,7 +2595,7 @@ const Theme g_themeTaskbarXII = {{
         L"Margin=0"}},
 }};
 
-const Theme g_themexdark = {{
+constexpr Theme g_themexdark = {{
     ThemeTargetStyles{L"Taskbar.TaskListButton", {
         L"CornerRadius=13",
         L"Padding=6,0,6,0",
@@ -2644,7 +2652,7 @@ const Theme g_themexdark = {{
         L"Foreground=#facc15"}},
 }};
 
-const Theme g_themeWindows7 = {{
+constexpr Theme g_themeWindows7 = {{
     ThemeTargetStyles{L"Taskbar.TaskListLabeledButtonPanel@CommonStates > Windows.UI.Xaml.Controls.Border#BackgroundElement", {
         L"Background@InactiveNormal:=<ImageBrush Stretch=\"Fill\" ImageSource=\"$taskbandInactiveNormal\" />",
         L"Background@InactivePointerOver:=<ImageBrush Stretch=\"Fill\" ImageSource=\"$taskbandInactivePointerOver\" />",
@@ -2904,7 +2912,7 @@ const Theme g_themeWindows7 = {{
     L"widgetsPressed=https://raw.githubusercontent.com/ramensoftware/windows-11-taskbar-styling-guide/refs/heads/main/Themes/Windows7/ThemeResources/widgetsPressed.png",
 }};
 
-const Theme g_themeAeris = {{
+constexpr Theme g_themeAeris = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid", {
         L"Background:=$taskbarBackground"}},
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid", {
@@ -3084,7 +3092,7 @@ const Theme g_themeAeris = {{
     L"pressed=<SolidColorBrush Color=\"{ThemeResource TextFillColorPrimary}\" Opacity=\"0.05\"/>",
 }};
 
-const Theme g_themePlasma = {{
+constexpr Theme g_themePlasma = {{
     ThemeTargetStyles{L"Taskbar.TaskListButton > Taskbar.TaskListLabeledButtonPanel", {
         L"Padding=0"}},
     ThemeTargetStyles{L"Taskbar.TaskListButton > Taskbar.TaskListLabeledButtonPanel@CommonStates > Windows.UI.Xaml.Controls.Border#BackgroundElement", {
@@ -3267,7 +3275,7 @@ const Theme g_themePlasma = {{
     L"Acrylic=<AcrylicBrush TintColor=\"#2a2e32\" TintOpacity=\"0.8\" FallbackColor=\"#2a2e32\" />",
 }};
 
-const Theme g_themeWindowGlass = {{
+constexpr Theme g_themeWindowGlass = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
         L"MaxWidth={{min($TaskbarFrameMaxWidth, containerGridWidth)}}",
         L"Width=Auto",
@@ -3457,7 +3465,7 @@ const Theme g_themeWindowGlass = {{
     L"TaskbarFrameMaxWidth=1895",
 }};
 
-const Theme g_themeWindowGlass_variant_Split = {{
+constexpr Theme g_themeWindowGlass_variant_Split = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
         L"Grid.Column=1",
         L"MaxWidth={{min($TaskbarFrameMaxWidth, containerGridWidth)}}",
@@ -3645,7 +3653,7 @@ const Theme g_themeWindowGlass_variant_Split = {{
     L"TaskbarFrameMaxWidth=1895",
 }};
 
-const Theme g_themeWindowGlass_variant_FullLength = {{
+constexpr Theme g_themeWindowGlass_variant_FullLength = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
         L"Width=Auto",
         L"MinWidth:=100"}},
@@ -3825,7 +3833,7 @@ const Theme g_themeWindowGlass_variant_FullLength = {{
     L"Height=70",
 }};
 
-const Theme g_themeSurface = {{
+constexpr Theme g_themeSurface = {{
     ThemeTargetStyles{L"Grid#RootGrid > Taskbar.TaskbarBackground > Grid", {
         L"CornerRadius=20",
         L"BorderThickness=1",
@@ -3874,7 +3882,7 @@ const Theme g_themeSurface = {{
     L"SystemItemBorder=<LinearGradientBrush StartPoint=\"0,0\" EndPoint=\"0.5,1\"><GradientStop Color=\"#00000000\" Offset=\"0\" /><GradientStop Color=\"#33000000\" Offset=\"1.5\" /></LinearGradientBrush>",
 }};
 
-const Theme g_themeOversimplified_Accentuated = {{
+constexpr Theme g_themeOversimplified_Accentuated = {{
     ThemeTargetStyles{L"MenuFlyoutPresenter", {
         L"Background:=$DarkAccent",
         L"BorderBrush=Transparent",
@@ -3973,7 +3981,7 @@ const Theme g_themeOversimplified_Accentuated = {{
     L"Reveal= <RevealBorderBrush Color=\"Transparent\" TargetTheme=\"1\" Opacity=\"1\" />",
 }};
 
-const Theme g_themeLuminosity_variant_Dock = {{
+constexpr Theme g_themeLuminosity_variant_Dock = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill:=$mbg"}},
     ThemeTargetStyles{L"Taskbar.TaskListButtonPanel#ExperienceToggleButtonRootPanel > Windows.UI.Xaml.Controls.Border#BackgroundElement", {
@@ -4213,7 +4221,7 @@ const Theme g_themeLuminosity_variant_Dock = {{
     L"nbtp=<SolidColorBrush Color=\"{ThemeResource ControlFillColorTertiary}\" />",
 }};
 
-const Theme g_themeLuminosity_variant_Classic = {{
+constexpr Theme g_themeLuminosity_variant_Classic = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill:=$mbg"}},
     ThemeTargetStyles{L"Taskbar.TaskListButtonPanel#ExperienceToggleButtonRootPanel > Windows.UI.Xaml.Controls.Border#BackgroundElement", {
@@ -4423,7 +4431,7 @@ const Theme g_themeLuminosity_variant_Classic = {{
     L"nbtp=<SolidColorBrush Color=\"{ThemeResource ControlFillColorTertiary}\" />",
 }};
 
-const Theme g_themeLuminosity_variant_Compact = {{
+constexpr Theme g_themeLuminosity_variant_Compact = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill:=$mbg"}},
     ThemeTargetStyles{L"Taskbar.AugmentedEntryPointButton#AugmentedEntryPointButton", {
@@ -4664,7 +4672,7 @@ const Theme g_themeLuminosity_variant_Compact = {{
     L"nbtp=<SolidColorBrush Color=\"{ThemeResource ControlFillColorTertiary}\" />",
 }};
 
-const Theme g_themeLayerMicaUI = {{
+constexpr Theme g_themeLayerMicaUI = {{
     ThemeTargetStyles{L"Border#BackgroundDimmingLayer", {
         L"Background:=$ThemeBlur"}},
     ThemeTargetStyles{L"Border#OverflowFlyoutBackgroundBorder", {
@@ -4905,7 +4913,7 @@ const Theme g_themeLayerMicaUI = {{
     L"Island@Dark=#10FFFFFF",
 }};
 
-const Theme g_themeFluid = {{
+constexpr Theme g_themeFluid = {{
     ThemeTargetStyles{L"Rectangle#BackgroundStroke", {
         L"Visibility=1"}},
     ThemeTargetStyles{L"Grid#OverflowRootGrid > Border", {
@@ -5002,7 +5010,7 @@ const Theme g_themeFluid = {{
     L"CornerRadius=4",
 }};
 
-const Theme g_themeTintedGlass = {{
+constexpr Theme g_themeTintedGlass = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Fill:=$CommonBgBrush"}},
     ThemeTargetStyles{L"Taskbar.TaskbarBackground#HoverFlyoutBackgroundControl > Grid > Rectangle#BackgroundFill", {
@@ -5059,7 +5067,7 @@ const Theme g_themeTintedGlass = {{
     L"CommonBgBrush=<WindhawkBlur BlurAmount=\"18\" TintColor=\"#80000000\"/>",
 }};
 
-const Theme g_themeTaskbarToStatusbar = {{
+constexpr Theme g_themeTaskbarToStatusbar = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Microsoft.UI.Xaml.Controls.ItemsRepeater#TaskbarFrameRepeater", {
         L"Width=Auto",
         L"HorizontalAlignment=Left"}},
@@ -5114,7 +5122,7 @@ const Theme g_themeTaskbarToStatusbar = {{
         L"Background=Black"}},
 }};
 
-const Theme g_themeUltraWideFriendly = {{
+constexpr Theme g_themeUltraWideFriendly = {{
     ThemeTargetStyles{L":root > ScrollViewer > ScrollContentPresenter > Border > Grid", {
         L"ColumnDefinitions:=<ColumnDefinitionCollection><ColumnDefinition Width=\"*\"/><ColumnDefinition Width=\"Auto\"/><ColumnDefinition Width=\"Auto\"/><ColumnDefinition Width=\"*\"/></ColumnDefinitionCollection>",
         L"HorizontalAlignment=Stretch",
@@ -5153,7 +5161,7 @@ const Theme g_themeUltraWideFriendly = {{
     L"TaskbarFrameMaxWidth=8000",
 }};
 
-const Theme g_themeLiquidGlass2 = {{
+constexpr Theme g_themeLiquidGlass2 = {{
     ThemeTargetStyles{L":root > ScrollViewer > ScrollContentPresenter > Border > Grid", {
         L"ColumnDefinitions:=<ColumnDefinitionCollection><ColumnDefinition Width=\"*\"/><ColumnDefinition Width=\"Auto\"/><ColumnDefinition Width=\"*\"/></ColumnDefinitionCollection>",
         L"ActualWidth=>containerGridWidth",
@@ -5526,7 +5534,7 @@ const Theme g_themeLiquidGlass2 = {{
         L"Visibility=1"}},
 }};
 
-const Theme g_themeLiquidGlass = {{
+constexpr Theme g_themeLiquidGlass = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid", {
         L"BorderThickness=$BorderThickness",
         L"BorderBrush:=$BorderBrush",
@@ -5699,7 +5707,7 @@ const Theme g_themeLiquidGlass = {{
     L"ElementCornerRadius=8",
 }};
 
-const Theme g_themeLiquidGlass_variant_Alternate = {{
+constexpr Theme g_themeLiquidGlass_variant_Alternate = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
         L"Width=Auto",
         L"MinWidth:=100",
@@ -5887,7 +5895,7 @@ const Theme g_themeLiquidGlass_variant_Alternate = {{
     L"ElementCornerRadius=8",
 }};
 
-const Theme g_themeBorderless = {{
+constexpr Theme g_themeBorderless = {{
     ThemeTargetStyles{L"ScrollViewer > ScrollContentPresenter > Border > Grid", {
         L"ColumnDefinitions:=<ColumnDefinitionCollection><ColumnDefinition Width=\"*\"/><ColumnDefinition Width=\"Auto\"/><ColumnDefinition Width=\"Auto\"/><ColumnDefinition Width=\"*\"/></ColumnDefinitionCollection>",
         L"HorizontalAlignment=Stretch"}},
@@ -5938,7 +5946,7 @@ const Theme g_themeBorderless = {{
     L"TaskbarFrameWidth=800",
 }};
 
-const Theme g_themeCommand_Center = {{
+constexpr Theme g_themeCommand_Center = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid > Taskbar.TaskbarBackground > Grid > Rectangle#BackgroundFill", {
         L"Visibility=1"}},
     ThemeTargetStyles{L"Rectangle#BackgroundStroke", {
@@ -6176,7 +6184,7 @@ const Theme g_themeCommand_Center = {{
     L"R2=20",
 }};
 
-const Theme g_themeFluentGlass = {{
+constexpr Theme g_themeFluentGlass = {{
     ThemeTargetStyles{L"ScrollViewer > ScrollContentPresenter > Border > Grid", {
         L"ColumnDefinitions:=<ColumnDefinitionCollection><ColumnDefinition Width=\"*\"/><ColumnDefinition Width=\"Auto\"/><ColumnDefinition Width=\"Auto\"/><ColumnDefinition Width=\"*\"/></ColumnDefinitionCollection>",
         L"HorizontalAlignment=Stretch"}},
@@ -6268,7 +6276,7 @@ const Theme g_themeFluentGlass = {{
     L"LiquidBorder=<LinearGradientBrush StartPoint=\"0,0\" EndPoint=\"0,1\"><GradientStop Color=\"#50808080\" Offset=\"0.0\" /><GradientStop Color=\"#50404040\" Offset=\"1\" /></LinearGradientBrush>",
 }};
 
-const Theme g_themeOS26_Liquid_Glass = {{
+constexpr Theme g_themeOS26_Liquid_Glass = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
         L"Width=auto",
         L"MinWidth:=100",
@@ -6645,7 +6653,7 @@ const Theme g_themeOS26_Liquid_Glass = {{
     L"IconBorder= <LinearGradientBrush EndPoint=\"1,1\" StartPoint=\"0,0\"><GradientStop Color=\"#F5ffffff\" Offset=\"0.0\"/><GradientStop Color=\"#40ffffff\" Offset=\"0.4\"/><GradientStop Color=\"#20ffffff\" Offset=\"0.6\"/><GradientStop Color=\"#90ffffff\" Offset=\"1.0\"/></LinearGradientBrush>",
 }};
 
-const Theme g_themeOS26_Liquid_Glass_variant_1 = {{
+constexpr Theme g_themeOS26_Liquid_Glass_variant_1 = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
         L"Height=80",
         L"MaxHeight=80",
@@ -6910,7 +6918,7 @@ const Theme g_themeOS26_Liquid_Glass_variant_1 = {{
     L"IconBorder= <LinearGradientBrush EndPoint=\"1,1\" StartPoint=\"0,0\"><GradientStop Color=\"#F5ffffff\" Offset=\"0.0\"/><GradientStop Color=\"#40ffffff\" Offset=\"0.4\"/><GradientStop Color=\"#20ffffff\" Offset=\"0.6\"/><GradientStop Color=\"#90ffffff\" Offset=\"1.0\"/></LinearGradientBrush>",
 }};
 
-const Theme g_themeOS26_Liquid_Glass_variant_2 = {{
+constexpr Theme g_themeOS26_Liquid_Glass_variant_2 = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
         L"Width=auto",
         L"MinWidth:=100",
@@ -7287,7 +7295,7 @@ const Theme g_themeOS26_Liquid_Glass_variant_2 = {{
     L"IconBorder=<LinearGradientBrush StartPoint=\"0.04,-0.14\" EndPoint=\"1.22,1.10\"><GradientStop Offset=\"0.18\" Color=\"#4FFFFFFF\"/><GradientStop Offset=\"0.34\" Color=\"#661D1D1D\"/><GradientStop Offset=\"0.63\" Color=\"#00000000\"/><GradientStop Offset=\"0.72\" Color=\"#662D2D2D\"/><GradientStop Offset=\"0.84\" Color=\"#4FFFFFFF\"/></LinearGradientBrush>",
 }};
 
-const Theme g_themeOS26_Liquid_Glass_variant_3 = {{
+constexpr Theme g_themeOS26_Liquid_Glass_variant_3 = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
         L"Height=80",
         L"MaxHeight=80",
@@ -7552,7 +7560,7 @@ const Theme g_themeOS26_Liquid_Glass_variant_3 = {{
     L"IconBorder=<LinearGradientBrush StartPoint=\"0.25,-0.20\" EndPoint=\"0.99,1.39\"><GradientStop Offset=\"0.11\" Color=\"#50FFFFFF\"/><GradientStop Offset=\"0.3\" Color=\"#631C1C1C\"/><GradientStop Offset=\"0.62\" Color=\"#591C1C1C\"/><GradientStop Offset=\"0.77\" Color=\"#50FFFFFF\"/></LinearGradientBrush>",
 }};
 
-const Theme g_themeFrostyGlass = {{
+constexpr Theme g_themeFrostyGlass = {{
     ThemeTargetStyles{L"Taskbar.TaskbarFrame > Grid#RootGrid", {
         L"Margin=0,0,0,4",
         L"BorderThickness=$BorderThickness",
@@ -7818,7 +7826,7 @@ const Theme g_themeFrostyGlass = {{
     L"BorderBrush3=Transparent",
 }};
 
-const Theme g_themeFrostedAcrylic = {{
+constexpr Theme g_themeFrostedAcrylic = {{
     ThemeTargetStyles{L":root > ScrollViewer > ScrollContentPresenter > Border > Grid", {
         L"ActualWidth=>containerGridWidth"}},
     ThemeTargetStyles{L"Taskbar.TaskbarFrame", {
@@ -8032,7 +8040,7 @@ const Theme g_themeFrostedAcrylic = {{
     L"TrayPadding=2,4,2,4",
 }};
 
-const Theme g_themePills = {{
+constexpr Theme g_themePills = {{
     ThemeTargetStyles{L"Taskbar.TaskListLabeledButtonPanel#IconPanel > Rectangle#RunningIndicator", {
         L"Grid.ColumnSpan => LabelsMod"}},
     ThemeTargetStyles{L"ScrollViewer > ScrollContentPresenter > Border > Grid > Taskbar.TaskbarFrame", {
@@ -8823,9 +8831,11 @@ HRESULT InjectWindhawkTAP() noexcept
 #include <windhawk_utils.h>
 
 #include <algorithm>
+#include <bit>
 #include <charconv>
 #include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <limits>
 #include <list>
 #include <memory>
@@ -8891,8 +8901,213 @@ enum class XamlDiagnosticsHandling {
 struct {
     bool clickThroughTaskbar;
     XamlDiagnosticsHandling xamlDiagnosticsHandling;
+    bool performanceTrace;
 } g_settings;
 
+// Optional performance trace, enabled with the performanceTrace setting. Each
+// UI thread keeps per-category counters, a duration histogram and a ring
+// buffer of the most recent timed scopes. The data is logged and written as a
+// Chrome trace file (chrome://tracing, ui.perfetto.dev) to the temp folder when
+// the thread is uninitialized, i.e. on settings change or mod unload. When
+// disabled, each instrumentation point costs a single thread-local null check.
+enum class TraceCategory {
+    kMatchElement,
+    kRuleHit,
+    kFindPropertyOverrides,
+    kParseXaml,
+    kSetPropertyValue,
+    kPropagateStyleVariable,
+    kImageLoadRetry,
+    kUpdateClickThroughRegion,
+    kApplyCustomizations,
+    kCount,
+};
+
+constexpr PCSTR kTraceCategoryNames[] = {
+    "MatchElement",
+    "RuleHit",
+    "FindPropertyOverrides",
+    "ParseXaml",
+    "SetPropertyValue",
+    "PropagateStyleVariable",
+    "ImageLoadRetry",
+    "UpdateClickThroughRegion",
+    "ApplyCustomizations",
+};
+static_assert(std::size(kTraceCategoryNames) ==
+              static_cast<size_t>(TraceCategory::kCount));
+
+// Power of two, so that the write index can be masked.
+constexpr size_t kTraceRingSize = 8192;
+
+// Bucket i holds durations of [2^(i-1), 2^i) microseconds, bucket 0 holds
+// durations below 1us, and the last bucket is open-ended.
+constexpr size_t kTraceHistogramBuckets = 16;
+
+struct TraceEvent {
+    LONGLONG start;
+    LONGLONG duration;
+    TraceCategory category;
+};
+
+struct TraceCategoryStats {
+    ULONGLONG count;
+    LONGLONG totalTicks;
+    LONGLONG maxTicks;
+    ULONGLONG histogram[kTraceHistogramBuckets];
+};
+
+struct ThreadTrace {
+    TraceCategoryStats stats[static_cast<size_t>(TraceCategory::kCount)] = {};
+    std::vector<TraceEvent> events = std::vector<TraceEvent>(kTraceRingSize);
+    size_t eventsWritten = 0;
+};
+
+LONGLONG g_traceTicksPerSecond;
+
+thread_local std::unique_ptr<ThreadTrace> g_traceForThread;
+
+void TraceCount(TraceCategory category) {
+    if (auto* trace = g_traceForThread.get()) {
+        trace->stats[static_cast<size_t>(category)].count++;
+    }
+}
+
+void TraceRecord(ThreadTrace& trace,
+                 TraceCategory category,
+                 LONGLONG start,
+                 LONGLONG end) {
+    LONGLONG duration = end - start;
+
+    auto& stats = trace.stats[static_cast<size_t>(category)];
+    stats.count++;
+    stats.totalTicks += duration;
+    stats.maxTicks = std::max(stats.maxTicks, duration);
+
+    ULONGLONG microseconds = duration * 1000000 / g_traceTicksPerSecond;
+    size_t bucket = std::min(static_cast<size_t>(std::bit_width(microseconds)),
+                             kTraceHistogramBuckets - 1);
+    stats.histogram[bucket]++;
+
+    trace.events[trace.eventsWritten++ & (kTraceRingSize - 1)] = {
+        start, duration, category};
+}
+
+class ScopedTrace {
+   public:
+    explicit ScopedTrace(TraceCategory category)
+        : m_trace(g_traceForThread.get()), m_category(category) {
+        if (m_trace) {
+            QueryPerformanceCounter(&m_start);
+        }
+    }
+
+    ~ScopedTrace() {
+        if (m_trace) {
+            LARGE_INTEGER end;
+            QueryPerformanceCounter(&end);
+            TraceRecord(*m_trace, m_category, m_start.QuadPart, end.QuadPart);
+        }
+    }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+   private:
+    ThreadTrace* m_trace;
+    TraceCategory m_category;
+    LARGE_INTEGER m_start;
+};
+
+void StartTraceForCurrentThread() {
+    if (!g_settings.performanceTrace || g_traceForThread) {
+        return;
+    }
+
+    if (!g_traceTicksPerSecond) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        g_traceTicksPerSecond = frequency.QuadPart;
+    }
+
+    g_traceForThread = std::make_unique<ThreadTrace>();
+}
+
+void FinishTraceForCurrentThread() {
+    auto trace = std::move(g_traceForThread);
+    if (!trace) {
+        return;
+    }
+
+    auto ticksToMs = [](LONGLONG ticks) {
+        return ticks * 1000.0 / g_traceTicksPerSecond;
+    };
+
+    for (size_t i = 0; i < static_cast<size_t>(TraceCategory::kCount); i++) {
+        const auto& stats = trace->stats[i];
+        if (!stats.count) {
+            continue;
+        }
+
+        std::wstring histogram;
+        for (size_t bucket = 0; bucket < kTraceHistogramBuckets; bucket++) {
+            if (stats.histogram[bucket]) {
+                histogram += L" <" + std::to_wstring(1ULL << bucket) +
+                             L"us:" + std::to_wstring(stats.histogram[bucket]);
+            }
+        }
+
+        Wh_Log(L"Trace %S: count=%llu total=%.3fms max=%.3fms%s",
+               kTraceCategoryNames[i], stats.count,
+               ticksToMs(stats.totalTicks), ticksToMs(stats.maxTicks),
+               histogram.c_str());
+    }
+
+    size_t eventCount = std::min(trace->eventsWritten, kTraceRingSize);
+    if (!eventCount) {
+        return;
+    }
+
+    WCHAR tempPath[MAX_PATH];
+    if (!GetTempPath(ARRAYSIZE(tempPath), tempPath)) {
+        Wh_Log(L"GetTempPath failed");
+        return;
+    }
+
+    DWORD processId = GetCurrentProcessId();
+    DWORD threadId = GetCurrentThreadId();
+
+    WCHAR tracePath[MAX_PATH];
+    swprintf_s(tracePath, L"%s%s-trace-%u-%u.json", tempPath, WH_MOD_ID,
+               processId, threadId);
+
+    FILE* file;
+    if (_wfopen_s(&file, tracePath, L"w") != 0) {
+        Wh_Log(L"Failed to create %s", tracePath);
+        return;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t i = trace->eventsWritten - eventCount;
+         i < trace->eventsWritten; i++) {
+        const auto& event = trace->events[i & (kTraceRingSize - 1)];
+        fprintf(file,
+                "{\"name\":\"%s\",\"cat\":\"styler\",\"ph\":\"X\","
+                "\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+                kTraceCategoryNames[static_cast<size_t>(event.category)],
+                processId, threadId, ticksToMs(event.start) * 1000.0,
+                ticksToMs(event.duration) * 1000.0);
+    }
+    fprintf(file,
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,"
+            "\"args\":{\"name\":\"XAML thread %u\"}}\n",
+            processId, threadId, threadId);
+    fprintf(file, "]}\n");
+    fclose(file);
+
+    Wh_Log(L"Wrote %zu trace events to %s", eventCount, tracePath);
+}
+
 // https://stackoverflow.com/a/51274008
 template <auto fn>
 struct deleter_from_fn {
@@ -9217,11 +9432,29 @@ struct CapturePropertyCustomizationState {
 };
 
 struct ElementCustomizationStateForVisualStateGroup {
-    std::unordered_map<DependencyProperty, ElementPropertyCustomizationState>
+    // A flat vector rather than a map, since an element rarely has more than a
+    // few customized properties. It's reserved for all of them before the first
+    // one is added and never grows afterwards, as the property changed
+    // callbacks hold references to the entries.
+    std::vector<
+        std::pair<DependencyProperty, ElementPropertyCustomizationState>>
         propertyCustomizationStates;
     winrt::event_token visualStateGroupCurrentStateChangedToken;
 };
 
+ElementPropertyCustomizationState* FindPropertyCustomizationState(
+    ElementCustomizationStateForVisualStateGroup& stateForVisualStateGroup,
+    DependencyProperty const& property) {
+    for (auto& [itemProperty, propertyCustomizationState] :
+         stateForVisualStateGroup.propertyCustomizationStates) {
+        if (itemProperty == property) {
+            return &propertyCustomizationState;
+        }
+    }
+
+    return nullptr;
+}
+
 struct ElementCustomizationState {
     winrt::weak_ref<FrameworkElement> element;
 
@@ -9250,10 +9483,11 @@ struct ElementCustomizationState {
     // changes.
     winrt::event_token captureSizeChangedToken;
 
-    // Use list to avoid reallocations on insertion, as pointers to items are
-    // captured in callbacks and stored.
-    std::list<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
-                        ElementCustomizationStateForVisualStateGroup>>
+    // Pointers to items are captured in callbacks and stored, so the vector is
+    // reserved for all of the element's visual state groups before the first
+    // one is added, and never grows afterwards.
+    std::vector<std::pair<std::optional<winrt::weak_ref<VisualStateGroup>>,
+                          ElementCustomizationStateForVisualStateGroup>>
         perVisualStateGroup;
 };
 
@@ -11221,6 +11455,8 @@ void RetryFailedImageLoadsOnCurrentThread() {
         return;
     }
 
+    ScopedTrace scopedTrace(TraceCategory::kImageLoadRetry);
+
     Wh_Log(L"Retrying failed image loads on current thread");
 
     auto& brushes = g_trackedImageBrushesForThread.brushes;
@@ -11598,6 +11834,8 @@ void SetOrClearValue(DependencyObject elementDo,
                      DependencyProperty property,
                      const PropertyOverrideValue& overrideValue,
                      bool initialApply = false) {
+    ScopedTrace scopedTrace(TraceCategory::kSetPropertyValue);
+
     winrt::Windows::Foundation::IInspectable value;
     if (auto* inspectable =
             std::get_if<winrt::Windows::Foundation::IInspectable>(
@@ -12074,6 +12312,8 @@ std::optional<PropertyOverrideValue> ParseNonXamlPropertyOverrideValue(
 
 Style GetStyleFromXamlSetters(const std::wstring_view type,
                               const std::wstring_view xamlStyleSetters) {
+    ScopedTrace scopedTrace(TraceCategory::kParseXaml);
+
     std::wstring xaml =
         LR"(<ResourceDictionary
     xmlns="http://schemas.microsoft.com/winfx/2006/xaml/presentation"
@@ -12537,6 +12777,8 @@ bool TestElementMatcher(FrameworkElement element,
                         ElementMatcher& matcher,
                         VisualStateGroup* visualStateGroup,
                         PCWSTR fallbackClassName) {
+    TraceCount(TraceCategory::kMatchElement);
+
     if (!matcher.type.empty() &&
         matcher.type != winrt::get_class_name(element) &&
         (!fallbackClassName || matcher.type != fallbackClassName)) {
@@ -12610,6 +12852,8 @@ struct ElementResolvedRules {
 
 ElementResolvedRules FindElementPropertyOverrides(FrameworkElement element,
                                                   PCWSTR fallbackClassName) {
+    ScopedTrace scopedTrace(TraceCategory::kFindPropertyOverrides);
+
     ElementResolvedRules result;
     std::unordered_set<DependencyProperty> propertiesAdded;
     std::unordered_set<std::wstring> capturesAdded;
@@ -12688,6 +12932,8 @@ ElementResolvedRules FindElementPropertyOverrides(FrameworkElement element,
             continue;
         }
 
+        TraceCount(TraceCategory::kRuleHit);
+
         const auto& resolvedRules = GetResolvedPropertyOverrides(
             override.elementMatcher.type,
             fallbackClassName ? fallbackClassName
@@ -13652,6 +13898,8 @@ void PropagateStyleVariableChangeCore(
     StyleVariableState* state,
     const std::wstring& varName,
     std::optional<InstanceHandle> changedOwner) {
+    ScopedTrace scopedTrace(TraceCategory::kPropagateStyleVariable);
+
     auto consumersIt = state->consumers.find(varName);
     if (consumersIt == state->consumers.end()) {
         return;
@@ -13701,12 +13949,12 @@ void PropagateStyleVariableChangeCore(
                 : consumer.fallbackClassName.c_str();
 
         for (auto& [vsgWeak, vsgState] : elementState.perVisualStateGroup) {
-            auto propIt =
-                vsgState.propertyCustomizationStates.find(consumer.property);
-            if (propIt == vsgState.propertyCustomizationStates.end()) {
+            auto* propStatePtr =
+                FindPropertyCustomizationState(vsgState, consumer.property);
+            if (!propStatePtr) {
                 continue;
             }
-            auto& propState = propIt->second;
+            auto& propState = *propStatePtr;
             if (!propState.dynamicTemplate) {
                 continue;
             }
@@ -14015,16 +14263,17 @@ void ApplyCustomizationsForVisualStateGroup(
     std::wstring currentVisualStateName(
         currentVisualState ? currentVisualState.Name() : L"");
 
-    for (const auto& [property, valuesPerVisualState] : propertyOverrides) {
-        const auto [propertyCustomizationStatesIt, inserted] =
-            elementCustomizationStateForVisualStateGroup
-                ->propertyCustomizationStates.insert({property, {}});
-        if (!inserted) {
-            continue;
-        }
+    // Property keys are unique, so each one gets a new entry. Reserved up front
+    // since the callbacks registered below hold references to the entries.
+    elementCustomizationStateForVisualStateGroup->propertyCustomizationStates
+        .reserve(propertyOverrides.size());
 
+    for (const auto& [property, valuesPerVisualState] : propertyOverrides) {
         auto& propertyCustomizationState =
-            propertyCustomizationStatesIt->second;
+            elementCustomizationStateForVisualStateGroup
+                ->propertyCustomizationStates
+                .emplace_back(property, ElementPropertyCustomizationState{})
+                .second;
 
         auto it = valuesPerVisualState.find(currentVisualStateName);
         if (it == valuesPerVisualState.end() &&
@@ -14121,10 +14370,6 @@ void ApplyCustomizationsForVisualStateGroup(
 
                     g_elementPropertyModifying = true;
 
-                    auto& propertyCustomizationStates =
-                        elementCustomizationStateForVisualStateGroup
-                            ->propertyCustomizationStates;
-
                     PCWSTR fallbackClassNamePtr =
                         fallbackClassNameStr.empty()
                             ? nullptr
@@ -14133,7 +14378,9 @@ void ApplyCustomizationsForVisualStateGroup(
                     for (const auto& [property, valuesPerVisualState] :
                          propertyOverrides) {
                         auto& propertyCustomizationState =
-                            propertyCustomizationStates.at(property);
+                            *FindPropertyCustomizationState(
+                                *elementCustomizationStateForVisualStateGroup,
+                                property);
 
                         auto newState = e.NewState();
                         auto newStateName =
@@ -14313,6 +14560,8 @@ bool IsTaskbarTopLevelWindow(HWND hWnd) {
 // TaskbarFrame and SystemTrayFrame rects so the empty areas become both
 // invisible and click-through.
 void UpdateClickThroughRegion(ClickThroughTaskbarState& state) {
+    ScopedTrace scopedTrace(TraceCategory::kUpdateClickThroughRegion);
+
     auto taskbarFrame = state.taskbarFrame.get();
     if (!taskbarFrame) {
         Wh_Log(L"No live TaskbarFrame");
@@ -14802,6 +15051,8 @@ void MergeResourceVariables();
 void ApplyCustomizations(InstanceHandle handle,
                          FrameworkElement element,
                          PCWSTR fallbackClassName) {
+    ScopedTrace scopedTrace(TraceCategory::kApplyCustomizations);
+
     // Merge resource dictionary on first element add. Merging it earlier on
     // window creation doesn't work, perhaps merged dictionaries are reset
     // during initialization.
@@ -14850,6 +15101,8 @@ void ApplyCustomizations(InstanceHandle handle,
     elementCustomizationState.element = element;
     elementCustomizationState.xamlRoot = state->xamlRoot;
     elementCustomizationState.perVisualStateGroup.clear();
+    elementCustomizationState.perVisualStateGroup.reserve(
+        resolved.overridesPerVSG.size());
 
     // Elements that neither capture nor consume a variable pay nothing. The
     // rest get their spine now that the element has been matched; if it isn't
@@ -15033,7 +15286,7 @@ std::optional<StyleConstant> ParseStyleConstant(
 }
 
 StyleConstants LoadStyleConstants(
-    const std::vector<PCWSTR>& themeStyleConstants) {
+    std::initializer_list<PCWSTR> themeStyleConstants) {
     StyleConstants result;
 
     auto addToResult = [&result](StyleConstant sc) {
@@ -15659,7 +15912,7 @@ void RefreshThemeResourceEntries() {
 
 std::vector<ResourceVariableEntry> ProcessResourceVariablesFromSettings(
     const StyleConstants& styleConstants,
-    const std::vector<PCWSTR>& themeResourceVariables) {
+    std::initializer_list<PCWSTR> themeResourceVariables) {
     std::vector<ResourceVariableEntry> resourceVariables;
 
     for (const auto& themeResourceVariable : themeResourceVariables) {
@@ -15801,119 +16054,177 @@ std::optional<bool> IsOsFeatureEnabled(UINT32 featureId) {
     return std::nullopt;
 }
 
+// FNV-1a hash of a theme name, used to pick the selected theme with a single
+// switch instead of comparing against each theme name in turn.
+constexpr UINT64 ThemeNameHash(std::wstring_view name) {
+    UINT64 hash = 14695981039346656037ULL;
+    for (WCHAR c : name) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
 void ProcessAllStylesFromSettings() {
     PCWSTR themeName = Wh_GetStringSetting(L"theme");
     const Theme* theme = nullptr;
-    if (wcscmp(themeName, L"TranslucentTaskbar") == 0) {
-        theme = &g_themeTranslucentTaskbar;
-    } else if (wcscmp(themeName, L"DockLike") == 0) {
-        theme = &g_themeDockLike;
-    } else if (wcscmp(themeName, L"SimplyTransparent") == 0) {
-        theme = &g_themeSimplyTransparent;
-    } else if (wcscmp(themeName, L"Squircle") == 0) {
-        // Weather widget on the right.
-        // https://www.reddit.com/r/Windows11/comments/1dnew8x/my_weather_widget_is_on_the_right_side/
-        constexpr UINT32 kExtendedModeAEPForTaskbar = 48660958;
-        theme = IsOsFeatureEnabled(kExtendedModeAEPForTaskbar).value_or(false)
+    switch (ThemeNameHash(themeName)) {
+        case ThemeNameHash(L"TranslucentTaskbar"):
+            theme = &g_themeTranslucentTaskbar;
+            break;
+        case ThemeNameHash(L"DockLike"):
+            theme = &g_themeDockLike;
+            break;
+        case ThemeNameHash(L"SimplyTransparent"):
+            theme = &g_themeSimplyTransparent;
+            break;
+        case ThemeNameHash(L"Squircle"): {
+            // Weather widget on the right.
+            // https://www.reddit.com/r/Windows11/comments/1dnew8x/my_weather_widget_is_on_the_right_side/
+            constexpr UINT32 kExtendedModeAEPForTaskbar = 48660958;
+            theme =
+                IsOsFeatureEnabled(kExtendedModeAEPForTaskbar).value_or(false)
                     ? &g_themeSquircle_variant_WeatherOnTheRight
                     : &g_themeSquircle;
-    } else if (wcscmp(themeName, L"Matter") == 0) {
-        theme = &g_themeMatter;
-    } else if (wcscmp(themeName, L"WinXP") == 0) {
-        theme = &g_themeWinXP;
-    } else if (wcscmp(themeName, L"WinXP_variant_Zune") == 0) {
-        theme = &g_themeWinXP_variant_Zune;
-    } else if (wcscmp(themeName, L"Bubbles") == 0) {
-        theme = &g_themeBubbles;
-    } else if (wcscmp(themeName, L"RosePine") == 0) {
-        theme = &g_themeRosePine;
-    } else if (wcscmp(themeName, L"WinVista") == 0) {
-        theme = &g_themeWinVista;
-    } else if (wcscmp(themeName, L"CleanSlate") == 0) {
-        theme = &g_themeCleanSlate;
-    } else if (wcscmp(themeName, L"Lucent") == 0) {
-        theme = &g_themeLucent;
-    } else if (wcscmp(themeName, L"Lucent_variant_Light") == 0) {
-        theme = &g_themeLucent_variant_Light;
-    } else if (wcscmp(themeName, L"SunValley") == 0) {
-        theme = &g_themeSunValley;
-    } else if (wcscmp(themeName, L"21996Taskbar") == 0) {
-        theme = &g_theme21996Taskbar;
-    } else if (wcscmp(themeName, L"BottomDensy") == 0) {
-        theme = &g_themeBottomDensy;
-    } else if (wcscmp(themeName, L"BottomDensy_variant_NoInd") == 0) {
-        theme = &g_themeBottomDensy_variant_NoInd;
-    } else if (wcscmp(themeName, L"TaskbarXII") == 0) {
-        theme = &g_themeTaskbarXII;
-    } else if (wcscmp(themeName, L"xdark") == 0) {
-        theme = &g_themexdark;
-    } else if (wcscmp(themeName, L"Windows7") == 0) {
-        theme = &g_themeWindows7;
-    } else if (wcscmp(themeName, L"Aeris") == 0) {
-        theme = &g_themeAeris;
-    } else if (wcscmp(themeName, L"Plasma") == 0) {
-        theme = &g_themePlasma;
-    } else if (wcscmp(themeName, L"WindowGlass") == 0) {
-        theme = &g_themeWindowGlass;
-    } else if (wcscmp(themeName, L"WindowGlass_variant_Split") == 0) {
-        theme = &g_themeWindowGlass_variant_Split;
-    } else if (wcscmp(themeName, L"WindowGlass_variant_FullLength") == 0) {
-        theme = &g_themeWindowGlass_variant_FullLength;
-    } else if (wcscmp(themeName, L"Surface") == 0) {
-        theme = &g_themeSurface;
-    } else if (wcscmp(themeName, L"Oversimplified&Accentuated") == 0) {
-        theme = &g_themeOversimplified_Accentuated;
-    } else if (wcscmp(themeName, L"Luminosity_variant_Dock") == 0) {
-        theme = &g_themeLuminosity_variant_Dock;
-    } else if (wcscmp(themeName, L"Luminosity_variant_Classic") == 0) {
-        theme = &g_themeLuminosity_variant_Classic;
-    } else if (wcscmp(themeName, L"Luminosity_variant_Compact") == 0) {
-        theme = &g_themeLuminosity_variant_Compact;
-    } else if (wcscmp(themeName, L"LayerMicaUI") == 0) {
-        theme = &g_themeLayerMicaUI;
-    } else if (wcscmp(themeName, L"Fluid") == 0) {
-        theme = &g_themeFluid;
-    } else if (wcscmp(themeName, L"TintedGlass") == 0) {
-        theme = &g_themeTintedGlass;
-    } else if (wcscmp(themeName, L"TaskbarToStatusbar") == 0) {
-        theme = &g_themeTaskbarToStatusbar;
-    } else if (wcscmp(themeName, L"UltraWideFriendly") == 0) {
-        theme = &g_themeUltraWideFriendly;
-    } else if (wcscmp(themeName, L"LiquidGlass2") == 0) {
-        theme = &g_themeLiquidGlass2;
-    } else if (wcscmp(themeName, L"LiquidGlass") == 0) {
-        theme = &g_themeLiquidGlass;
-    } else if (wcscmp(themeName, L"LiquidGlass_variant_Alternate") == 0) {
-        theme = &g_themeLiquidGlass_variant_Alternate;
-    } else if (wcscmp(themeName, L"Borderless") == 0) {
-        theme = &g_themeBorderless;
-    } else if (wcscmp(themeName, L"Command_Center") == 0) {
-        theme = &g_themeCommand_Center;
-    } else if (wcscmp(themeName, L"FluentGlass") == 0) {
-        theme = &g_themeFluentGlass;
-    } else if (wcscmp(themeName, L"OS26_Liquid_Glass_variant_ClearMacDock") ==
-               0) {
-        theme = &g_themeOS26_Liquid_Glass;
-    } else if (wcscmp(themeName, L"OS26_Liquid_Glass_variant_ClearTaskbar") ==
-               0) {
-        theme = &g_themeOS26_Liquid_Glass_variant_1;
-    } else if (wcscmp(themeName, L"OS26_Liquid_Glass_variant_DarkMacDock") ==
-               0) {
-        theme = &g_themeOS26_Liquid_Glass_variant_2;
-    } else if (wcscmp(themeName, L"OS26_Liquid_Glass_variant_DarkTaskbar") ==
-               0) {
-        theme = &g_themeOS26_Liquid_Glass_variant_3;
-    } else if (wcscmp(themeName, L"FrostyGlass") == 0) {
-        theme = &g_themeFrostyGlass;
-    } else if (wcscmp(themeName, L"FrostedAcrylic") == 0) {
-        theme = &g_themeFrostedAcrylic;
-    } else if (wcscmp(themeName, L"Pills") == 0) {
-        theme = &g_themePills;
+            break;
+        }
+        case ThemeNameHash(L"Matter"):
+            theme = &g_themeMatter;
+            break;
+        case ThemeNameHash(L"WinXP"):
+            theme = &g_themeWinXP;
+            break;
+        case ThemeNameHash(L"WinXP_variant_Zune"):
+            theme = &g_themeWinXP_variant_Zune;
+            break;
+        case ThemeNameHash(L"Bubbles"):
+            theme = &g_themeBubbles;
+            break;
+        case ThemeNameHash(L"RosePine"):
+            theme = &g_themeRosePine;
+            break;
+        case ThemeNameHash(L"WinVista"):
+            theme = &g_themeWinVista;
+            break;
+        case ThemeNameHash(L"CleanSlate"):
+            theme = &g_themeCleanSlate;
+            break;
+        case ThemeNameHash(L"Lucent"):
+            theme = &g_themeLucent;
+            break;
+        case ThemeNameHash(L"Lucent_variant_Light"):
+            theme = &g_themeLucent_variant_Light;
+            break;
+        case ThemeNameHash(L"SunValley"):
+            theme = &g_themeSunValley;
+            break;
+        case ThemeNameHash(L"21996Taskbar"):
+            theme = &g_theme21996Taskbar;
+            break;
+        case ThemeNameHash(L"BottomDensy"):
+            theme = &g_themeBottomDensy;
+            break;
+        case ThemeNameHash(L"BottomDensy_variant_NoInd"):
+            theme = &g_themeBottomDensy_variant_NoInd;
+            break;
+        case ThemeNameHash(L"TaskbarXII"):
+            theme = &g_themeTaskbarXII;
+            break;
+        case ThemeNameHash(L"xdark"):
+            theme = &g_themexdark;
+            break;
+        case ThemeNameHash(L"Windows7"):
+            theme = &g_themeWindows7;
+            break;
+        case ThemeNameHash(L"Aeris"):
+            theme = &g_themeAeris;
+            break;
+        case ThemeNameHash(L"Plasma"):
+            theme = &g_themePlasma;
+            break;
+        case ThemeNameHash(L"WindowGlass"):
+            theme = &g_themeWindowGlass;
+            break;
+        case ThemeNameHash(L"WindowGlass_variant_Split"):
+            theme = &g_themeWindowGlass_variant_Split;
+            break;
+        case ThemeNameHash(L"WindowGlass_variant_FullLength"):
+            theme = &g_themeWindowGlass_variant_FullLength;
+            break;
+        case ThemeNameHash(L"Surface"):
+            theme = &g_themeSurface;
+            break;
+        case ThemeNameHash(L"Oversimplified&Accentuated"):
+            theme = &g_themeOversimplified_Accentuated;
+            break;
+        case ThemeNameHash(L"Luminosity_variant_Dock"):
+            theme = &g_themeLuminosity_variant_Dock;
+            break;
+        case ThemeNameHash(L"Luminosity_variant_Classic"):
+            theme = &g_themeLuminosity_variant_Classic;
+            break;
+        case ThemeNameHash(L"Luminosity_variant_Compact"):
+            theme = &g_themeLuminosity_variant_Compact;
+            break;
+        case ThemeNameHash(L"LayerMicaUI"):
+            theme = &g_themeLayerMicaUI;
+            break;
+        case ThemeNameHash(L"Fluid"):
+            theme = &g_themeFluid;
+            break;
+        case ThemeNameHash(L"TintedGlass"):
+            theme = &g_themeTintedGlass;
+            break;
+        case ThemeNameHash(L"TaskbarToStatusbar"):
+            theme = &g_themeTaskbarToStatusbar;
+            break;
+        case ThemeNameHash(L"UltraWideFriendly"):
+            theme = &g_themeUltraWideFriendly;
+            break;
+        case ThemeNameHash(L"LiquidGlass2"):
+            theme = &g_themeLiquidGlass2;
+            break;
+        case ThemeNameHash(L"LiquidGlass"):
+            theme = &g_themeLiquidGlass;
+            break;
+        case ThemeNameHash(L"LiquidGlass_variant_Alternate"):
+            theme = &g_themeLiquidGlass_variant_Alternate;
+            break;
+        case ThemeNameHash(L"Borderless"):
+            theme = &g_themeBorderless;
+            break;
+        case ThemeNameHash(L"Command_Center"):
+            theme = &g_themeCommand_Center;
+            break;
+        case ThemeNameHash(L"FluentGlass"):
+            theme = &g_themeFluentGlass;
+            break;
+        case ThemeNameHash(L"OS26_Liquid_Glass_variant_ClearMacDock"):
+            theme = &g_themeOS26_Liquid_Glass;
+            break;
+        case ThemeNameHash(L"OS26_Liquid_Glass_variant_ClearTaskbar"):
+            theme = &g_themeOS26_Liquid_Glass_variant_1;
+            break;
+        case ThemeNameHash(L"OS26_Liquid_Glass_variant_DarkMacDock"):
+            theme = &g_themeOS26_Liquid_Glass_variant_2;
+            break;
+        case ThemeNameHash(L"OS26_Liquid_Glass_variant_DarkTaskbar"):
+            theme = &g_themeOS26_Liquid_Glass_variant_3;
+            break;
+        case ThemeNameHash(L"FrostyGlass"):
+            theme = &g_themeFrostyGlass;
+            break;
+        case ThemeNameHash(L"FrostedAcrylic"):
+            theme = &g_themeFrostedAcrylic;
+            break;
+        case ThemeNameHash(L"Pills"):
+            theme = &g_themePills;
+            break;
     }
     Wh_FreeStringSetting(themeName);
 
     StyleConstants styleConstants = LoadStyleConstants(
-        theme ? theme->styleConstants : std::vector<PCWSTR>{});
+        theme ? theme->styleConstants : std::initializer_list<PCWSTR>{});
 
     if (theme) {
         for (const auto& themeTargetStyle : theme->targetStyles) {
@@ -15946,8 +16257,8 @@ void ProcessAllStylesFromSettings() {
     }
 
     g_resourceVariables = ProcessResourceVariablesFromSettings(
-        styleConstants,
-        theme ? theme->themeResourceVariables : std::vector<PCWSTR>{});
+        styleConstants, theme ? theme->themeResourceVariables
+                              : std::initializer_list<PCWSTR>{});
 }
 
 void UninitializeResourceVariables() {
@@ -16055,6 +16366,8 @@ void UninitializeForCurrentThread() {
 
     UninitializeResourceVariables();
 
+    FinishTraceForCurrentThread();
+
     g_initializedForThread = false;
 }
 
@@ -16072,6 +16385,8 @@ void InitializeForCurrentThread() {
         return;
     }
 
+    StartTraceForCurrentThread();
+
     ProcessAllStylesFromSettings();
 
     g_initializedForThread = true;
@@ -16598,6 +16913,8 @@ void LoadSettings() {
         g_settings.xamlDiagnosticsHandling = XamlDiagnosticsHandling::kAllow;
     }
     Wh_FreeStringSetting(xamlDiagnosticsHandling);
+
+    g_settings.performanceTrace = Wh_GetIntSetting(L"performanceTrace");
 }
 
 BOOL Wh_ModInit() {